@@ -0,0 +1,116 @@
+/*****************************************************************************
+*** Name      : alias.c                                                    ***
+*** Purpose   : Walker alias tables to sample a discrete distribution with ***
+***             a single uniform random value                              ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+#include <stdlib.h>
+
+#include "alias.h"
+#include "dump.h"
+
+/* --- Implementation {{{1 */
+
+AliasTable *createAliasTable(const double *p, int n) /*{{{2*/
+/*
+ * Returns a new alias table for the discrete distribution p[0..n-1], where;
+ * p = probabilities of the outcomes (need not be normalized)
+ * n = number of outcomes
+ */
+{
+    AliasTable *table = malloc(sizeof(AliasTable));
+    double *scaled = malloc(n*sizeof(double));
+    int *small = malloc(n*sizeof(int));
+    int *large = malloc(n*sizeof(int));
+    int n_small = 0;
+    int n_large = 0;
+    double sum = 0.0;
+    int i;
+
+    if (table == NULL || scaled == NULL || small == NULL || large == NULL) {
+        fatal("createAliasTable() out of memory");
+    }
+    table->n = n;
+    table->prob = malloc(n*sizeof(double));
+    table->alias = malloc(n*sizeof(int));
+    if (table->prob == NULL || table->alias == NULL) {
+        fatal("createAliasTable() out of memory");
+    }
+
+    for (i = 0; i < n; i++) {
+        sum += p[i];
+    }
+
+    /* Scale to an average of 1 per column and split in small and large */
+    for (i = 0; i < n; i++) {
+        scaled[i] = p[i] * n / sum;
+        if (scaled[i] < 1.0) {
+            small[n_small++] = i;
+        }
+        else {
+            large[n_large++] = i;
+        }
+    }
+
+    /* Fill each small column up to 1 with a large outcome */
+    while (n_small > 0 && n_large > 0) {
+        int s = small[--n_small];
+        int l = large[--n_large];
+
+        table->prob[s] = scaled[s];
+        table->alias[s] = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if (scaled[l] < 1.0) {
+            small[n_small++] = l;
+        }
+        else {
+            large[n_large++] = l;
+        }
+    }
+
+    /* What is left is 1 up to rounding errors */
+    while (n_large > 0) {
+        int l = large[--n_large];
+        table->prob[l] = 1.0;
+        table->alias[l] = l;
+    }
+    while (n_small > 0) {
+        int s = small[--n_small];
+        table->prob[s] = 1.0;
+        table->alias[s] = s;
+    }
+
+    free(scaled);
+    free(small);
+    free(large);
+
+    return table;
+} /*}}}2*/
+
+void freeAliasTable(AliasTable *table) /*{{{2*/
+{
+    if (table == NULL) return;
+    free(table->prob);
+    free(table->alias);
+    free(table);
+} /*}}}2*/
@@ -0,0 +1,69 @@
+/*****************************************************************************
+*** Name      : alias.h                                                    ***
+*** Purpose   : Walker alias tables to sample a discrete distribution with ***
+***             a single uniform random value                              ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _ALIAS_H
+#define _ALIAS_H
+
+/* --- Data types {{{1 */
+
+/*
+ * Walker alias table (built with Vose's method) for a discrete distribution
+ * over the outcomes 0..n-1. An outcome is drawn by picking a column i
+ * uniformly and returning i with probability prob[i], else alias[i]
+ */
+typedef struct {
+    /*
+     * Number of outcomes
+     */
+    int     n;
+    /*
+     * Probability to keep column i (scaled to [0,1])
+     */
+    double *prob;
+    /*
+     * Outcome to return for column i when not kept
+     */
+    int    *alias;
+} AliasTable;
+
+/* --- Interface {{{1 */
+
+AliasTable *createAliasTable(const double *p, int n);
+void freeAliasTable(AliasTable *table);
+
+static inline int sampleAliasTable(const AliasTable *table, double u) /*{{{2*/
+/*
+ * Returns an outcome index drawn from the table, where;
+ * table = alias table to draw from
+ * u = uniform random value in (0,1), its integer part (times n) selects
+ *     the column and its fraction decides between column and alias
+ */
+{
+    double x = u * table->n;
+    int i = (int)x;
+    if (i >= table->n) i = table->n-1;
+    return (x-i < table->prob[i]) ? i : table->alias[i];
+} /*}}}2*/
+
+#endif
@@ -29,13 +29,11 @@
 #include "dump.h"
 #include "stats.h"
 #include "archer.h"
+#include "format.h"
+#include "context.h"
 
 /* --- Global data {{{1 */
 
-/* 104 archers in the competition */
-Archer  archer[104];         /* Individual archer */
-Archer *archerrank[104];     /* Points to archer ranked idx+1 */
-
 int high_loser = 16;
 int cut_high_loser = 16;
 
@@ -47,24 +45,28 @@ static char winSymbol(const Archer *archer);
 
 /* --- Implementation {{{1*/
 
-void setArcher(Archer *archer, int lvl_rank, double lvl) /*{{{2*/
+void setArcher(const SimulationContext *ctx, Archer *archer, int lvl_rank, double lvl) /*{{{2*/
 {
     archer->lvl        = lvl;
     archer->lvl_rank   = lvl_rank;
     archer->lvl_score  = -1.0;
-    archer->q_score    = -1.0;
+    archer->q_score    = -1;
     archer->q_n        = 0;
     archer->q_rank     = 0;
     archer->e_rank     = 0;
 
+    /* Precompute the arrow value distributions for both formats */
+    archer->q_table    = getScoreTable(lvl, getContextFace(ctx, ctx->q_format.facetype), ctx->q_format.distance);
+    archer->e_table    = getScoreTable(lvl, getContextFace(ctx, ctx->e_format.facetype), ctx->e_format.distance);
+
     resetStat(&(archer->q_score_stat));
 } /*}}}2*/
 
-void setArchers(void) /*{{{2*/
+void setArchers(SimulationContext *ctx) /*{{{2*/
 /*
  * Setup an array of archers with different skill levels
  * linearly distributed between asl1,4,8,16,32,56 and 104
- * Returns nothing, but fills the archers array
+ * Returns nothing, but fills the archers array of the context
  */
 {
     double dlvl;
@@ -73,44 +75,65 @@ void setArchers(void) /*{{{2*/
     /* 1..4 */
     dlvl = (asl1-asl4)/3.0;
     for (i = 1; i <= 4; i++) {
-        setArcher(&(archer[i-1]), i, asl1 - (i-1)*dlvl);
+        setArcher(ctx, &(ctx->archer[i-1]), i, asl1 - (i-1)*dlvl);
     }
 
     /* 5..8 */
     dlvl = (asl4-asl8)/3.0;
     for (i = 5; i <= 8; i++) {
-        setArcher(&(archer[i-1]), i, asl4 - (i-5)*dlvl);
+        setArcher(ctx, &(ctx->archer[i-1]), i, asl4 - (i-5)*dlvl);
     }
 
     /* 9..16 */
     dlvl = (asl8-asl16)/7.0;
     for (i = 9; i <= 16; i++) {
-        setArcher(&(archer[i-1]), i, asl8 - (i-9)*dlvl);
+        setArcher(ctx, &(ctx->archer[i-1]), i, asl8 - (i-9)*dlvl);
     }
 
     /* 17..32 */
     dlvl = (asl16-asl32)/15.0;
     for(i = 17; i <= 32; i++) {
-        setArcher(&(archer[i-1]), i, asl16 - (i-17)*dlvl);
+        setArcher(ctx, &(ctx->archer[i-1]), i, asl16 - (i-17)*dlvl);
     }
 
     /* 32..56 */
     dlvl = (asl32-asl56)/23.0;
     for(i = 33; i <= 56; i++) {
-        setArcher(&(archer[i-1]), i, asl32 - (i-33)*dlvl);
+        setArcher(ctx, &(ctx->archer[i-1]), i, asl32 - (i-33)*dlvl);
     }
 
     /* 56..104 */
     dlvl = (asl56-asl104)/47.0;
     for(i = 57; i <= 104; i++) {
-        setArcher(&(archer[i-1]), i, asl56 - (i-57)*dlvl);
+        setArcher(ctx, &(ctx->archer[i-1]), i, asl56 - (i-57)*dlvl);
     }
 
+    resetArcherRanking(ctx);
+} /*}}}2*/
+
+void resetArcherRanking(SimulationContext *ctx) /*{{{2*/
+/*
+ * Sets the ranking to the skill level ranking (archerrank[i] points to
+ * archer[i]), so a run does not depend on the order left by earlier runs
+ */
+{
+    int i;
+
     for (i = 0; i < 104; i++) {
-        archerrank[i] = &(archer[i]);
+        ctx->archerrank[i] = &(ctx->archer[i]);
     }
 } /*}}}2*/
 
+void mergeArcherStats(Archer *dst, const Archer *src) /*{{{2*/
+/*
+ * Adds the qualification score statistics of an archer simulated
+ * separately (same archer, other runs) to dst
+ */
+{
+    dst->q_n += src->q_n;
+    combineStat(&(dst->q_score_stat), &(src->q_score_stat));
+} /*}}}2*/
+
 void dumpArcher(const Archer *archer) /*{{{2*/
 {
     if (archer == NULL) {
@@ -121,6 +144,18 @@ void dumpArcher(const Archer *archer) /*{{{2*/
             outp("| Qualification Rank |   | Elimination Rank | Archers Skill Level | Archers Skill Level Score | Simulated Score |    StdDev(%)  |\n");
             outp("|--------------------+---+------------------+---------------------+---------------------------+-----------------+---------------|\n");
         }
+        else if (output_format == OUTPUT_BINARY) {
+            static const TableColumn column[7] = {
+                { "q_rank",     COLUMN_INT },
+                { "lvl_rank",   COLUMN_INT },
+                { "e_rank",     COLUMN_INT },
+                { "asl",        COLUMN_DOUBLE },
+                { "asl_score",  COLUMN_DOUBLE },
+                { "score_mean", COLUMN_DOUBLE },
+                { "score_stdev",COLUMN_DOUBLE },
+            };
+            beginTable("archers", 7, column);
+        }
         else {
             outp("\"Results\"\n");
             outp("\"q-rank\";\"lvl-rank\";\"up-down\";\"e-rank\";\"asl\";\"asl-score\";\"score\";\"stdev\"\n");
@@ -133,15 +168,24 @@ void dumpArcher(const Archer *archer) /*{{{2*/
         outp("|        %3d(%3d)    | %c |       %3d        |       %6.2lf        |        %6.1lf             |      %6.1lf     | %6.3lf(%4.1lf%%) |\n",
                archer->q_rank, archer->lvl_rank,
                winSymbol(archer),
-               archer->e_rank, archer->lvl, archer->lvl_score, archer->q_score_stat.avg, archer->q_score_stat.stdev,
-               100.0*(sqrt(archer->q_score_stat.stdev)/(archer->q_score_stat.avg)));
+               archer->e_rank, archer->lvl, archer->lvl_score, getMean(&(archer->q_score_stat)), getStdev(&(archer->q_score_stat)),
+               100.0*(sqrt(getStdev(&(archer->q_score_stat)))/(getMean(&(archer->q_score_stat)))));
+    }
+    else if (output_format == OUTPUT_BINARY) {
+        tableInt(archer->q_rank);
+        tableInt(archer->lvl_rank);
+        tableInt(archer->e_rank);
+        tableDouble(archer->lvl);
+        tableDouble(archer->lvl_score);
+        tableDouble(getMean(&(archer->q_score_stat)));
+        tableDouble(getStdev(&(archer->q_score_stat)));
     }
     else {
         outp("%d;%d;\"%c\";%d;%lf;%lf;%lf;%lf\n",
                archer->q_rank, archer->lvl_rank,
                winSymbol(archer),
                archer->e_rank, archer->lvl,
-               archer->lvl_score, archer->q_score, archer->q_score_stat.stdev);
+               archer->lvl_score, SCORE_TO_DOUBLE(archer->q_score), getStdev(&(archer->q_score_stat)));
     }
 } /*}}}2*/
 
@@ -159,7 +203,7 @@ int isHighLoser(const Archer *archer)  /*{{{2*/
     return ret;
 } /*}}}2*/
 
-void rankArchersOnQualifyingRank(int from_rank, int to_rank) /*{{{2*/
+void rankArchersOnQualifyingRank(SimulationContext *ctx, int from_rank, int to_rank) /*{{{2*/
 /*
  * Rank archers on qualifying rank (q_rank)
  */
@@ -169,25 +213,26 @@ void rankArchersOnQualifyingRank(int from_rank, int to_rank) /*{{{2*/
 
     for (int i = start_idx; i <= end_idx; i++) {
         int min_idx = i;
-        int min_q_rank = archerrank[i]->q_rank;
+        int min_q_rank = ctx->archerrank[i]->q_rank;
         for (int j = i+1; j <= end_idx; j++) {
-            if (archerrank[j]->q_rank < min_q_rank) {
+            if (ctx->archerrank[j]->q_rank < min_q_rank) {
                 min_idx = j;
-                min_q_rank = archerrank[min_idx]->q_rank;;
+                min_q_rank = ctx->archerrank[min_idx]->q_rank;;
             }
         }
         if (min_idx != i) {
             /* swap */
-            Archer *tmp = archerrank[i];
-            archerrank[i] = archerrank[min_idx];
-            archerrank[min_idx] = tmp;
+            Archer *tmp = ctx->archerrank[i];
+            ctx->archerrank[i] = ctx->archerrank[min_idx];
+            ctx->archerrank[min_idx] = tmp;
         }
     }
 } /*}}}2*/
 
-void rankArchersOnQualifyingScore(int from_rank, int to_rank) /*{{{2*/
+void rankArchersOnQualifyingScore(SimulationContext *ctx, int from_rank, int to_rank) /*{{{2*/
 /*
- * Rank archers on qualifying score (q_score)
+ * Rank archers on average qualifying score (q_score_stat), i.e. over all
+ * simulated qualification rounds
  */
 {
     int start_idx = from_rank-1;
@@ -195,18 +240,18 @@ void rankArchersOnQualifyingScore(int from_rank, int to_rank) /*{{{2*/
 
     for (int i = start_idx; i <= end_idx; i++) {
         int max_idx = i;
-        double max_q_score = archerrank[max_idx]->q_score;
+        double max_q_score = getMean(&(ctx->archerrank[max_idx]->q_score_stat));
         for (int j = i+1; j <= end_idx; j++) {
-            if (archerrank[j]->q_score > max_q_score) {
+            if (getMean(&(ctx->archerrank[j]->q_score_stat)) > max_q_score) {
                 max_idx = j;
-                max_q_score = archerrank[max_idx]->q_score;
+                max_q_score = getMean(&(ctx->archerrank[max_idx]->q_score_stat));
             }
         }
         if (max_idx != i) {
             /* swap */
-            Archer *tmp = archerrank[i];
-            archerrank[i] = archerrank[max_idx];
-            archerrank[max_idx] = tmp;
+            Archer *tmp = ctx->archerrank[i];
+            ctx->archerrank[i] = ctx->archerrank[max_idx];
+            ctx->archerrank[max_idx] = tmp;
         }
     }
 } /*}}}2*/
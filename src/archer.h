@@ -26,6 +26,7 @@
 
 /* --- Includes {{{1 */
 #include "stats.h"
+#include "scoretable.h"
 
 /* --- Data types {{{1 */
 
@@ -48,9 +49,9 @@ typedef struct {
 
     /*
      * Simulated (shot) qualification score, based on the total sum of
-     * each shot for a given qualification format)
+     * each shot for a given qualification format) as fixed point Score
      */
-    double q_score;
+    Score  q_score;
 
     /*
      * Number of qualification rounds simulated for this archer
@@ -73,18 +74,22 @@ typedef struct {
      * Rank in the population after elimination round
      */
     int    e_rank;
+
+    /*
+     * Arrow value tables of the archer for the qualification format and
+     * the elimination format (shared, owned by the table cache)
+     */
+    ScoreTable *q_table;
+    ScoreTable *e_table;
 } Archer;
 
 /* --- Interface {{{1 */
 
 /*
- * An individual (simulated) archer from a pool of arches
+ * The archers and their ranking are part of the simulation (context.h)
  */
-extern Archer  archer[];
-/*
- * Defines the ranking of an Archer
- */
-extern Archer *archerrank[];
+struct SimulationContext;
+
 /*
  * The next parametsr define the skill level distribution over the population
  *
@@ -125,10 +130,12 @@ extern int high_loser;
 extern int cut_high_loser;
 extern char *name_of_population;
 
-void setArcher(Archer *archer, int lvl_rank, double lvl);
-void setArchers(void);
-void rankArchersOnQualifyingRank(int from_rank, int to_rank);
-void rankArchersOnQualifyingScore(int from_rank, int to_rank);
+void setArcher(const struct SimulationContext *ctx, Archer *archer, int lvl_rank, double lvl);
+void setArchers(struct SimulationContext *ctx);
+void resetArcherRanking(struct SimulationContext *ctx);
+void mergeArcherStats(Archer *dst, const Archer *src);
+void rankArchersOnQualifyingRank(struct SimulationContext *ctx, int from_rank, int to_rank);
+void rankArchersOnQualifyingScore(struct SimulationContext *ctx, int from_rank, int to_rank);
 void dumpArcher(const Archer *archer);
 int isHighLoser(const Archer *archer);
 int isFinalRankInQRank(int top, const Archer *archer);
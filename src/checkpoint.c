@@ -0,0 +1,136 @@
+/*****************************************************************************
+*** Name      : checkpoint.c                                               ***
+*** Purpose   : Implements the checkpoint files of long simulations        ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "dump.h"
+
+/* --- Global data {{{1 */
+
+/* Default no checkpoint */
+char *checkpoint_file = NULL;
+int resume = 0;
+
+/* --- Implementation {{{1 */
+
+long openCheckpoint(Checkpoint *cp, int kind, uint64_t study, int n_runs, int32_t record_size) /*{{{2*/
+/*
+ * Opens the checkpoint file (checkpoint_file) of a simulation and returns
+ * the number of records to resume from, where;
+ * cp = checkpoint to open
+ * kind = CHECKPOINT_COMPETITIONS or CHECKPOINT_MATRIX
+ * study = hash of what decides the outcome of the simulation
+ * n_runs = runs of the simulation
+ * record_size = bytes per record
+ * Without --resume (or when there is no checkpoint file yet) a new file is
+ * started and 0 is returned. Otherwise the caller reads the records returned
+ * from cp->fp and calls continueCheckpoint() before writing new ones. A
+ * checkpoint of another simulation is not resumed from
+ */
+{
+    CheckpointHeader header;
+    long size = 0;
+
+    cp->filename = checkpoint_file;
+    cp->record_size = record_size;
+    cp->n_records = 0;
+
+    if (resume && (cp->fp = fopen(checkpoint_file, "r+b")) != NULL) {
+        if (fread(&header, sizeof(header), 1, cp->fp) != 1 ||
+            memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != CHECKPOINT_VERSION ||
+            header.record_size != record_size) {
+            fprintf(stderr, "%s is not a checkpoint of this build\n", checkpoint_file);
+            fatal("Cannot resume from checkpoint");
+        }
+        if (header.kind != kind || header.n_runs != n_runs || header.study != study) {
+            fprintf(stderr, "%s is a checkpoint of another simulation (other options)\n", checkpoint_file);
+            fatal("Cannot resume from checkpoint");
+        }
+        if (fseek(cp->fp, 0, SEEK_END) != 0 || (size = ftell(cp->fp)) < 0 ||
+            fseek(cp->fp, sizeof(header), SEEK_SET) != 0) {
+            fatal("Cannot read checkpoint file");
+        }
+        /* A last record cut short is dropped */
+        return (size - (long)sizeof(header))/record_size;
+    }
+
+    cp->fp = fopen(checkpoint_file, "w+b");
+    if (cp->fp == NULL) {
+        fatal("Cannot open checkpoint file for writing");
+    }
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, CHECKPOINT_MAGIC);
+    header.version = CHECKPOINT_VERSION;
+    header.kind = kind;
+    header.record_size = record_size;
+    header.n_runs = n_runs;
+    header.study = study;
+    if (fwrite(&header, sizeof(header), 1, cp->fp) != 1 || fflush(cp->fp) != 0) {
+        fatal("Cannot write checkpoint file");
+    }
+    return 0;
+} /*}}}2*/
+
+void continueCheckpoint(Checkpoint *cp, long n_records) /*{{{2*/
+/*
+ * Keeps the first n_records records of a resumed checkpoint (the ones read)
+ * and appends the records written next after them
+ */
+{
+    fflush(cp->fp);
+    if (ftruncate(fileno(cp->fp), (off_t)(sizeof(CheckpointHeader) + n_records*cp->record_size)) != 0 ||
+        fseek(cp->fp, 0, SEEK_END) != 0) {
+        fatal("Cannot write checkpoint file");
+    }
+    cp->n_records = n_records;
+} /*}}}2*/
+
+void syncCheckpoint(Checkpoint *cp) /*{{{2*/
+/*
+ * Hands a record written to cp->fp to the system, so it survives the
+ * process being stopped
+ */
+{
+    if (fflush(cp->fp) != 0) {
+        fatal("Cannot write checkpoint file");
+    }
+    cp->n_records++;
+} /*}}}2*/
+
+void closeCheckpoint(Checkpoint *cp) /*{{{2*/
+/*
+ * Ends the checkpoint of a finished simulation, the file is removed
+ */
+{
+    if (fclose(cp->fp) != 0) {
+        fatal("Cannot write checkpoint file");
+    }
+    remove(cp->filename);
+    cp->fp = NULL;
+} /*}}}2*/
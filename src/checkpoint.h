@@ -0,0 +1,84 @@
+/*****************************************************************************
+*** Name      : checkpoint.h                                               ***
+*** Purpose   : Defines the checkpoint files of long simulations           ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+
+/* --- Includes {{{1 */
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* --- Data types {{{1 */
+
+/*
+ * Simulations checkpointed; what the records of a checkpoint file hold
+ */
+#define CHECKPOINT_COMPETITIONS  1  /* Blocks of competitions, in order  */
+#define CHECKPOINT_MATRIX        2  /* Tiles of an elimination matrix    */
+
+/*
+ * A checkpoint file is this header followed by the records of the finished
+ * parts (blocks, tiles) of a simulation, each record_size bytes and starting
+ * with the index of the part (int32). A record is written as soon as its
+ * part is done, so an interrupted simulation loses at most the parts it was
+ * working on. Records cut short by the interruption are dropped on resume
+ */
+#define CHECKPOINT_MAGIC   "ACSCKPT"
+#define CHECKPOINT_VERSION 1
+
+typedef struct {
+    char      magic[8];
+    int32_t   version;
+    int32_t   kind;             /* CHECKPOINT_...                       */
+    int32_t   record_size;
+    int32_t   n_runs;           /* Runs of the simulation               */
+    uint64_t  study;            /* getContextHash() (and more)          */
+} CheckpointHeader;
+
+typedef struct {
+    FILE     *fp;
+    char     *filename;
+    long      n_records;        /* Records in the file                  */
+    int32_t   record_size;
+} Checkpoint;
+
+/*
+ * Records are read from and written to fp by the simulation checkpointed
+ * (see openCheckpoint())
+ */
+
+/* --- Interface {{{1 */
+
+/*
+ * Checkpoint file (--checkpoint) and whether to continue from it (--resume)
+ */
+extern char *checkpoint_file;
+extern int resume;
+
+long openCheckpoint(Checkpoint *cp, int kind, uint64_t study, int n_runs, int32_t record_size);
+void continueCheckpoint(Checkpoint *cp, long n_records);
+void syncCheckpoint(Checkpoint *cp);
+void closeCheckpoint(Checkpoint *cp);
+
+#endif
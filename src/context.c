@@ -0,0 +1,206 @@
+/*****************************************************************************
+*** Name      : context.c                                                  ***
+*** Purpose   : Setup of the simulation context                            ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+
+/* --- Local data {{{1 */
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+static SimulationContext default_context;
+static int default_context_init = 0;
+
+/* --- Local prototypes {{{1*/
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size);
+
+/* --- Implementation {{{1*/
+
+SimulationContext *getDefaultContext(void) /*{{{2*/
+/*
+ * Returns the context of the simulation set up by the command line options
+ */
+{
+    if (!default_context_init) {
+        initSimulationContext(&default_context);
+        default_context_init = 1;
+    }
+    return &default_context;
+} /*}}}2*/
+
+void initSimulationContext(SimulationContext *ctx) /*{{{2*/
+/*
+ * Sets a context to the default formats and a (clock) seed. The arrow
+ * diameter (population dependent, see asl_distribution.h) and the options
+ * are applied by the caller before startSimulationContext()
+ */
+{
+    memset(ctx, 0, sizeof(SimulationContext));
+    ctx->q_format = default_q_format;
+    ctx->e_format = default_e_format;
+    ctx->seed = 0L;
+} /*}}}2*/
+
+void resetSimulationContext(SimulationContext *ctx) /*{{{2*/
+/*
+ * Sets a started context back to the defaults (as initSimulationContext())
+ * for the next simulation of a batch, but keeps its target faces. The score
+ * tables are cached per face, so they stay shared with the next simulation
+ * when it has the same arrow diameter
+ */
+{
+    Face face[N_FACES];
+
+    free((void*)ctx->fast_win);
+    memcpy(face, ctx->face, sizeof(face));
+    initSimulationContext(ctx);
+    memcpy(ctx->face, face, sizeof(face));
+} /*}}}2*/
+
+void startSimulationContext(SimulationContext *ctx) /*{{{2*/
+/*
+ * Prepares a context for simulation; scores the target faces for the arrow
+ * diameter (unless already done) and seeds the random stream (from the clock
+ * when no seed is given)
+ */
+{
+    if (ctx->face[0].threshold == NULL || ctx->face[0].arrow_diameter != ctx->arrow_diameter) {
+        freeFaces(ctx->face);
+        initFaces(ctx->face, ctx->arrow_diameter);
+    }
+
+    if (ctx->seed == 0L) {
+        ctx->seed = getClockSeed();
+    }
+    initRandomStream(&ctx->rs, (uint64_t)ctx->seed, 0);
+} /*}}}2*/
+
+void forkSimulationContext(SimulationContext *dst, const SimulationContext *src, uint64_t stream_id) /*{{{2*/
+/*
+ * Makes dst a copy of a started context (population, formats, faces and
+ * fast bracket table) that draws from its own random stream, where;
+ * dst = context to set up
+ * src = context to copy, its faces and fast bracket table are shared and
+ *       must outlive dst
+ * stream_id = independent stream of the seed of src to draw from
+ */
+{
+    int i;
+
+    memcpy(dst, src, sizeof(SimulationContext));
+
+    /* Rankings (when set) point into the copied arrays */
+    for (i = 0; i < 104; i++) {
+        if (src->archerrank[i] != NULL) {
+            dst->archerrank[i] = dst->archer + (src->archerrank[i] - src->archer);
+        }
+    }
+    for (i = 0; i < 16; i++) {
+        if (src->teamrank[i] != NULL) {
+            dst->teamrank[i] = dst->team + (src->teamrank[i] - src->team);
+        }
+    }
+    for (i = 0; i < 24; i++) {
+        if (src->mixedteamrank[i] != NULL) {
+            dst->mixedteamrank[i] = dst->mixedteam + (src->mixedteamrank[i] - src->mixedteam);
+        }
+    }
+
+    initRandomStream(&dst->rs, (uint64_t)dst->seed, stream_id);
+} /*}}}2*/
+
+void setContextRun(SimulationContext *ctx, uint64_t run) /*{{{2*/
+/*
+ * Keys the random stream of a context to a run; the stream of run index
+ * 'run' of the seed (counter based, so no draws are skipped to get there).
+ * A run (competition, matrix cell or skill level) then draws the same
+ * numbers whichever thread, shard or order it is simulated in
+ */
+{
+    initRandomStream(&ctx->rs, (uint64_t)ctx->seed, run);
+} /*}}}2*/
+
+uint64_t addContextHash(uint64_t hash, const void *data, size_t size) /*{{{2*/
+/*
+ * Returns a hash of getContextHash() extended with more data deciding the
+ * outcome of a simulation (e.g. the skill levels of a matrix)
+ */
+{
+    return hashBytes(hash, data, size);
+} /*}}}2*/
+
+uint64_t getContextHash(const SimulationContext *ctx) /*{{{2*/
+/*
+ * Returns a (64 bit FNV-1a) hash of what decides the outcome of a
+ * simulation of the context; the formats, arrow diameter, seed, skill levels
+ * of the archers (set by setArchers()) and the simulation options (arrow
+ * sampler, elimination and high loser options). Format names are only used
+ * for logging and not hashed
+ */
+{
+    const Format *format[2] = { &ctx->q_format, &ctx->e_format };
+    uint64_t hash = FNV_OFFSET;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        hash = hashBytes(hash, &format[i]->distance, sizeof(double));
+        hash = hashBytes(hash, &format[i]->facetype, sizeof(FaceType));
+        hash = hashBytes(hash, &format[i]->narrows, sizeof(int));
+        hash = hashBytes(hash, &format[i]->type, sizeof(MatchType));
+        hash = hashBytes(hash, &format[i]->best_of, sizeof(int));
+    }
+    hash = hashBytes(hash, &ctx->arrow_diameter, sizeof(double));
+    hash = hashBytes(hash, &ctx->seed, sizeof(long));
+    for (i = 0; i < 104; i++) {
+        hash = hashBytes(hash, &ctx->archer[i].lvl, sizeof(double));
+    }
+    hash = hashBytes(hash, &arrow_sampler, sizeof(ArrowSampler));
+    hash = hashBytes(hash, &e_exact, sizeof(int));
+    hash = hashBytes(hash, &fast_bracket, sizeof(int));
+    hash = hashBytes(hash, &high_loser, sizeof(int));
+    hash = hashBytes(hash, &cut_high_loser, sizeof(int));
+
+    return hash;
+} /*}}}2*/
+
+/* --- Internals {{{1*/
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size) /*{{{2*/
+/*
+ * Adds size bytes at data to an FNV-1a hash
+ */
+{
+    const unsigned char *p = data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ p[i])*FNV_PRIME;
+    }
+    return hash;
+} /*}}}2*/
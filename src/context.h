@@ -0,0 +1,119 @@
+/*****************************************************************************
+*** Name      : context.h                                                  ***
+*** Purpose   : Defines the simulation context (all state of a simulation) ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _CONTEXT_H
+#define _CONTEXT_H
+
+/* --- Includes {{{1 */
+
+#include "archer.h"
+#include "team.h"
+#include "mixedteam.h"
+#include "face.h"
+#include "format.h"
+#include "random.h"
+#include "qualification.h"
+#include "elimination.h"
+#include "eventlog.h"
+
+/* --- Data types {{{1 */
+
+/*
+ * All state of a simulation; the population of archers (teams), the formats
+ * shot, the random stream and the statistics gathered. Every round and match
+ * routine works on the context it is given, so independent contexts can be
+ * simulated at the same time
+ */
+typedef struct SimulationContext {
+    /*
+     * Qualification and elimination format
+     */
+    Format                   q_format;
+    Format                   e_format;
+    /*
+     * Arrow diameter (in mm) and the target faces scored for it
+     */
+    double                   arrow_diameter;
+    Face                     face[N_FACES];
+    /*
+     * Seed of the random stream (0 is seeded from the clock) and the stream
+     */
+    long                     seed;
+    RandomStream             rs;
+    /*
+     * 104 archers in the competition and the ranking (archerrank[idx]
+     * points to the archer ranked idx+1)
+     */
+    Archer                   archer[104];
+    Archer                  *archerrank[104];
+    /*
+     * Teams and mixed-teams in the competition and their ranking
+     */
+    Team                     team[16];
+    Team                    *teamrank[16];
+    MixedTeam                mixedteam[24];
+    MixedTeam               *mixedteamrank[24];
+    /*
+     * Statistics gathered
+     */
+    QualificationStatistics  qstats;
+    EliminationStatistics    elimstats;
+    /*
+     * Per pair of archers (indices into archer[]) the cumulative probabilities
+     * that the first wins without shoot-off, wins (with or without shoot-off)
+     * and does not lose without shoot-off (see initFastBracket()), or NULL.
+     * The table is read only and shared by the forks of the context
+     */
+    const double           (*fast_win)[104][3];
+    /*
+     * Matches of doEliminationRound() are added to events when not NULL
+     * (--event-log)
+     */
+    MatchEvents             *events;
+    /*
+     * Arrows shot in elimination matches (for the progress report)
+     */
+    long                     n_arrows;
+} SimulationContext;
+
+/* --- Interface {{{1 */
+
+SimulationContext *getDefaultContext(void);
+void initSimulationContext(SimulationContext *ctx);
+void resetSimulationContext(SimulationContext *ctx);
+void startSimulationContext(SimulationContext *ctx);
+void forkSimulationContext(SimulationContext *dst, const SimulationContext *src, uint64_t stream_id);
+void setContextRun(SimulationContext *ctx, uint64_t run);
+uint64_t getContextHash(const SimulationContext *ctx);
+uint64_t addContextHash(uint64_t hash, const void *data, size_t size);
+
+static inline const Face *getContextFace(const SimulationContext *ctx, FaceType type) /*{{{2*/
+/*
+ * Returns the target face of the given type scored for the arrow diameter
+ * of the context
+ */
+{
+    return &ctx->face[type];
+} /*}}}2*/
+
+#endif
@@ -27,15 +27,83 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "dump.h"
 
+/* --- Local data types {{{1 */
+
+#define OUTPUT_BUFFER_SIZE (1<<20)
+#define MAX_TABLE_COLUMNS  64
+#define TABLE_MAGIC        "ACSTAB1\n"
+
+/*
+ * Result table being filled (binary output), its rows are kept until the
+ * table ends, as the header holds the number of rows
+ */
+typedef struct {
+    int          active;
+    char        *name;
+    int          n_columns;
+    TableColumn  column[MAX_TABLE_COLUMNS];
+    int          next;          /* Column of the next value       */
+    uint64_t     n_rows;
+    char        *rows;
+    size_t       size;          /* Allocated and used rows bytes  */
+    size_t       used;
+} Table;
+
+/*
+ * Writer thread (--async-output); outp() fills one buffer while the thread
+ * writes the other, pending is the buffer handed over and not yet written
+ */
+typedef struct {
+    int              running;
+    int              stop;
+    pthread_t        thread;
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    const char      *pending;
+    size_t           size;
+} AsyncOutput;
+
 /* --- Local data {{{1 */
 
-static FILE *fp = NULL;
+OutputFormat output_format = OUTPUT_CSV;
+int async_output = 0;
+
+/* Output to stdout unless another writer is set */
+static OutputWriter writer = { NULL, NULL, NULL };
+static int          buffered = 1;
+static int          magic_written = 0;
+static int          flush_at_exit = 0;
+
+/* Output not yet handed to the writer, buffer is one of buffers */
+static char   buffers[2][OUTPUT_BUFFER_SIZE];
+static char  *buffer = buffers[0];
+static size_t used = 0;
+
+static Table table;
+
+static AsyncOutput async = { 0, 0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0 };
 
 /* --- Local prototypes {{{1 */
 
+static void startOutput(void);
+static void submitOutput(void);
+static void waitOutput(void);
+static void startAsyncOutput(void);
+static void stopAsyncOutput(void);
+static void *runAsyncOutput(void *arg);
+static void flushAtExit(void);
+static void outputBytes(const void *data, size_t size);
+static void endTable(void);
+static void addTableValue(ColumnType type, const void *value);
+static void writeFile(void *handle, const void *data, size_t size);
+static void closeFile(void *handle);
+
 /* --- Global functions {{{1 */
 
 void interactiveOutput() /*{{{2*/
@@ -47,40 +115,173 @@ void interactiveOutput() /*{{{2*/
     if (len > 1) {
         /* Replace '\n' with '\0' */
         filename[len-1] = '\0';
-        fp = fopen(filename, "w");
+        FILE *fp = fopen(filename, "w");
         if (fp == NULL) {
             fprintf(stderr, "Cannot open file %s for writing\n", filename);
         }
+        else {
+            OutputWriter file = { fp, writeFile, closeFile };
+            setOutputWriter(&file, 1);
+        }
     }
 } /*}}}2*/
 
 void getOutput(const char *filename, const char *mode) /*{{{2*/
 {
-    fp = fopen(filename, mode);
-    if (fp == NULL) {
+    OutputWriter file;
+
+    if (openFileWriter(&file, filename, mode) != 0) {
         fprintf(stderr, "Cannot open file %s for writing\n", filename);
         exit(0);
     }
+    setOutputWriter(&file, 1);
+} /*}}}2*/
+
+int openFileWriter(OutputWriter *file, const char *filename, const char *mode) /*{{{2*/
+/*
+ * Sets up a writer to a file opened with fopen() mode 'mode', returns 0 (or
+ * -1 when the file cannot be opened). Write errors are fatal
+ */
+{
+    file->handle = fopen(filename, mode);
+    file->write = writeFile;
+    file->close = closeFile;
+    return (file->handle == NULL) ? -1 : 0;
+} /*}}}2*/
+
+void setOutputWriter(const OutputWriter *new_writer, int new_buffered) /*{{{2*/
+/*
+ * Closes the current output and continues on another writer, where;
+ * new_writer = destination of the output
+ * new_buffered = 0 to hand every outp() to the writer at once (terminals)
+ * With async_output, buffered output is written by a writer thread
+ */
+{
+    outp_close();
+    writer = *new_writer;
+    buffered = new_buffered;
+    if (!flush_at_exit) {
+        atexit(flushAtExit);
+        flush_at_exit = 1;
+    }
+    if (async_output && buffered) {
+        startAsyncOutput();
+    }
 } /*}}}2*/
 
 void outp(const char *fmt, ...) /*{{{2*/
+/*
+ * Formats text (or CSV) output into the output buffer, the buffer goes to
+ * the writer when full. Binary output only holds tables, text is skipped
+ */
 {
     va_list ap;
+    size_t n;
+
+    if (output_format == OUTPUT_BINARY) return;
+    if (table.active) endTable();
+    if (writer.write == NULL) startOutput();
 
     va_start(ap, fmt);
-    if (fp == NULL) {
-        /* To stdout */
-        vprintf(fmt, ap);
-    }
-    else {
-        vfprintf(fp, fmt, ap);
-    }
+    n = (size_t)vsnprintf(buffer+used, OUTPUT_BUFFER_SIZE-used, fmt, ap);
     va_end(ap);
+
+    if (n >= OUTPUT_BUFFER_SIZE-used) {
+        /* Did not fit, hand the buffer over and format again */
+        submitOutput();
+        if (n < OUTPUT_BUFFER_SIZE) {
+            va_start(ap, fmt);
+            vsnprintf(buffer, OUTPUT_BUFFER_SIZE, fmt, ap);
+            va_end(ap);
+        }
+        else {
+            char *text = malloc(n+1);
+
+            if (text == NULL) {
+                fatal("outp() out of memory");
+            }
+            va_start(ap, fmt);
+            vsnprintf(text, n+1, fmt, ap);
+            va_end(ap);
+            outputBytes(text, n);
+            free(text);
+            n = 0;
+        }
+    }
+    used += n;
+
+    if (!buffered) outp_flush();
+} /*}}}2*/
+
+void outp_flush() /*{{{2*/
+/*
+ * Writes the buffered output, returns when the writer has it
+ */
+{
+    submitOutput();
+    waitOutput();
 } /*}}}2*/
 
 void outp_close() /*{{{2*/
+/*
+ * Ends the output; flushes it and closes the writer, further output goes
+ * to stdout
+ */
 {
-    if (fp != NULL) fclose(fp);
+    if (table.active) endTable();
+    outp_flush();
+    stopAsyncOutput();
+    if (writer.close != NULL) {
+        writer.close(writer.handle);
+    }
+    writer.handle = NULL;
+    writer.write = NULL;
+    writer.close = NULL;
+    buffered = 1;
+    magic_written = 0;
+} /*}}}2*/
+
+void beginTable(const char *name, int n_columns, const TableColumn *columns) /*{{{2*/
+/*
+ * Starts a result table of the binary output (nothing happens for text and
+ * CSV output), the table ends with the next table, text or closing of the
+ * output, where;
+ * name = name of the table
+ * n_columns = number of columns
+ * columns = name and type of the columns, the rows are filled with
+ *           tableInt() and tableDouble() in column order
+ */
+{
+    int i;
+
+    if (output_format != OUTPUT_BINARY) return;
+    if (table.active) endTable();
+    if (n_columns > MAX_TABLE_COLUMNS) {
+        fatal("beginTable() too many columns");
+    }
+
+    table.active = 1;
+    table.name = strdup(name);
+    table.n_columns = n_columns;
+    for (i = 0; i < n_columns; i++) {
+        table.column[i].name = strdup(columns[i].name);
+        table.column[i].type = columns[i].type;
+    }
+    table.next = 0;
+    table.n_rows = 0;
+    table.used = 0;
+} /*}}}2*/
+
+void tableInt(long value) /*{{{2*/
+{
+    int64_t v = value;
+
+    addTableValue(COLUMN_INT, &v);
+} /*}}}2*/
+
+void tableDouble(double value) /*{{{2*/
+{
+    addTableValue(COLUMN_DOUBLE, &value);
 } /*}}}2*/
 
 void fatal(const char *str) /*{{{2*/
@@ -89,3 +290,219 @@ void fatal(const char *str) /*{{{2*/
     exit(1);
 }
 
+/* --- Local functions {{{1 */
+
+static void startOutput(void) /*{{{2*/
+/*
+ * Starts output to stdout, buffered unless it is a terminal
+ */
+{
+    OutputWriter out = { NULL, writeFile, NULL };
+
+    out.handle = stdout;
+    setOutputWriter(&out, !isatty(STDOUT_FILENO));
+} /*}}}2*/
+
+static void submitOutput(void) /*{{{2*/
+/*
+ * Hands the buffered output to the writer; to the writer thread (waiting
+ * for it to finish the previous buffer) and continues in the other buffer,
+ * or written directly without a writer thread
+ */
+{
+    size_t n = used;
+
+    if (n == 0) return;
+
+    /* Emptied first, a failing writer does not get it again at exit */
+    used = 0;
+    if (!async.running) {
+        writer.write(writer.handle, buffer, n);
+        return;
+    }
+
+    pthread_mutex_lock(&async.lock);
+    while (async.pending != NULL) {
+        pthread_cond_wait(&async.cond, &async.lock);
+    }
+    async.pending = buffer;
+    async.size = n;
+    pthread_cond_broadcast(&async.cond);
+    pthread_mutex_unlock(&async.lock);
+
+    buffer = (buffer == buffers[0]) ? buffers[1] : buffers[0];
+} /*}}}2*/
+
+static void waitOutput(void) /*{{{2*/
+/*
+ * Waits for the writer thread to write the buffer handed over
+ */
+{
+    if (!async.running) return;
+
+    pthread_mutex_lock(&async.lock);
+    while (async.pending != NULL) {
+        pthread_cond_wait(&async.cond, &async.lock);
+    }
+    pthread_mutex_unlock(&async.lock);
+} /*}}}2*/
+
+static void startAsyncOutput(void) /*{{{2*/
+{
+    async.stop = 0;
+    async.pending = NULL;
+    if (pthread_create(&async.thread, NULL, runAsyncOutput, NULL) != 0) {
+        fatal("Cannot create output thread");
+    }
+    async.running = 1;
+} /*}}}2*/
+
+static void stopAsyncOutput(void) /*{{{2*/
+/*
+ * Ends the writer thread after it has written all handed over output
+ */
+{
+    if (!async.running) return;
+
+    pthread_mutex_lock(&async.lock);
+    async.stop = 1;
+    pthread_cond_broadcast(&async.cond);
+    pthread_mutex_unlock(&async.lock);
+
+    pthread_join(async.thread, NULL);
+    async.running = 0;
+} /*}}}2*/
+
+static void *runAsyncOutput(void *arg) /*{{{2*/
+/*
+ * Writer thread, writes the buffers handed over until stopped
+ */
+{
+    pthread_mutex_lock(&async.lock);
+    for (;;) {
+        while (async.pending == NULL && !async.stop) {
+            pthread_cond_wait(&async.cond, &async.lock);
+        }
+        if (async.pending == NULL) break;
+
+        pthread_mutex_unlock(&async.lock);
+        writer.write(writer.handle, async.pending, async.size);
+        pthread_mutex_lock(&async.lock);
+
+        async.pending = NULL;
+        pthread_cond_broadcast(&async.cond);
+    }
+    pthread_mutex_unlock(&async.lock);
+
+    return arg;
+} /*}}}2*/
+
+static void flushAtExit(void) /*{{{2*/
+/*
+ * Writes pending output at exit (unless the writer thread itself exits on a
+ * write error)
+ */
+{
+    if (async.running && pthread_equal(pthread_self(), async.thread)) return;
+
+    outp_flush();
+    stopAsyncOutput();
+} /*}}}2*/
+
+static void outputBytes(const void *data, size_t size) /*{{{2*/
+/*
+ * Adds raw bytes to the output
+ */
+{
+    if (writer.write == NULL) startOutput();
+
+    if (used + size > OUTPUT_BUFFER_SIZE) {
+        submitOutput();
+        if (size > OUTPUT_BUFFER_SIZE) {
+            /* Larger than the buffer, straight to the writer */
+            waitOutput();
+            writer.write(writer.handle, data, size);
+            return;
+        }
+    }
+    memcpy(buffer+used, data, size);
+    used += size;
+} /*}}}2*/
+
+static void endTable(void) /*{{{2*/
+/*
+ * Writes the table being filled (header and rows) to the output
+ */
+{
+    uint32_t len, n, type;
+    int i;
+
+    if (table.next != 0) {
+        fatal("endTable() incomplete row");
+    }
+    table.active = 0;
+
+    if (!magic_written) {
+        outputBytes(TABLE_MAGIC, strlen(TABLE_MAGIC));
+        magic_written = 1;
+    }
+
+    len = (uint32_t)strlen(table.name);
+    outputBytes(&len, sizeof(uint32_t));
+    outputBytes(table.name, len);
+    n = (uint32_t)table.n_columns;
+    outputBytes(&n, sizeof(uint32_t));
+    for (i = 0; i < table.n_columns; i++) {
+        len = (uint32_t)strlen(table.column[i].name);
+        type = (uint32_t)table.column[i].type;
+        outputBytes(&len, sizeof(uint32_t));
+        outputBytes(table.column[i].name, len);
+        outputBytes(&type, sizeof(uint32_t));
+        free((char *)table.column[i].name);
+    }
+    outputBytes(&table.n_rows, sizeof(uint64_t));
+    outputBytes(table.rows, table.used);
+
+    free(table.name);
+    if (!buffered) outp_flush();
+} /*}}}2*/
+
+static void addTableValue(ColumnType type, const void *value) /*{{{2*/
+/*
+ * Adds the next value (8 bytes) of the current row of the table
+ */
+{
+    if (output_format != OUTPUT_BINARY) return;
+    if (!table.active || table.column[table.next].type != type) {
+        fatal("Table value does not match its column");
+    }
+
+    if (table.used + 8 > table.size) {
+        table.size = (table.size == 0) ? 4096 : 2*table.size;
+        table.rows = realloc(table.rows, table.size);
+        if (table.rows == NULL) {
+            fatal("addTableValue() out of memory");
+        }
+    }
+    memcpy(table.rows+table.used, value, 8);
+    table.used += 8;
+
+    if (++table.next == table.n_columns) {
+        table.next = 0;
+        table.n_rows++;
+    }
+} /*}}}2*/
+
+static void writeFile(void *handle, const void *data, size_t size) /*{{{2*/
+{
+    if (fwrite(data, 1, size, (FILE *)handle) != size) {
+        fatal("Cannot write output");
+    }
+} /*}}}2*/
+
+static void closeFile(void *handle) /*{{{2*/
+{
+    if (fclose((FILE *)handle) != 0) {
+        fatal("Cannot write output");
+    }
+} /*}}}2*/
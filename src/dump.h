@@ -12,12 +12,71 @@
 
 #include <stdio.h>
 
+/* --- Data types {{{1 */
+
+/*
+ * Format of the results (--output-format). Text and CSV are written with
+ * outp() (pretty_print selects between them), binary holds the result tables
+ * only (beginTable()), text is left out
+ */
+typedef enum {
+    OUTPUT_TEXT   = 0,
+    OUTPUT_CSV    = 1,
+    OUTPUT_BINARY = 2,
+} OutputFormat;
+
+/*
+ * Destination of the output; write() gets the buffered output in large
+ * chunks, close() is called when the output is closed (may be NULL)
+ */
+typedef struct {
+    void   *handle;
+    void  (*write)(void *handle, const void *data, size_t size);
+    void  (*close)(void *handle);
+} OutputWriter;
+
+/*
+ * Column of a result table. The binary format is;
+ *
+ *   output  = "ACSTAB1\n" table*       (appended outputs repeat the magic)
+ *   table   = name_len:u32 name n_columns:u32 column* n_rows:u64 row*
+ *   column  = name_len:u32 name type:u32
+ *   row     = a value of 8 bytes per column; int64 (COLUMN_INT) or
+ *             double (COLUMN_DOUBLE)
+ *
+ * in the byte order of the machine, so the rows of a table can be mapped
+ * as an array of fixed width records
+ */
+typedef enum {
+    COLUMN_INT    = 0,
+    COLUMN_DOUBLE = 1,
+} ColumnType;
+
+typedef struct {
+    const char *name;
+    ColumnType  type;
+} TableColumn;
+
 /* --- Interface {{{1 */
 
+extern OutputFormat output_format;
+
+/*
+ * Write buffered output on a writer thread (--async-output), so the
+ * simulation does not wait for a slow output
+ */
+extern int async_output;
+
 void getOutput(const char *filename, const char *mode);
+void setOutputWriter(const OutputWriter *writer, int buffered);
+int openFileWriter(OutputWriter *file, const char *filename, const char *mode);
 void interactiveOutput();
 void outp(const char *fmt, ...);
+void outp_flush();
 void outp_close();
+void beginTable(const char *name, int n_columns, const TableColumn *columns);
+void tableInt(long value);
+void tableDouble(double value);
 void fatal(const char *str);
 
 #endif
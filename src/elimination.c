@@ -24,7 +24,10 @@
 /* --- Includes {{{1 */
 
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "archer.h"
 #include "dump.h"
@@ -32,8 +35,14 @@
 #include "team.h"
 #include "score.h"
 #include "elimination.h"
+#include "exact.h"
+#include "context.h"
 #include "qualification.h"
 #include "format.h"
+#include "random.h"
+#include "pool.h"
+#include "checkpoint.h"
+#include "progress.h"
 
 #include "debug.h"
 
@@ -55,12 +64,20 @@ extern double xt1asl2;
 extern double xt2asl1;
 extern double xt2asl2;
 
-extern QualificationStatistics qstats;
-
-EliminationStatistics elimstats;
+extern int shard;
+extern int n_shards;
+extern char *partial_out;
+extern char **merge_files;
+extern int n_merge_files;
 
 int e_nruns = 1000;
 
+/* Compute the elimination matrix exactly instead of by simulation */
+int e_exact = 0;
+
+/* Decide the matches of doEliminationRound() from precomputed win probabilities */
+int fast_bracket = 0;
+
 typedef struct {
     long n_win_with_lower_score[MAX_STAGES];
     long n_win_with_equal_score_no_so[MAX_STAGES];
@@ -71,47 +88,237 @@ typedef struct {
     long n_top_q16_e16;
     long n_top_q8_e8;
     long n_top_q4_e4;
+    /* Set points, sets shot and match score of the last match (event log) */
+    int   left_points;
+    int   right_points;
+    int   n_sets;
+    Score left_score;
+    Score right_score;
 } Counters;
 
+/* Kind of competitors in an elimination matrix */
+#define MATRIX_INDIVIDUAL   0
+#define MATRIX_TEAM         1
+#define MATRIX_MIXED_TEAM   2
+
+/* Tiles of the elimination matrix handed to the pool are MATRIX_TILE x MATRIX_TILE cells */
+#define MATRIX_TILE 4
+
+/*
+ * Outcome of the e_nruns matches of a cell (left ASL vs right ASL) of an
+ * elimination matrix
+ */
+typedef struct {
+    int left_wins;
+    int left_wins_shootoff;
+    int right_wins;
+    int right_wins_shootoff;
+} MatrixCell;
+
+typedef struct {
+    /* Context set up by the options and a copy per worker */
+    SimulationContext  *ctx;
+    SimulationContext **worker;
+    /* Kind of competitors */
+    int                 kind;
+    /* Number of skill levels (start_asl..end_asl) and the levels */
+    int                 n;
+    double             *asl;
+    /*
+     * Set when the right competitor is made like the left one, so a cell
+     * (j,i) is the mirror of cell (i,j) and only i <= j is simulated
+     */
+    int                 symmetric;
+    /* Tiles (row and column of tile) to simulate */
+    int                 n_tiles;
+    /* Tiles of the whole matrix and the slice of them of this shard (--shard) */
+    int                 n_all_tiles;
+    int                 first_tile;
+    int                 last_tile;
+    int                *tile_row;
+    int                *tile_col;
+    /* n x n cells, cell (i,j) is left asl[i] vs right asl[j] */
+    MatrixCell         *cell;
+    /* Tiles per row (and column), a tile is known as row*n_blocks+column */
+    int                 n_blocks;
+    /* Checkpoint (--checkpoint) the finished tiles are written to */
+    Checkpoint          checkpoint;
+    pthread_mutex_t     lock;
+} EliminationMatrix;
+
+/*
+ * Record of a finished tile in the checkpoint file, the cells of the tile
+ * row by row (cells outside the matrix or not simulated are 0)
+ */
+typedef struct {
+    int32_t     tile;
+    MatrixCell  cell[MATRIX_TILE*MATRIX_TILE];
+} MatrixTileRecord;
+
+/*
+ * Header of a partial results file (--partial-out) of an elimination matrix,
+ * followed by the records of tiles first_tile up to last_tile (in the order
+ * of computeEliminationMatrix()). Like the partial results of
+ * --competitions, it is merged (--merge) by the same build only
+ */
+#define MATRIX_PARTIAL_MAGIC   "ACSMTRX"
+#define MATRIX_PARTIAL_VERSION 1
+
+typedef struct {
+    char        magic[8];
+    int32_t     version;
+    int32_t     record_size;    /* sizeof(MatrixTileRecord)          */
+    int32_t     shard;          /* Shard (1..n_shards)               */
+    int32_t     n_shards;
+    int32_t     kind;           /* MATRIX_INDIVIDUAL, ..             */
+    int32_t     n;              /* Skill levels (cells per row)      */
+    int32_t     n_runs;         /* e_nruns                           */
+    int32_t     n_tiles;        /* Tiles of the whole matrix         */
+    int32_t     first_tile;     /* Tiles in the file                 */
+    int32_t     last_tile;
+    uint64_t    study;          /* getMatrixStudy()                  */
+} MatrixPartialHeader;
+
 /* --- Local function prototypes {{{1 */
 
-static Result doMatch(const Face*, Archer*, Archer*, int, Counters*);
-static Result doTeamMatch(Team*, Team*, int, Counters*);
-static Result doMixedTeamMatch(MixedTeam*, MixedTeam*, int, Counters*);
-static Result doSetMatch(Archer*, Archer*, int, Counters*);
-static Result doCumulativeMatch(Archer*, Archer*, int, Counters*);
-static Result doShootOff(const Face*, Archer*, Archer*, int, Counters*);
-static Result doRandomMatch(Archer*, Archer*, int, Counters*);
-static Result doSetTeamMatch(Team*, Team*, int, Counters*);
-static Result doCumulativeTeamMatch(Team*, Team*, int, Counters*);
-static Result doTeamShootOff(Team*, Team*, int, Counters*);
-static Result doTeamRandomMatch(Team*, Team*, int, Counters*);
-static Result doSetMixedTeamMatch(MixedTeam*, MixedTeam*, int, Counters*);
-static Result doCumulativeMixedTeamMatch(MixedTeam*, MixedTeam*, int, Counters*);
-static Result doMixedTeamShootOff(MixedTeam*, MixedTeam*, int, Counters*);
-static Result doMixedTeamRandomMatch(MixedTeam*, MixedTeam*, int, Counters*);
-static double getFinalRankingCorrectness(void);
+static Result doMatch(SimulationContext*, const Face*, Archer*, Archer*, int, Counters*);
+static Result doBracketMatch(SimulationContext*, const Face*, Archer*, Archer*, int, Counters*);
+static Result doFastMatch(SimulationContext*, Archer*, Archer*, int, Counters*);
+static void setMatchScore(Counters*, int, int, int, Score, Score);
+static Result doTeamMatch(SimulationContext*, Team*, Team*, int, Counters*);
+static Result doMixedTeamMatch(SimulationContext*, MixedTeam*, MixedTeam*, int, Counters*);
+static Result doSetMatch(SimulationContext*, Archer*, Archer*, int, Counters*);
+static Result doCumulativeMatch(SimulationContext*, Archer*, Archer*, int, Counters*);
+static Result doShootOff(SimulationContext*, const Face*, Archer*, Archer*, int, Counters*);
+static Result doRandomMatch(SimulationContext*, Archer*, Archer*, int, Counters*);
+static Result doSetTeamMatch(SimulationContext*, Team*, Team*, int, Counters*);
+static Result doCumulativeTeamMatch(SimulationContext*, Team*, Team*, int, Counters*);
+static Result doTeamShootOff(SimulationContext*, Team*, Team*, int, Counters*);
+static Result doTeamRandomMatch(SimulationContext*, Team*, Team*, int, Counters*);
+static Result doSetMixedTeamMatch(SimulationContext*, MixedTeam*, MixedTeam*, int, Counters*);
+static Result doCumulativeMixedTeamMatch(SimulationContext*, MixedTeam*, MixedTeam*, int, Counters*);
+static Result doMixedTeamShootOff(SimulationContext*, MixedTeam*, MixedTeam*, int, Counters*);
+static Result doMixedTeamRandomMatch(SimulationContext*, MixedTeam*, MixedTeam*, int, Counters*);
+static double getFinalRankingCorrectness(SimulationContext*);
+static void computeExactEliminationStats(SimulationContext*);
+static void printExactMatrix(const SimulationContext*, const char*, const ExactMatch*, int, int);
+static double getExactValue(const ExactMatch*, int);
+static int computeEliminationMatrix(SimulationContext*, int, EliminationMatrix*);
+static uint64_t getMatrixStudy(const EliminationMatrix*);
+static void freeEliminationMatrix(EliminationMatrix*);
+static void doMatrixTile(void*, int, int);
+static long getMatrixCells(const EliminationMatrix*, int);
+static int resumeEliminationMatrix(EliminationMatrix*);
+static void writeMatrixTile(EliminationMatrix*, int, int);
+static void getMatrixTileRecord(const EliminationMatrix*, int, int, MatrixTileRecord*);
+static void setMatrixTileRecord(EliminationMatrix*, const MatrixTileRecord*);
+static void writeMatrixPartial(const EliminationMatrix*);
+static void mergeEliminationMatrix(EliminationMatrix*);
+static void readMatrixPartialFile(EliminationMatrix*, const char*, uint64_t, char*);
+static void doMatrixCell(SimulationContext*, EliminationMatrix*, int, int);
+static MatrixCell getMatrixCell(const EliminationMatrix*, int, int);
+static void dumpEliminationTables(const SimulationContext*);
+static void beginMatrixTable(const char*, int);
+static void addMatrixRow(const double*, const double*, int, MatrixCell);
 
 /* --- Implementation {{{1*/
 
-void initEliminationStats() /*{{{2*/
+void initEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
     int i;
     int s;
 
-    elimstats.n_competitions = 0;
+    ctx->elimstats.n_competitions = 0;
     for (s = 0; s < MAX_STAGES; s++) {
-        elimstats.n_matches[s] = 0L;
+        ctx->elimstats.n_matches[s] = 0L;
+        for (i = 0; i < MAX_SETS; i++) {
+            resetStat(&(ctx->elimstats.n_win_after_sets[i][s]));
+        }
+        resetStat(&(ctx->elimstats.n_win_after_shootoff[s]));
+        resetStat(&(ctx->elimstats.n_win_with_lower_score[s]));
+        resetStat(&(ctx->elimstats.n_win_with_equal_score_no_so[s]));
+        resetStat(&(ctx->elimstats.n_expected_wins[s]));
+        resetStat(&(ctx->elimstats.n_second_shootoff_required[s]));
+    }
+    resetStat(&(ctx->elimstats.n_top_q4_e4));
+    resetStat(&(ctx->elimstats.n_top_q8_e8));
+    resetStat(&(ctx->elimstats.n_top_q16_e16));
+    resetStat(&(ctx->elimstats.fc));
+} /*}}}2*/
+
+void mergeEliminationStats(EliminationStatistics *d, const EliminationStatistics *s) /*{{{2*/
+/*
+ * Adds the elimination statistics of separately simulated competitions to
+ * another, where;
+ * d = statistics to add to
+ * s = statistics to add
+ */
+{
+    int i;
+    int st;
+
+    d->n_competitions += s->n_competitions;
+    for (st = 0; st < MAX_STAGES; st++) {
+        d->n_matches[st] += s->n_matches[st];
         for (i = 0; i < MAX_SETS; i++) {
-            resetStat(&(elimstats.n_win_after_sets[i][s]));
+            combineStat(&(d->n_win_after_sets[i][st]), &(s->n_win_after_sets[i][st]));
         }
-        resetStat(&(elimstats.n_win_after_shootoff[s]));
-        resetStat(&(elimstats.n_win_with_lower_score[s]));
-        resetStat(&(elimstats.n_win_with_equal_score_no_so[s]));
+        combineStat(&(d->n_win_after_shootoff[st]), &(s->n_win_after_shootoff[st]));
+        combineStat(&(d->n_win_with_equal_score_no_so[st]), &(s->n_win_with_equal_score_no_so[st]));
+        combineStat(&(d->n_win_with_lower_score[st]), &(s->n_win_with_lower_score[st]));
+        combineStat(&(d->n_expected_wins[st]), &(s->n_expected_wins[st]));
+        combineStat(&(d->n_second_shootoff_required[st]), &(s->n_second_shootoff_required[st]));
     }
+    combineStat(&(d->n_top_q4_e4), &(s->n_top_q4_e4));
+    combineStat(&(d->n_top_q8_e8), &(s->n_top_q8_e8));
+    combineStat(&(d->n_top_q16_e16), &(s->n_top_q16_e16));
+    combineStat(&(d->fc), &(s->fc));
 } /*}}}2*/
 
-void doEliminationRound(void) /*{{{2*/
+void initFastBracket(SimulationContext *ctx) /*{{{2*/
+/*
+ * Precomputes the match outcome probabilities of every pair of archers for
+ * the elimination format (exactly, see exact.c). Must be called after
+ * setArchers(); the skill levels do not change between competitions, so with
+ * fast_bracket each match of doEliminationRound() is then decided by a single
+ * uniform (doFastMatch()). The table is allocated once per context and
+ * shared by its forks
+ */
+{
+    double (*fast_win)[104][3] = (double (*)[104][3])ctx->fast_win;
+    ExactMatch match;
+    int i, j;
+
+    if (fast_win == NULL) {
+        fast_win = malloc(104*sizeof(*fast_win));
+        if (fast_win == NULL) {
+            fatal("initFastBracket() out of memory");
+        }
+        ctx->fast_win = (const double (*)[104][3])fast_win;
+    }
+
+    for (i = 0; i < 104; i++) {
+        for (j = i; j < 104; j++) {
+            double left;
+            double right;
+
+            computeExactMatch(ctx, ctx->archer[i].lvl, ctx->archer[j].lvl, &ctx->e_format, &match);
+            left = match.p_left_wins - match.p_left_wins_shootoff;
+            right = 1.0 - match.p_shootoff - left;
+
+            fast_win[i][j][0] = left;
+            fast_win[i][j][1] = match.p_left_wins;
+            fast_win[i][j][2] = left + match.p_shootoff;
+
+            /* Same match seen from the other side */
+            fast_win[j][i][0] = right;
+            fast_win[j][i][1] = 1.0 - match.p_left_wins;
+            fast_win[j][i][2] = right + match.p_shootoff;
+        }
+    }
+} /*}}}2*/
+
+void doEliminationRound(SimulationContext *ctx) /*{{{2*/
 /*
  * Performs a simulation of an elimination round from 1/48th to gold for the
  * current set of archers with top 8 rules and shootoff rules, etc.
@@ -124,8 +331,9 @@ void doEliminationRound(void) /*{{{2*/
     int opponent_idx;
     Archer *me;
     Archer *opponent;
-    const Face *face = getFace(e_format.facetype);
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
     Counters counters = {0};
+    Result result;
 
     /* 1/48
      * In 1/48 elimination round pairs are created without top 8
@@ -141,10 +349,10 @@ void doEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = archerrank[me_idx];
-        opponent = archerrank[opponent_idx];
+        me = ctx->archerrank[me_idx];
+        opponent = ctx->archerrank[opponent_idx];
 
-        switch (doMatch(face, me, opponent, F48TH, &counters)) {
+        switch (doBracketMatch(ctx, face, me, opponent, F48TH, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -165,8 +373,8 @@ void doEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[F48TH]++;
 
             /* Switch places in array */
-            archerrank[me_idx] = opponent;
-            archerrank[opponent_idx] = me;
+            ctx->archerrank[me_idx] = opponent;
+            ctx->archerrank[opponent_idx] = me;
             break;
 
         default:
@@ -174,7 +382,7 @@ void doEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 57 onwards on Q score */
-    rankArchersOnQualifyingRank(57, 104);
+    rankArchersOnQualifyingRank(ctx, 57, 104);
 
     /* 1/24
      * In 1/24 elimination round pairs are created without top 8
@@ -190,10 +398,10 @@ void doEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = archerrank[me_idx];
-        opponent = archerrank[opponent_idx];
+        me = ctx->archerrank[me_idx];
+        opponent = ctx->archerrank[opponent_idx];
 
-        switch (doMatch(face, me, opponent, F24TH, &counters)) {
+        switch (doBracketMatch(ctx, face, me, opponent, F24TH, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -214,8 +422,8 @@ void doEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[F24TH]++;
 
             /* Switch places in array */
-            archerrank[me_idx] = opponent;
-            archerrank[opponent_idx] = me;
+            ctx->archerrank[me_idx] = opponent;
+            ctx->archerrank[opponent_idx] = me;
             break;
 
         default:
@@ -223,7 +431,7 @@ void doEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 33 to 56 on Q score */
-    rankArchersOnQualifyingRank(33, 56);
+    rankArchersOnQualifyingRank(ctx, 33, 56);
 
     /* 1/16
      * In 1/16 elimination round pairs are created including top 8
@@ -239,10 +447,10 @@ void doEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = archerrank[me_idx];
-        opponent = archerrank[opponent_idx];
+        me = ctx->archerrank[me_idx];
+        opponent = ctx->archerrank[opponent_idx];
 
-        switch (doMatch(face, me, opponent, F16TH, &counters)) {
+        switch (doBracketMatch(ctx, face, me, opponent, F16TH, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -263,8 +471,8 @@ void doEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[F16TH]++;
 
             /* Switch places in array */
-            archerrank[me_idx] = opponent;
-            archerrank[opponent_idx] = me;
+            ctx->archerrank[me_idx] = opponent;
+            ctx->archerrank[opponent_idx] = me;
             break;
 
         default:
@@ -272,12 +480,12 @@ void doEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 17 to 32 on Q score */
-    rankArchersOnQualifyingRank(17, 32);
+    rankArchersOnQualifyingRank(ctx, 17, 32);
 
     /* Count archers that qualified top 16 and are now in last 16 */
     for (me_rank = 1; me_rank <= 16; me_rank++) {
         me_idx = me_rank-1;
-        me = archerrank[me_idx];
+        me = ctx->archerrank[me_idx];
         if (me->q_rank <= 16) counters.n_top_q16_e16++;
     }
 
@@ -295,10 +503,10 @@ void doEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = archerrank[me_idx];
-        opponent = archerrank[opponent_idx];
+        me = ctx->archerrank[me_idx];
+        opponent = ctx->archerrank[opponent_idx];
 
-        switch (doMatch(face, me, opponent, F8TH, &counters)) {
+        switch (doBracketMatch(ctx, face, me, opponent, F8TH, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -319,8 +527,8 @@ void doEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[F8TH]++;
 
             /* Switch places in array */
-            archerrank[me_idx] = opponent;
-            archerrank[opponent_idx] = me;
+            ctx->archerrank[me_idx] = opponent;
+            ctx->archerrank[opponent_idx] = me;
             break;
 
         default:
@@ -328,12 +536,12 @@ void doEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 9 to 16 on Q score */
-    rankArchersOnQualifyingRank(9, 16);
+    rankArchersOnQualifyingRank(ctx, 9, 16);
 
     /* Count archers that qualified in top 8 and are now in last 8 */
     for (me_rank = 1; me_rank <= 8; me_rank++) {
         me_idx = me_rank-1;
-        me = archerrank[me_idx];
+        me = ctx->archerrank[me_idx];
         if (me->q_rank <= 8) counters.n_top_q8_e8++;
     }
 
@@ -351,10 +559,10 @@ void doEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = archerrank[me_idx];
-        opponent = archerrank[opponent_idx];
+        me = ctx->archerrank[me_idx];
+        opponent = ctx->archerrank[opponent_idx];
 
-        switch (doMatch(face, me, opponent, F4TH, &counters)) {
+        switch (doBracketMatch(ctx, face, me, opponent, F4TH, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -375,8 +583,8 @@ void doEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[F4TH]++;
 
             /* Switch places in array */
-            archerrank[me_idx] = opponent;
-            archerrank[opponent_idx] = me;
+            ctx->archerrank[me_idx] = opponent;
+            ctx->archerrank[opponent_idx] = me;
             break;
 
         default:
@@ -384,12 +592,12 @@ void doEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 5 to 8 on Q score */
-    rankArchersOnQualifyingRank(5, 8);
+    rankArchersOnQualifyingRank(ctx, 5, 8);
 
     /* Count archers that qualified top 4 and are now in last 4 */
     for (me_rank = 1; me_rank <= 4; me_rank++) {
         me_idx = me_rank-1;
-        me = archerrank[me_idx];
+        me = ctx->archerrank[me_idx];
         if (me->q_rank <= 4) counters.n_top_q4_e4++;
     }
 
@@ -406,10 +614,10 @@ void doEliminationRound(void) /*{{{2*/
         opponent_idx = opponent_rank-1;
 
         /* Indices into arrays */
-        me = archerrank[me_idx];
-        opponent = archerrank[opponent_idx];
+        me = ctx->archerrank[me_idx];
+        opponent = ctx->archerrank[opponent_idx];
 
-        switch (doMatch(face, me, opponent, FSEMI, &counters)) {
+        switch (doBracketMatch(ctx, face, me, opponent, FSEMI, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -430,8 +638,8 @@ void doEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[FSEMI]++;
 
             /* Switch places in arrays */
-            archerrank[me_idx] = opponent;
-            archerrank[opponent_idx] = me;
+            ctx->archerrank[me_idx] = opponent;
+            ctx->archerrank[opponent_idx] = me;
             break;
 
         default:
@@ -446,10 +654,14 @@ void doEliminationRound(void) /*{{{2*/
     me_idx = me_rank-1;
     opponent_idx = opponent_rank-1;
 
-    me = archerrank[me_idx];
-    opponent = archerrank[opponent_idx];
+    me = ctx->archerrank[me_idx];
+    opponent = ctx->archerrank[opponent_idx];
 
-    switch (doMatch(face, me, opponent, FBRONZE, &counters)) {
+    result = doBracketMatch(ctx, face, me, opponent, FBRONZE, &counters);
+    if (ctx->events != NULL) {
+        ctx->events->event[ctx->events->n_events-1].flags |= EVENT_BRONZE;
+    }
+    switch (result) {
     case LEFT_WINS:
     case LEFT_WINS_SHOOTOFF:
 
@@ -470,8 +682,8 @@ void doEliminationRound(void) /*{{{2*/
         if (opponent->q_rank < me->q_rank) counters.n_expected_wins[FBRONZE]++;
 
         /* Switch places */
-        archerrank[me_idx] = opponent;
-        archerrank[opponent_idx] = me;
+        ctx->archerrank[me_idx] = opponent;
+        ctx->archerrank[opponent_idx] = me;
         break;
 
     default:
@@ -485,10 +697,10 @@ void doEliminationRound(void) /*{{{2*/
     me_idx = me_rank-1;
     opponent_idx = opponent_rank-1;
 
-    me = archerrank[me_idx];
-    opponent = archerrank[opponent_idx];
+    me = ctx->archerrank[me_idx];
+    opponent = ctx->archerrank[opponent_idx];
 
-    switch (doMatch(face, me, opponent, FGOLD, &counters)) {
+    switch (doBracketMatch(ctx, face, me, opponent, FGOLD, &counters)) {
     case LEFT_WINS:
     case LEFT_WINS_SHOOTOFF:
 
@@ -509,8 +721,8 @@ void doEliminationRound(void) /*{{{2*/
         if (opponent->q_rank < me->q_rank) counters.n_expected_wins[FGOLD]++;
 
         /* Switch places */
-        archerrank[me_idx] = opponent;
-        archerrank[opponent_idx] = me;
+        ctx->archerrank[me_idx] = opponent;
+        ctx->archerrank[opponent_idx] = me;
         break;
 
     default:
@@ -521,31 +733,31 @@ void doEliminationRound(void) /*{{{2*/
      * Now that the final ranking is known, set the elimination rank
      */
     for (i = 0; i < 104; i++) {
-        archerrank[i]->e_rank = (i+1);
+        ctx->archerrank[i]->e_rank = (i+1);
     }
 
     /* Add all counters to the overall statistics */
     for (int stage = 0; stage < MAX_STAGES; stage++) {
-        addStat(&(elimstats.n_expected_wins[stage]), counters.n_expected_wins[stage]);
-        addStat(&(elimstats.n_win_with_lower_score[stage]), counters.n_win_with_lower_score[stage]);
-        addStat(&(elimstats.n_win_with_equal_score_no_so[stage]), counters.n_win_with_equal_score_no_so[stage]);
-        addStat(&(elimstats.n_win_after_shootoff[stage]), counters.n_win_after_shootoff[stage]);
-        addStat(&(elimstats.n_second_shootoff_required[stage]), counters.n_second_shootoff_required[stage]);
+        addStat(&(ctx->elimstats.n_expected_wins[stage]), counters.n_expected_wins[stage]);
+        addStat(&(ctx->elimstats.n_win_with_lower_score[stage]), counters.n_win_with_lower_score[stage]);
+        addStat(&(ctx->elimstats.n_win_with_equal_score_no_so[stage]), counters.n_win_with_equal_score_no_so[stage]);
+        addStat(&(ctx->elimstats.n_win_after_shootoff[stage]), counters.n_win_after_shootoff[stage]);
+        addStat(&(ctx->elimstats.n_second_shootoff_required[stage]), counters.n_second_shootoff_required[stage]);
         for (int set = 0; set < MAX_SETS; set++) {
-            addStat(&(elimstats.n_win_after_sets[set][stage]), counters.n_win_after_sets[set][stage]);
+            addStat(&(ctx->elimstats.n_win_after_sets[set][stage]), counters.n_win_after_sets[set][stage]);
         }
     }
 
-    addStat(&(elimstats.n_top_q16_e16), counters.n_top_q16_e16);
-    addStat(&(elimstats.n_top_q8_e8), counters.n_top_q8_e8);
-    addStat(&(elimstats.n_top_q4_e4), counters.n_top_q4_e4);
+    addStat(&(ctx->elimstats.n_top_q16_e16), counters.n_top_q16_e16);
+    addStat(&(ctx->elimstats.n_top_q8_e8), counters.n_top_q8_e8);
+    addStat(&(ctx->elimstats.n_top_q4_e4), counters.n_top_q4_e4);
 
-    addStat(&(elimstats.fc), getFinalRankingCorrectness());
+    addStat(&(ctx->elimstats.fc), getFinalRankingCorrectness(ctx));
 
-    elimstats.n_competitions += 1;
+    ctx->elimstats.n_competitions += 1;
 } /*}}}2*/
 
-void doTeamEliminationRound(void) /*{{{2*/
+void doTeamEliminationRound(SimulationContext *ctx) /*{{{2*/
 /*
  * Performs a simulation of a team elimination round from 1/8th to gold for the
  * current set of teams with team shootoff rules, etc.
@@ -567,10 +779,10 @@ void doTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = teamrank[me_idx];
-        opponent = teamrank[opponent_idx];
+        me = ctx->teamrank[me_idx];
+        opponent = ctx->teamrank[opponent_idx];
 
-        switch (doTeamMatch(me, opponent, F8TH, &counters)) {
+        switch (doTeamMatch(ctx, me, opponent, F8TH, &counters)) {
 
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
@@ -580,8 +792,8 @@ void doTeamEliminationRound(void) /*{{{2*/
         case RIGHT_WINS:
         case RIGHT_WINS_SHOOTOFF:
             /* Switch places */
-            teamrank[me_idx] = opponent;
-            teamrank[opponent_idx] = me;
+            ctx->teamrank[me_idx] = opponent;
+            ctx->teamrank[opponent_idx] = me;
             break;
 
         default:
@@ -589,7 +801,7 @@ void doTeamEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 9 to 16 on Q score */
-    rankTeams(9, 16);
+    rankTeams(ctx, 9, 16);
 
     /* 1/4 */
     for (me_rank = 1; me_rank <= 4; me_rank++) {
@@ -598,10 +810,10 @@ void doTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = teamrank[me_idx];
-        opponent = teamrank[opponent_idx];
+        me = ctx->teamrank[me_idx];
+        opponent = ctx->teamrank[opponent_idx];
 
-        switch (doTeamMatch(me, opponent, F4TH, &counters)) {
+        switch (doTeamMatch(ctx, me, opponent, F4TH, &counters)) {
 
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
@@ -611,8 +823,8 @@ void doTeamEliminationRound(void) /*{{{2*/
         case RIGHT_WINS:
         case RIGHT_WINS_SHOOTOFF:
             /* Switch places */
-            teamrank[me_idx] = opponent;
-            teamrank[opponent_idx] = me;
+            ctx->teamrank[me_idx] = opponent;
+            ctx->teamrank[opponent_idx] = me;
             break;
 
         default:
@@ -620,7 +832,7 @@ void doTeamEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 5 to 8 on Q score */
-    rankTeams(5, 8);
+    rankTeams(ctx, 5, 8);
 
     /* 1/2 */
     for (me_rank = 1; me_rank <= 2; me_rank++) {
@@ -629,10 +841,10 @@ void doTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = teamrank[me_idx];
-        opponent = teamrank[opponent_idx];
+        me = ctx->teamrank[me_idx];
+        opponent = ctx->teamrank[opponent_idx];
 
-        switch (doTeamMatch(me, opponent, FSEMI, &counters)) {
+        switch (doTeamMatch(ctx, me, opponent, FSEMI, &counters)) {
 
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
@@ -642,8 +854,8 @@ void doTeamEliminationRound(void) /*{{{2*/
         case RIGHT_WINS:
         case RIGHT_WINS_SHOOTOFF:
             /* Switch places */
-            teamrank[me_idx] = opponent;
-            teamrank[opponent_idx] = me;
+            ctx->teamrank[me_idx] = opponent;
+            ctx->teamrank[opponent_idx] = me;
             break;
 
         default:
@@ -658,10 +870,10 @@ void doTeamEliminationRound(void) /*{{{2*/
     me_idx = me_rank-1;
     opponent_idx = opponent_rank-1;
 
-    me = teamrank[me_idx];
-    opponent = teamrank[opponent_idx];
+    me = ctx->teamrank[me_idx];
+    opponent = ctx->teamrank[opponent_idx];
 
-    switch (doTeamMatch(me, opponent, FBRONZE, &counters)) {
+    switch (doTeamMatch(ctx, me, opponent, FBRONZE, &counters)) {
 
     case LEFT_WINS:
     case LEFT_WINS_SHOOTOFF:
@@ -671,8 +883,8 @@ void doTeamEliminationRound(void) /*{{{2*/
     case RIGHT_WINS:
     case RIGHT_WINS_SHOOTOFF:
         /* Switch places */
-        teamrank[me_idx] = opponent;
-        teamrank[opponent_idx] = me;
+        ctx->teamrank[me_idx] = opponent;
+        ctx->teamrank[opponent_idx] = me;
         break;
 
     default:
@@ -686,10 +898,10 @@ void doTeamEliminationRound(void) /*{{{2*/
     me_idx = me_rank-1;
     opponent_idx = opponent_rank-1;
 
-    me = teamrank[me_idx];
-    opponent = teamrank[opponent_idx];
+    me = ctx->teamrank[me_idx];
+    opponent = ctx->teamrank[opponent_idx];
 
-    switch (doTeamMatch(me, opponent, FGOLD, &counters)) {
+    switch (doTeamMatch(ctx, me, opponent, FGOLD, &counters)) {
 
     case LEFT_WINS:
     case LEFT_WINS_SHOOTOFF:
@@ -699,8 +911,8 @@ void doTeamEliminationRound(void) /*{{{2*/
     case RIGHT_WINS:
     case RIGHT_WINS_SHOOTOFF:
         /* Switch places */
-        teamrank[me_idx] = opponent;
-        teamrank[opponent_idx] = me;
+        ctx->teamrank[me_idx] = opponent;
+        ctx->teamrank[opponent_idx] = me;
         break;
 
     default:
@@ -708,11 +920,11 @@ void doTeamEliminationRound(void) /*{{{2*/
     }
 
     for (i = 0; i < 16; i++) {
-        teamrank[i]->e_rank = (i+1);
+        ctx->teamrank[i]->e_rank = (i+1);
     }
 } /*}}}2*/
 
-void doMixedTeamEliminationRound(void) /*{{{2*/
+void doMixedTeamEliminationRound(SimulationContext *ctx) /*{{{2*/
 /*
  * Performs a simulation of a mixed-team elimination round from 1/24 to gold for the
  * current set of mixed-teams with team shootoff rules, etc.
@@ -742,10 +954,10 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = mixedteamrank[me_idx];
-        opponent = mixedteamrank[opponent_idx];
+        me = ctx->mixedteamrank[me_idx];
+        opponent = ctx->mixedteamrank[opponent_idx];
 
-        switch (doMixedTeamMatch(me, opponent, F24TH, &counters)) {
+        switch (doMixedTeamMatch(ctx, me, opponent, F24TH, &counters)) {
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
 
@@ -766,8 +978,8 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
             if (opponent->q_rank < me->q_rank) counters.n_expected_wins[F24TH]++;
 
             /* Switch places in array */
-            mixedteamrank[me_idx] = opponent;
-            mixedteamrank[opponent_idx] = me;
+            ctx->mixedteamrank[me_idx] = opponent;
+            ctx->mixedteamrank[opponent_idx] = me;
             break;
 
         default:
@@ -775,7 +987,7 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 17 to 24 on Q score */
-    rankMixedTeams(17, 24);
+    rankMixedTeams(ctx, 17, 24);
 
     /* 1/8
      * In 1/8 elimination round pairs are created
@@ -790,10 +1002,10 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = mixedteamrank[me_idx];
-        opponent = mixedteamrank[opponent_idx];
+        me = ctx->mixedteamrank[me_idx];
+        opponent = ctx->mixedteamrank[opponent_idx];
 
-        switch (doMixedTeamMatch(me, opponent, F8TH, &counters)) {
+        switch (doMixedTeamMatch(ctx, me, opponent, F8TH, &counters)) {
 
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
@@ -803,8 +1015,8 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         case RIGHT_WINS:
         case RIGHT_WINS_SHOOTOFF:
             /* Switch places */
-            mixedteamrank[me_idx] = opponent;
-            mixedteamrank[opponent_idx] = me;
+            ctx->mixedteamrank[me_idx] = opponent;
+            ctx->mixedteamrank[opponent_idx] = me;
             break;
 
         default:
@@ -812,7 +1024,7 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 9 to 16 on Q score */
-    rankMixedTeams(9, 16);
+    rankMixedTeams(ctx, 9, 16);
 
     /* 1/4
      * In 1/4 elimination round pairs are created
@@ -827,10 +1039,10 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = mixedteamrank[me_idx];
-        opponent = mixedteamrank[opponent_idx];
+        me = ctx->mixedteamrank[me_idx];
+        opponent = ctx->mixedteamrank[opponent_idx];
 
-        switch (doMixedTeamMatch(me, opponent, F4TH, &counters)) {
+        switch (doMixedTeamMatch(ctx, me, opponent, F4TH, &counters)) {
 
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
@@ -840,8 +1052,8 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         case RIGHT_WINS:
         case RIGHT_WINS_SHOOTOFF:
             /* Switch places */
-            mixedteamrank[me_idx] = opponent;
-            mixedteamrank[opponent_idx] = me;
+            ctx->mixedteamrank[me_idx] = opponent;
+            ctx->mixedteamrank[opponent_idx] = me;
             break;
 
         default:
@@ -849,7 +1061,7 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         }
     }
     /* Sort everyone from rank 5 to 8 on Q score */
-    rankTeams(5, 8);
+    rankTeams(ctx, 5, 8);
 
     /* 1/2
      * In 1/2 elimination round pairs are created
@@ -863,10 +1075,10 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         me_idx = me_rank-1;
         opponent_idx = opponent_rank-1;
 
-        me = mixedteamrank[me_idx];
-        opponent = mixedteamrank[opponent_idx];
+        me = ctx->mixedteamrank[me_idx];
+        opponent = ctx->mixedteamrank[opponent_idx];
 
-        switch (doMixedTeamMatch(me, opponent, FSEMI, &counters)) {
+        switch (doMixedTeamMatch(ctx, me, opponent, FSEMI, &counters)) {
 
         case LEFT_WINS:
         case LEFT_WINS_SHOOTOFF:
@@ -876,8 +1088,8 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
         case RIGHT_WINS:
         case RIGHT_WINS_SHOOTOFF:
             /* Switch places */
-            mixedteamrank[me_idx] = opponent;
-            mixedteamrank[opponent_idx] = me;
+            ctx->mixedteamrank[me_idx] = opponent;
+            ctx->mixedteamrank[opponent_idx] = me;
             break;
 
         default:
@@ -892,10 +1104,10 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
     me_idx = me_rank-1;
     opponent_idx = opponent_rank-1;
 
-    me = mixedteamrank[me_idx];
-    opponent = mixedteamrank[opponent_idx];
+    me = ctx->mixedteamrank[me_idx];
+    opponent = ctx->mixedteamrank[opponent_idx];
 
-    switch (doMixedTeamMatch(me, opponent, FBRONZE, &counters)) {
+    switch (doMixedTeamMatch(ctx, me, opponent, FBRONZE, &counters)) {
 
     case LEFT_WINS:
     case LEFT_WINS_SHOOTOFF:
@@ -905,8 +1117,8 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
     case RIGHT_WINS:
     case RIGHT_WINS_SHOOTOFF:
         /* Switch places */
-        mixedteamrank[me_idx] = opponent;
-        mixedteamrank[opponent_idx] = me;
+        ctx->mixedteamrank[me_idx] = opponent;
+        ctx->mixedteamrank[opponent_idx] = me;
         break;
 
     default:
@@ -920,10 +1132,10 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
     me_idx = me_rank-1;
     opponent_idx = opponent_rank-1;
 
-    me = mixedteamrank[me_idx];
-    opponent = mixedteamrank[opponent_idx];
+    me = ctx->mixedteamrank[me_idx];
+    opponent = ctx->mixedteamrank[opponent_idx];
 
-    switch (doMixedTeamMatch(me, opponent, FGOLD, &counters)) {
+    switch (doMixedTeamMatch(ctx, me, opponent, FGOLD, &counters)) {
 
     case LEFT_WINS:
     case LEFT_WINS_SHOOTOFF:
@@ -933,8 +1145,8 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
     case RIGHT_WINS:
     case RIGHT_WINS_SHOOTOFF:
         /* Switch places */
-        mixedteamrank[me_idx] = opponent;
-        mixedteamrank[opponent_idx] = me;
+        ctx->mixedteamrank[me_idx] = opponent;
+        ctx->mixedteamrank[opponent_idx] = me;
         break;
 
     default:
@@ -942,26 +1154,36 @@ void doMixedTeamEliminationRound(void) /*{{{2*/
     }
 
     for (i = 0; i < 24; i++) {
-        mixedteamrank[i]->e_rank = (i+1);
+        ctx->mixedteamrank[i]->e_rank = (i+1);
     }
 } /*}}}2*/
 
-void computeEliminationStats(void) /*{{{2*/
+void computeEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
-    const Face *face = getFace(e_format.facetype);
-    Archer left;
-    Archer right;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    EliminationMatrix matrix;
 
-    double lasl;
     double rasl;
     int n;
+    int i, j;
     double p, q, k, var;
-    Counters counters = {0};
 
-    initEliminationStats();
+    if (e_exact) {
+        computeExactEliminationStats(ctx);
+        return;
+    }
+
+    initEliminationStats(ctx);
+    if (computeEliminationMatrix(ctx, MATRIX_INDIVIDUAL, &matrix) != 0) {
+        /* A shard, its tiles are written to the partial results file */
+        freeEliminationMatrix(&matrix);
+        outp_close();
+        return;
+    }
 
+    beginMatrixTable("elimination_matrix", 1);
     if (pretty_print) {
-        outp("Format: %s\n", getFormatName(&e_format));
+        outp("Format: %s\n", getFormatName(&ctx->e_format));
         outp("N     : %d\n", e_nruns);
         outp("Archers Skill Level\n");
         /* Header */
@@ -973,7 +1195,7 @@ void computeEliminationStats(void) /*{{{2*/
         /* Header with Equiv score (72 arrows score) */
         outp("               ");
         for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
-            outp("|    %5.1lf    ", getScoreBySkillLevel(rasl, face, e_format.distance, 72));
+            outp("|    %5.1lf    ", getScoreBySkillLevel(rasl, face, ctx->e_format.distance, 72));
         }
         outp("|\n---------------");
         for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
@@ -982,7 +1204,7 @@ void computeEliminationStats(void) /*{{{2*/
         outp("+\n");
     }
     else {
-        outp("%s\n%d\n;", getFormatName(&e_format), e_nruns);
+        outp("%s\n%d\n;", getFormatName(&ctx->e_format), e_nruns);
         /* Header with ASL */
         for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
             outp(";;%lf;", rasl);
@@ -990,32 +1212,19 @@ void computeEliminationStats(void) /*{{{2*/
         outp("\n;");
         /* Header with Equiv score (72 arrows score) */
         for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
-            outp(";;%lf;", getScoreBySkillLevel(rasl, face, e_format.distance, 72));
+            outp(";;%lf;", getScoreBySkillLevel(rasl, face, ctx->e_format.distance, 72));
         }
         outp("\n");
     }
-    for (lasl = start_asl; lasl <= end_asl; lasl += step_asl) {
-        setArcher(&left, 0, lasl);
+    for (i = 0; i < matrix.n; i++) {
         if (pretty_print) {
-            outp(" %5.1lf (=%5.1lf)", left.lvl, getScoreBySkillLevel(left.lvl, face, e_format.distance, 72));
+            outp(" %5.1lf (=%5.1lf)", matrix.asl[i], getScoreBySkillLevel(matrix.asl[i], face, ctx->e_format.distance, 72));
         }
         else {
-            outp("%lf;%lf", left.lvl, getScoreBySkillLevel(left.lvl, face, e_format.distance, 72));
+            outp("%lf;%lf", matrix.asl[i], getScoreBySkillLevel(matrix.asl[i], face, ctx->e_format.distance, 72));
         }
-        for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
-            int i;
-            int left_wins = 0;
-
-            setArcher(&right, 0, rasl);
-
-            /* Perform n times an elimination round */
-            initEliminationStats();
-            for (i = 0; i < e_nruns; i++) {
-                Result result = doMatch(face, &left, &right, FGOLD, &counters);
-                if (result == LEFT_WINS || result == LEFT_WINS_SHOOTOFF) {
-                    left_wins++;
-                }
-            }
+        for (j = 0; j < matrix.n; j++) {
+            MatrixCell cell = getMatrixCell(&matrix, i, j);
 
             /*
              * If we have a binary test with n trails and k successes, the estimate of success is:
@@ -1027,7 +1236,7 @@ void computeEliminationStats(void) /*{{{2*/
              *
              * The variance describes how much a variable differs from its expected value
              */
-            k = left_wins;
+            k = cell.left_wins + cell.left_wins_shootoff;
             n = e_nruns;
             p = k / n;
             q = 1.0-p;
@@ -1036,6 +1245,9 @@ void computeEliminationStats(void) /*{{{2*/
             if (pretty_print) {
                 outp("| %5.1lf%% %4.1lf%%", 100.0*p, 100.0*var);
             }
+            else if (output_format == OUTPUT_BINARY) {
+                addMatrixRow(&matrix.asl[i], &matrix.asl[j], 1, cell);
+            }
             else {
                 outp(";%lf;%lf;%lf", p-var, p, p+var);
             }
@@ -1048,47 +1260,56 @@ void computeEliminationStats(void) /*{{{2*/
         }
     }
 
+    freeEliminationMatrix(&matrix);
+
     outp_close();
 } /*}}}2*/
 
-void computeTeamEliminationStats(void) /*{{{2*/
+void computeTeamEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
-    const int narrows = e_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
+    const int narrows = ctx->e_format.narrows;
 
-    int i;
+    int i, j;
     Team left;
     Team right;
     double lvl[3];
-    double lasl, rasl;
     double lw, lwso, rw, rwso;
-    Counters counters = {0};
+    EliminationMatrix matrix;
+
+    initEliminationStats(ctx);
+    if (computeEliminationMatrix(ctx, MATRIX_TEAM, &matrix) != 0) {
+        /* A shard, its tiles are written to the partial results file */
+        freeEliminationMatrix(&matrix);
+        outp_close();
+        return;
+    }
 
-    initEliminationStats();
+    beginMatrixTable("team_elimination_matrix", 3);
 
     if (pretty_print) {
-        outp("Format              : %s\n", getFormatName(&e_format));
+        outp("Format              : %s\n", getFormatName(&ctx->e_format));
         outp("N                   : %d\n", e_nruns);
     }
     else {
-        outp("\"%s\"\n%d\n", getFormatName(&e_format), e_nruns);
+        outp("\"%s\"\n%d\n", getFormatName(&ctx->e_format), e_nruns);
     }
 
     /* === Loop over team skills */
-    for (lasl = start_asl; lasl <= end_asl; lasl += step_asl) {
+    for (i = 0; i < matrix.n; i++) {
 
-        lvl[0] = lasl;
-        lvl[1] = lasl - (t1asl1 - t1asl2); /* Second archer is bit worse */
-        lvl[2] = lasl - (t1asl1 - t1asl3); /* Third archer is more worse */
-        setTeam(&left, lvl);
+        lvl[0] = matrix.asl[i];
+        lvl[1] = matrix.asl[i] - (t1asl1 - t1asl2); /* Second archer is bit worse */
+        lvl[2] = matrix.asl[i] - (t1asl1 - t1asl3); /* Third archer is more worse */
+        setTeam(ctx, &left, lvl);
 
-        for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
+        for (j = 0; j < matrix.n; j++) {
 
-            lvl[0] = rasl;
-            lvl[1] = rasl - (t2asl1 - t2asl2); /* Second archer is bit worse */
-            lvl[2] = rasl - (t2asl1 - t2asl3); /* Third archer is more worse */
-            setTeam(&right, lvl);
+            lvl[0] = matrix.asl[j];
+            lvl[1] = matrix.asl[j] - (t2asl1 - t2asl2); /* Second archer is bit worse */
+            lvl[2] = matrix.asl[j] - (t2asl1 - t2asl3); /* Third archer is more worse */
+            setTeam(ctx, &right, lvl);
 
             if (pretty_print) {
                 outp("Archers Skill Levels: ");
@@ -1096,24 +1317,23 @@ void computeTeamEliminationStats(void) /*{{{2*/
                        left.archer[0].lvl, left.archer[1].lvl, left.archer[2].lvl,
                        right.archer[0].lvl, right.archer[1].lvl, right.archer[2].lvl);
             }
+            else if (output_format == OUTPUT_BINARY) {
+                double llvl[3] = { left.archer[0].lvl, left.archer[1].lvl, left.archer[2].lvl };
+                double rlvl[3] = { right.archer[0].lvl, right.archer[1].lvl, right.archer[2].lvl };
+
+                addMatrixRow(llvl, rlvl, 3, getMatrixCell(&matrix, i, j));
+            }
             else {
                 outp("%5.1lf;%5.1lf;%5.1lf;%5.1lf;%5.1lf;%5.1lf",
                        left.archer[0].lvl, left.archer[1].lvl, left.archer[2].lvl,
                        right.archer[0].lvl, right.archer[1].lvl, right.archer[2].lvl);
             }
 
-            int left_wins = 0;
-            int right_wins = 0;
-            int left_wins_shootoff = 0;
-            int right_wins_shootoff = 0;
-            for (i = 0; i < e_nruns; i++) {
-                switch (doTeamMatch(&left, &right, FGOLD, &counters)) {
-                case LEFT_WINS:           left_wins++;           break;
-                case LEFT_WINS_SHOOTOFF:  left_wins_shootoff++;  break;
-                case RIGHT_WINS:          right_wins++;          break;
-                case RIGHT_WINS_SHOOTOFF: right_wins_shootoff++; break;
-                }
-            }
+            MatrixCell cell = getMatrixCell(&matrix, i, j);
+            int left_wins = cell.left_wins;
+            int right_wins = cell.right_wins;
+            int left_wins_shootoff = cell.left_wins_shootoff;
+            int right_wins_shootoff = cell.right_wins_shootoff;
 
             lw   = 1.0*(left_wins+left_wins_shootoff)/e_nruns;
             if (left_wins+left_wins_shootoff == 0) {
@@ -1141,45 +1361,54 @@ void computeTeamEliminationStats(void) /*{{{2*/
 
     /* === END loop over team skills */
 
+    freeEliminationMatrix(&matrix);
+
     outp_close();
 } /*}}}2*/
 
-void computeMixedTeamEliminationStats(void) /*{{{2*/
+void computeMixedTeamEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
-    const int narrows = e_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
+    const int narrows = ctx->e_format.narrows;
 
-    int i;
+    int i, j;
     MixedTeam left;
     MixedTeam right;
     double lvl[2];
-    double lasl, rasl;
     double lw, lwso, rw, rwso;
-    Counters counters = {0};
+    EliminationMatrix matrix;
+
+    initEliminationStats(ctx);
+    if (computeEliminationMatrix(ctx, MATRIX_MIXED_TEAM, &matrix) != 0) {
+        /* A shard, its tiles are written to the partial results file */
+        freeEliminationMatrix(&matrix);
+        outp_close();
+        return;
+    }
 
-    initEliminationStats();
+    beginMatrixTable("mixed_team_elimination_matrix", 2);
 
     if (pretty_print) {
-        outp("Format              : %s\n", getFormatName(&e_format));
+        outp("Format              : %s\n", getFormatName(&ctx->e_format));
         outp("N                   : %d\n", e_nruns);
     }
     else {
-        outp("\"%s\"\n%d\n", getFormatName(&e_format), e_nruns);
+        outp("\"%s\"\n%d\n", getFormatName(&ctx->e_format), e_nruns);
     }
 
     /* === Loop over team skills */
-    for (lasl = start_asl; lasl <= end_asl; lasl += step_asl) {
+    for (i = 0; i < matrix.n; i++) {
 
-        lvl[0] = lasl;
-        lvl[1] = lasl - (xt1asl1 - xt1asl2);
-        setMixedTeam(&left, lvl);
+        lvl[0] = matrix.asl[i];
+        lvl[1] = matrix.asl[i] - (xt1asl1 - xt1asl2);
+        setMixedTeam(ctx, &left, lvl);
 
-        for (rasl = start_asl; rasl <= end_asl; rasl += step_asl) {
+        for (j = 0; j < matrix.n; j++) {
 
-            lvl[0] = rasl;
-            lvl[1] = rasl - (xt2asl1 - xt2asl2);
-            setMixedTeam(&right, lvl);
+            lvl[0] = matrix.asl[j];
+            lvl[1] = matrix.asl[j] - (xt2asl1 - xt2asl2);
+            setMixedTeam(ctx, &right, lvl);
 
             if (pretty_print) {
                 outp("Archers Skill Levels: ");
@@ -1187,24 +1416,23 @@ void computeMixedTeamEliminationStats(void) /*{{{2*/
                        left.archer[0].lvl, left.archer[1].lvl,
                        right.archer[0].lvl, right.archer[1].lvl);
             }
+            else if (output_format == OUTPUT_BINARY) {
+                double llvl[2] = { left.archer[0].lvl, left.archer[1].lvl };
+                double rlvl[2] = { right.archer[0].lvl, right.archer[1].lvl };
+
+                addMatrixRow(llvl, rlvl, 2, getMatrixCell(&matrix, i, j));
+            }
             else {
                 outp("%5.1lf;%5.1lf;%5.1lf;%5.1lf",
                        left.archer[0].lvl, left.archer[1].lvl,
                        right.archer[0].lvl, right.archer[1].lvl);
             }
 
-            int left_wins = 0;
-            int right_wins = 0;
-            int left_wins_shootoff = 0;
-            int right_wins_shootoff = 0;
-            for (i = 0; i < e_nruns; i++) {
-                switch(doMixedTeamMatch(&left, &right, FGOLD, &counters)) {
-                case LEFT_WINS:           left_wins++;           break;
-                case LEFT_WINS_SHOOTOFF:  left_wins_shootoff++;  break;
-                case RIGHT_WINS:          right_wins++;          break;
-                case RIGHT_WINS_SHOOTOFF: right_wins_shootoff++; break;
-                }
-            }
+            MatrixCell cell = getMatrixCell(&matrix, i, j);
+            int left_wins = cell.left_wins;
+            int right_wins = cell.right_wins;
+            int left_wins_shootoff = cell.left_wins_shootoff;
+            int right_wins_shootoff = cell.right_wins_shootoff;
 
             lw   = 1.0*(left_wins+left_wins_shootoff)/e_nruns;
             if (left_wins+left_wins_shootoff == 0) {
@@ -1230,10 +1458,12 @@ void computeMixedTeamEliminationStats(void) /*{{{2*/
         }
     }
 
+    freeEliminationMatrix(&matrix);
+
     outp_close();
 } /*}}}2*/
 
-Result doMatch(const Face *face, Archer *left, Archer *right, int stage, Counters *counters) /*{{{2*/
+Result doMatch(SimulationContext *ctx, const Face *face, Archer *left, Archer *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Perform a single match between two given archers with the given format
  * left : left archer
@@ -1252,20 +1482,20 @@ Result doMatch(const Face *face, Archer *left, Archer *right, int stage, Counter
 {
     Result result;
 
-    elimstats.n_matches[stage]++;
+    ctx->elimstats.n_matches[stage]++;
 
-    switch (e_format.type) {
+    switch (ctx->e_format.type) {
     case CUMULATIVE:
-        result = doCumulativeMatch(left, right, stage, counters);
+        result = doCumulativeMatch(ctx, left, right, stage, counters);
         break;
     case SETSYSTEM:
-        result = doSetMatch(left, right, stage, counters);
+        result = doSetMatch(ctx, left, right, stage, counters);
         break;
     case SHOOTOFF:
-        result = doShootOff(face, left, right, stage, counters);
+        result = doShootOff(ctx, face, left, right, stage, counters);
         break;
     case RANDOM:
-        result = doRandomMatch(left, right, stage, counters);
+        result = doRandomMatch(ctx, left, right, stage, counters);
         break;
     default:
         outp("ERROR: doMatch()?\n");
@@ -1275,7 +1505,45 @@ Result doMatch(const Face *face, Archer *left, Archer *right, int stage, Counter
     return result;
 } /*}}}2*/
 
-Result doTeamMatch(Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
+static Result doBracketMatch(SimulationContext *ctx, const Face *face, Archer *left, Archer *right, int stage, Counters *counters) /*{{{2*/
+/*
+ * Performs a match of doEliminationRound(), simulated by doMatch() or, with
+ * fast_bracket, decided by doFastMatch()
+ */
+{
+    MatchEvent event;
+    Result result;
+
+    if (ctx->events != NULL) {
+        setMatchScore(counters, 0, 0, 0, 0, 0);
+    }
+
+    if (fast_bracket) {
+        ctx->elimstats.n_matches[stage]++;
+        result = doFastMatch(ctx, left, right, stage, counters);
+    }
+    else {
+        result = doMatch(ctx, face, left, right, stage, counters);
+    }
+
+    if (ctx->events != NULL) {
+        memset(&event, 0, sizeof(event));
+        event.stage = (uint8_t)stage;
+        event.flags = ((result == LEFT_WINS || result == LEFT_WINS_SHOOTOFF) ? EVENT_LEFT_WINS : 0) |
+                      ((result == LEFT_WINS_SHOOTOFF || result == RIGHT_WINS_SHOOTOFF) ? EVENT_SHOOTOFF : 0);
+        event.left_q_rank = (uint8_t)left->q_rank;
+        event.right_q_rank = (uint8_t)right->q_rank;
+        event.left_points = (uint8_t)counters->left_points;
+        event.right_points = (uint8_t)counters->right_points;
+        event.n_sets = (uint8_t)counters->n_sets;
+        event.left_score = counters->left_score;
+        event.right_score = counters->right_score;
+        addMatchEvent(ctx->events, &event);
+    }
+    return result;
+} /*}}}2*/
+
+Result doTeamMatch(SimulationContext *ctx, Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Perform a single match between two given teams with the given format
  * left : left team
@@ -1292,20 +1560,20 @@ Result doTeamMatch(Team *left, Team *right, int stage, Counters *counters) /*{{{
 {
     Result result;
 
-    elimstats.n_matches[stage]++;
+    ctx->elimstats.n_matches[stage]++;
 
-    switch (e_format.type) {
+    switch (ctx->e_format.type) {
     case CUMULATIVE:
-        result = doCumulativeTeamMatch(left, right, stage, counters);
+        result = doCumulativeTeamMatch(ctx, left, right, stage, counters);
         break;
     case SETSYSTEM:
-        result = doSetTeamMatch(left, right, stage, counters);
+        result = doSetTeamMatch(ctx, left, right, stage, counters);
         break;
     case SHOOTOFF:
-        result = doTeamShootOff(left, right, stage, counters);
+        result = doTeamShootOff(ctx, left, right, stage, counters);
         break;
     case RANDOM:
-        result = doTeamRandomMatch(left, right, stage, counters);
+        result = doTeamRandomMatch(ctx, left, right, stage, counters);
         break;
     default:
         outp("ERROR: doTeamMatch()?\n");
@@ -1315,7 +1583,7 @@ Result doTeamMatch(Team *left, Team *right, int stage, Counters *counters) /*{{{
     return result;
 } /*}}}2*/
 
-Result doMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
+Result doMixedTeamMatch(SimulationContext *ctx, MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Perform a single match between two given mixed teams with the given format
  * left : left mixed team
@@ -1332,20 +1600,20 @@ Result doMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage, Counters *
 {
     Result result;
 
-    elimstats.n_matches[stage]++;
+    ctx->elimstats.n_matches[stage]++;
 
-    switch (e_format.type) {
+    switch (ctx->e_format.type) {
     case CUMULATIVE:
-        result = doCumulativeMixedTeamMatch(left, right, stage, counters);
+        result = doCumulativeMixedTeamMatch(ctx, left, right, stage, counters);
         break;
     case SETSYSTEM:
-        result = doSetMixedTeamMatch(left, right, stage, counters);
+        result = doSetMixedTeamMatch(ctx, left, right, stage, counters);
         break;
     case SHOOTOFF:
-        result = doMixedTeamShootOff(left, right, stage, counters);
+        result = doMixedTeamShootOff(ctx, left, right, stage, counters);
         break;
     case RANDOM:
-        result = doMixedTeamRandomMatch(left, right, stage, counters);
+        result = doMixedTeamRandomMatch(ctx, left, right, stage, counters);
         break;
     default:
         outp("ERROR: doMixedTeamMatch()?\n");
@@ -1355,7 +1623,7 @@ Result doMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage, Counters *
     return result;
 } /*}}}2*/
 
-void dumpEliminationStats() /*{{{2*/
+void dumpEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
     Face *f;
     int i;
@@ -1363,8 +1631,8 @@ void dumpEliminationStats() /*{{{2*/
 
     if (pretty_print) {
 
-    outp("Qualification: %s\n", getFormatName(&q_format));
-    outp("Elimination  : %s\n", getFormatName(&e_format));
+    outp("Qualification: %s\n", getFormatName(&ctx->q_format));
+    outp("Elimination  : %s\n", getFormatName(&ctx->e_format));
     outp("Skill level distribution: %5.1lf %5.1lf %5.1lf %5.1lf %5.1lf %5.1lf (%s)\n",
             asl1, asl4, asl8, asl16, asl32, asl56, asl104, name_of_population);
 
@@ -1374,240 +1642,243 @@ void dumpEliminationStats() /*{{{2*/
     outp("+----------------------------+----------+----------+----------+----------+----------+----------+----------+-------------------+\n");
 
     outp("| # total simulated matches  | %8ld | %8ld | %8ld | %8ld | %8ld | %8ld | %8ld |    %8ld       |\n",
-               elimstats.n_matches[F48TH],
-               elimstats.n_matches[F24TH],
-               elimstats.n_matches[F16TH],
-               elimstats.n_matches[F8TH],
-               elimstats.n_matches[F4TH],
-               elimstats.n_matches[FSEMI],
-               elimstats.n_matches[FGOLD],
+               ctx->elimstats.n_matches[F48TH],
+               ctx->elimstats.n_matches[F24TH],
+               ctx->elimstats.n_matches[F16TH],
+               ctx->elimstats.n_matches[F8TH],
+               ctx->elimstats.n_matches[F4TH],
+               ctx->elimstats.n_matches[FSEMI],
+               ctx->elimstats.n_matches[FGOLD],
                104);
-    if (e_format.best_of > 0) {
-        for (i = 0; i < e_format.best_of; i++) {
-            sum = (elimstats.n_win_after_sets[i][F48TH].avg +
-                   elimstats.n_win_after_sets[i][F24TH].avg +
-                   elimstats.n_win_after_sets[i][F16TH].avg +
-                   elimstats.n_win_after_sets[i][F8TH].avg +
-                   elimstats.n_win_after_sets[i][F4TH].avg +
-                   elimstats.n_win_after_sets[i][FSEMI].avg +
-                   elimstats.n_win_after_sets[i][FGOLD].avg );
+    if (ctx->e_format.best_of > 0) {
+        for (i = 0; i < ctx->e_format.best_of; i++) {
+            sum = (getMean(&(ctx->elimstats.n_win_after_sets[i][F48TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F24TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F16TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F8TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F4TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][FSEMI])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][FGOLD])) );
             outp("| # avg wins after %2d sets   | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf %7.2lf%%  |\n",
                    i+1,
-                   100.0*elimstats.n_win_after_sets[i][F48TH].avg/48.0,
-                   100.0*elimstats.n_win_after_sets[i][F24TH].avg/24.0,
-                   100.0*elimstats.n_win_after_sets[i][F16TH].avg/16.0,
-                   100.0*elimstats.n_win_after_sets[i][F8TH].avg/8.0,
-                   100.0*elimstats.n_win_after_sets[i][F4TH].avg/4.0,
-                   100.0*elimstats.n_win_after_sets[i][FSEMI].avg/2.0,
-                   100.0*elimstats.n_win_after_sets[i][FGOLD].avg/2.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][F48TH]))/48.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][F24TH]))/24.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][F16TH]))/16.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][F8TH]))/8.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][F4TH]))/4.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][FSEMI]))/2.0,
+                   100.0*getMean(&(ctx->elimstats.n_win_after_sets[i][FGOLD]))/2.0,
                    sum, 100.0*sum/104.0);
         }
     }
-    sum = (elimstats.n_win_after_shootoff[F48TH].avg +
-           elimstats.n_win_after_shootoff[F24TH].avg +
-           elimstats.n_win_after_shootoff[F16TH].avg +
-           elimstats.n_win_after_shootoff[F8TH].avg +
-           elimstats.n_win_after_shootoff[F4TH].avg +
-           elimstats.n_win_after_shootoff[FSEMI].avg +
-           elimstats.n_win_after_shootoff[FGOLD].avg );
+    sum = (getMean(&(ctx->elimstats.n_win_after_shootoff[F48TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F24TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F16TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F8TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F4TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[FSEMI])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[FGOLD])) );
     outp("| # avg wins after S/O       |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf | %7.2lf %7.2lf%%  |\n",
-               elimstats.n_win_after_shootoff[F48TH].avg,
-               elimstats.n_win_after_shootoff[F24TH].avg,
-               elimstats.n_win_after_shootoff[F16TH].avg,
-               elimstats.n_win_after_shootoff[F8TH].avg,
-               elimstats.n_win_after_shootoff[F4TH].avg,
-               elimstats.n_win_after_shootoff[FSEMI].avg,
-               elimstats.n_win_after_shootoff[FGOLD].avg,
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F48TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F24TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F16TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F8TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F4TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[FSEMI])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[FGOLD])),
                sum, 100.0*sum/104.0);
-    sum = (elimstats.n_second_shootoff_required[F48TH].avg +
-           elimstats.n_second_shootoff_required[F24TH].avg +
-           elimstats.n_second_shootoff_required[F16TH].avg +
-           elimstats.n_second_shootoff_required[F8TH].avg +
-           elimstats.n_second_shootoff_required[F4TH].avg +
-           elimstats.n_second_shootoff_required[FSEMI].avg +
-           elimstats.n_second_shootoff_required[FGOLD].avg );
+    sum = (getMean(&(ctx->elimstats.n_second_shootoff_required[F48TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F24TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F16TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F8TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F4TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[FSEMI])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[FGOLD])) );
     outp("| # avg wins after D-S/O     |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf | %7.2lf %7.2lf%%  |\n",
-               elimstats.n_second_shootoff_required[F48TH].avg,
-               elimstats.n_second_shootoff_required[F24TH].avg,
-               elimstats.n_second_shootoff_required[F16TH].avg,
-               elimstats.n_second_shootoff_required[F8TH].avg,
-               elimstats.n_second_shootoff_required[F4TH].avg,
-               elimstats.n_second_shootoff_required[FSEMI].avg,
-               elimstats.n_second_shootoff_required[FGOLD].avg,
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F48TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F24TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F16TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F8TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F4TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[FSEMI])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[FGOLD])),
                sum, 100.0*sum/104.0);
-    if (e_format.best_of > 0) {
-        sum = (elimstats.n_win_with_equal_score_no_so[F48TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F24TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F16TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F8TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F4TH].avg +
-               elimstats.n_win_with_equal_score_no_so[FSEMI].avg +
-               elimstats.n_win_with_equal_score_no_so[FGOLD].avg );
+    if (ctx->e_format.best_of > 0) {
+        sum = (getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F48TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F24TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F16TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F8TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F4TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FSEMI])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FGOLD])) );
         outp("| # avg wins equal score !S/O|  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf | %7.2lf %7.2lf%%  |\n",
-                   elimstats.n_win_with_equal_score_no_so[F48TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F24TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F16TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F8TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F4TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[FSEMI].avg,
-                   elimstats.n_win_with_equal_score_no_so[FGOLD].avg,
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F48TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F24TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F16TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F8TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F4TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FSEMI])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FGOLD])),
                    sum, 100.0*sum/104.0);
-        sum = (elimstats.n_win_with_lower_score[F48TH].avg +
-               elimstats.n_win_with_lower_score[F24TH].avg +
-               elimstats.n_win_with_lower_score[F16TH].avg +
-               elimstats.n_win_with_lower_score[F8TH].avg +
-               elimstats.n_win_with_lower_score[F4TH].avg +
-               elimstats.n_win_with_lower_score[FSEMI].avg +
-               elimstats.n_win_with_lower_score[FGOLD].avg );
+        sum = (getMean(&(ctx->elimstats.n_win_with_lower_score[F48TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F24TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F16TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F8TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F4TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[FSEMI])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[FGOLD])) );
         outp("| # avg wins with lower score|  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf |  %7.2lf | %7.2lf %7.2lf%%  |\n",
-                   elimstats.n_win_with_lower_score[F48TH].avg,
-                   elimstats.n_win_with_lower_score[F24TH].avg,
-                   elimstats.n_win_with_lower_score[F16TH].avg,
-                   elimstats.n_win_with_lower_score[F8TH].avg,
-                   elimstats.n_win_with_lower_score[F4TH].avg,
-                   elimstats.n_win_with_lower_score[FSEMI].avg,
-                   elimstats.n_win_with_lower_score[FGOLD].avg,
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F48TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F24TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F16TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F8TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F4TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[FSEMI])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[FGOLD])),
                    100.0*sum/104.0);
     }
     outp("| # avg expected wins        | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf%% | %7.2lf %7.2lf%%  |\n",
-               100.0*elimstats.n_expected_wins[F48TH].avg/48.0,
-               100.0*elimstats.n_expected_wins[F24TH].avg/24.0,
-               100.0*elimstats.n_expected_wins[F16TH].avg/16.0,
-               100.0*elimstats.n_expected_wins[F8TH].avg/8.0,
-               100.0*elimstats.n_expected_wins[F4TH].avg/4.0,
-               100.0*elimstats.n_expected_wins[FSEMI].avg/2.0,
-               100.0*elimstats.n_expected_wins[FGOLD].avg/2.0);
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[F48TH]))/48.0,
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[F24TH]))/24.0,
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[F16TH]))/16.0,
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[F8TH]))/8.0,
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[F4TH]))/4.0,
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[FSEMI]))/2.0,
+               100.0*getMean(&(ctx->elimstats.n_expected_wins[FGOLD]))/2.0);
     outp("===============================================================================================================================\n");
 
-    outp("\nNumber of archers that qualified top  4, also ends in top  4 = %5.1lf\n", elimstats.n_top_q4_e4.avg);
-    outp("Number of archers that qualified top  8, also ends in top  8 = %5.1lf\n", elimstats.n_top_q8_e8.avg);
-    outp("Number of archers that qualified top 16, also ends in top 16 = %5.1lf\n", elimstats.n_top_q16_e16.avg);
+    outp("\nNumber of archers that qualified top  4, also ends in top  4 = %5.1lf\n", getMean(&(ctx->elimstats.n_top_q4_e4)));
+    outp("Number of archers that qualified top  8, also ends in top  8 = %5.1lf\n", getMean(&(ctx->elimstats.n_top_q8_e8)));
+    outp("Number of archers that qualified top 16, also ends in top 16 = %5.1lf\n", getMean(&(ctx->elimstats.n_top_q16_e16)));
 
-    outp("\nQualification ranking fit to theoretical ranking (lower is better): %lf\n", qstats.fc.avg);
-    outp("\nFinal ranking fit to theoretical ranking  (lower is better)       : %lf\n", elimstats.fc.avg);
+    outp("\nQualification ranking fit to theoretical ranking (lower is better): %lf\n", getMean(&(ctx->qstats.fc)));
+    outp("\nFinal ranking fit to theoretical ranking  (lower is better)       : %lf\n", getMean(&(ctx->elimstats.fc)));
 
 
+    }
+    else if (output_format == OUTPUT_BINARY) {
+        dumpEliminationTables(ctx);
     }
     else {
 
     outp("%s;%s;%lf;%lf;%lf;%lf;%lf;%lf;%s\n",
-            getFormatName(&q_format), getFormatName(&e_format),
+            getFormatName(&ctx->q_format), getFormatName(&ctx->e_format),
             asl1, asl4, asl8, asl16, asl32, asl56, asl104, name_of_population);
 
     outp("%ld;%ld;%ld;%ld;%ld;%ld;%ld;%ld\n",
-               elimstats.n_matches[F48TH],
-               elimstats.n_matches[F24TH],
-               elimstats.n_matches[F16TH],
-               elimstats.n_matches[F8TH],
-               elimstats.n_matches[F4TH],
-               elimstats.n_matches[FSEMI],
-               elimstats.n_matches[FGOLD],
+               ctx->elimstats.n_matches[F48TH],
+               ctx->elimstats.n_matches[F24TH],
+               ctx->elimstats.n_matches[F16TH],
+               ctx->elimstats.n_matches[F8TH],
+               ctx->elimstats.n_matches[F4TH],
+               ctx->elimstats.n_matches[FSEMI],
+               ctx->elimstats.n_matches[FGOLD],
                104);
-    if (e_format.best_of > 0) {
-        for (i = 0; i < e_format.best_of; i++) {
-            sum = (elimstats.n_win_after_sets[i][F48TH].avg +
-                   elimstats.n_win_after_sets[i][F24TH].avg +
-                   elimstats.n_win_after_sets[i][F16TH].avg +
-                   elimstats.n_win_after_sets[i][F8TH].avg +
-                   elimstats.n_win_after_sets[i][F4TH].avg +
-                   elimstats.n_win_after_sets[i][FSEMI].avg +
-                   elimstats.n_win_after_sets[i][FGOLD].avg );
+    if (ctx->e_format.best_of > 0) {
+        for (i = 0; i < ctx->e_format.best_of; i++) {
+            sum = (getMean(&(ctx->elimstats.n_win_after_sets[i][F48TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F24TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F16TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F8TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F4TH])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][FSEMI])) +
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][FGOLD])) );
             outp("%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf\n",
                    i+1,
-                   elimstats.n_win_after_sets[i][F48TH].avg/48.0,
-                   elimstats.n_win_after_sets[i][F24TH].avg/24.0,
-                   elimstats.n_win_after_sets[i][F16TH].avg/16.0,
-                   elimstats.n_win_after_sets[i][F8TH].avg/8.0,
-                   elimstats.n_win_after_sets[i][F4TH].avg/4.0,
-                   elimstats.n_win_after_sets[i][FSEMI].avg/2.0,
-                   elimstats.n_win_after_sets[i][FGOLD].avg/2.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F48TH]))/48.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F24TH]))/24.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F16TH]))/16.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F8TH]))/8.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][F4TH]))/4.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][FSEMI]))/2.0,
+                   getMean(&(ctx->elimstats.n_win_after_sets[i][FGOLD]))/2.0,
                    sum, sum/104.0);
         }
     }
-    sum = (elimstats.n_win_after_shootoff[F48TH].avg +
-           elimstats.n_win_after_shootoff[F24TH].avg +
-           elimstats.n_win_after_shootoff[F16TH].avg +
-           elimstats.n_win_after_shootoff[F8TH].avg +
-           elimstats.n_win_after_shootoff[F4TH].avg +
-           elimstats.n_win_after_shootoff[FSEMI].avg +
-           elimstats.n_win_after_shootoff[FGOLD].avg );
+    sum = (getMean(&(ctx->elimstats.n_win_after_shootoff[F48TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F24TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F16TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F8TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[F4TH])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[FSEMI])) +
+           getMean(&(ctx->elimstats.n_win_after_shootoff[FGOLD])) );
     outp("%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf\n",
-               elimstats.n_win_after_shootoff[F48TH].avg,
-               elimstats.n_win_after_shootoff[F24TH].avg,
-               elimstats.n_win_after_shootoff[F16TH].avg,
-               elimstats.n_win_after_shootoff[F8TH].avg,
-               elimstats.n_win_after_shootoff[F4TH].avg,
-               elimstats.n_win_after_shootoff[FSEMI].avg,
-               elimstats.n_win_after_shootoff[FGOLD].avg,
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F48TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F24TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F16TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F8TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[F4TH])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[FSEMI])),
+               getMean(&(ctx->elimstats.n_win_after_shootoff[FGOLD])),
                sum, sum/104.0);
-    sum = (elimstats.n_second_shootoff_required[F48TH].avg +
-           elimstats.n_second_shootoff_required[F24TH].avg +
-           elimstats.n_second_shootoff_required[F16TH].avg +
-           elimstats.n_second_shootoff_required[F8TH].avg +
-           elimstats.n_second_shootoff_required[F4TH].avg +
-           elimstats.n_second_shootoff_required[FSEMI].avg +
-           elimstats.n_second_shootoff_required[FGOLD].avg );
+    sum = (getMean(&(ctx->elimstats.n_second_shootoff_required[F48TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F24TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F16TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F8TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[F4TH])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[FSEMI])) +
+           getMean(&(ctx->elimstats.n_second_shootoff_required[FGOLD])) );
     outp("%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf\n",
-               elimstats.n_second_shootoff_required[F48TH].avg,
-               elimstats.n_second_shootoff_required[F24TH].avg,
-               elimstats.n_second_shootoff_required[F16TH].avg,
-               elimstats.n_second_shootoff_required[F8TH].avg,
-               elimstats.n_second_shootoff_required[F4TH].avg,
-               elimstats.n_second_shootoff_required[FSEMI].avg,
-               elimstats.n_second_shootoff_required[FGOLD].avg,
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F48TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F24TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F16TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F8TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[F4TH])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[FSEMI])),
+               getMean(&(ctx->elimstats.n_second_shootoff_required[FGOLD])),
                sum, sum/104.0);
-    if (e_format.best_of > 0) {
-        sum = (elimstats.n_win_with_equal_score_no_so[F48TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F24TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F16TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F8TH].avg +
-               elimstats.n_win_with_equal_score_no_so[F4TH].avg +
-               elimstats.n_win_with_equal_score_no_so[FSEMI].avg +
-               elimstats.n_win_with_equal_score_no_so[FGOLD].avg );
+    if (ctx->e_format.best_of > 0) {
+        sum = (getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F48TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F24TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F16TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F8TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F4TH])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FSEMI])) +
+               getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FGOLD])) );
         outp("%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf\n",
-                   elimstats.n_win_with_equal_score_no_so[F48TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F24TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F16TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F8TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[F4TH].avg,
-                   elimstats.n_win_with_equal_score_no_so[FSEMI].avg,
-                   elimstats.n_win_with_equal_score_no_so[FGOLD].avg,
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F48TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F24TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F16TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F8TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[F4TH])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FSEMI])),
+                   getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[FGOLD])),
                    sum, sum/104.0);
-        sum = (elimstats.n_win_with_lower_score[F48TH].avg +
-               elimstats.n_win_with_lower_score[F24TH].avg +
-               elimstats.n_win_with_lower_score[F16TH].avg +
-               elimstats.n_win_with_lower_score[F8TH].avg +
-               elimstats.n_win_with_lower_score[F4TH].avg +
-               elimstats.n_win_with_lower_score[FSEMI].avg +
-               elimstats.n_win_with_lower_score[FGOLD].avg );
+        sum = (getMean(&(ctx->elimstats.n_win_with_lower_score[F48TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F24TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F16TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F8TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[F4TH])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[FSEMI])) +
+               getMean(&(ctx->elimstats.n_win_with_lower_score[FGOLD])) );
         outp("%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf\n",
-                   elimstats.n_win_with_lower_score[F48TH].avg,
-                   elimstats.n_win_with_lower_score[F24TH].avg,
-                   elimstats.n_win_with_lower_score[F16TH].avg,
-                   elimstats.n_win_with_lower_score[F8TH].avg,
-                   elimstats.n_win_with_lower_score[F4TH].avg,
-                   elimstats.n_win_with_lower_score[FSEMI].avg,
-                   elimstats.n_win_with_lower_score[FGOLD].avg,
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F48TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F24TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F16TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F8TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[F4TH])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[FSEMI])),
+                   getMean(&(ctx->elimstats.n_win_with_lower_score[FGOLD])),
                    sum, sum/104.0);
     }
-    sum = (elimstats.n_expected_wins[F48TH].avg +
-           elimstats.n_expected_wins[F24TH].avg +
-           elimstats.n_expected_wins[F16TH].avg +
-           elimstats.n_expected_wins[F8TH].avg +
-           elimstats.n_expected_wins[F4TH].avg +
-           elimstats.n_expected_wins[FSEMI].avg +
-           elimstats.n_expected_wins[FGOLD].avg );
+    sum = (getMean(&(ctx->elimstats.n_expected_wins[F48TH])) +
+           getMean(&(ctx->elimstats.n_expected_wins[F24TH])) +
+           getMean(&(ctx->elimstats.n_expected_wins[F16TH])) +
+           getMean(&(ctx->elimstats.n_expected_wins[F8TH])) +
+           getMean(&(ctx->elimstats.n_expected_wins[F4TH])) +
+           getMean(&(ctx->elimstats.n_expected_wins[FSEMI])) +
+           getMean(&(ctx->elimstats.n_expected_wins[FGOLD])) );
     outp("%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf;%lf\n",
-               elimstats.n_expected_wins[F48TH].avg/48.0,
-               elimstats.n_expected_wins[F24TH].avg/24.0,
-               elimstats.n_expected_wins[F16TH].avg/16.0,
-               elimstats.n_expected_wins[F8TH].avg/8.0,
-               elimstats.n_expected_wins[F4TH].avg/4.0,
-               elimstats.n_expected_wins[FSEMI].avg/2.0,
-               elimstats.n_expected_wins[FGOLD].avg/2.0,
+               getMean(&(ctx->elimstats.n_expected_wins[F48TH]))/48.0,
+               getMean(&(ctx->elimstats.n_expected_wins[F24TH]))/24.0,
+               getMean(&(ctx->elimstats.n_expected_wins[F16TH]))/16.0,
+               getMean(&(ctx->elimstats.n_expected_wins[F8TH]))/8.0,
+               getMean(&(ctx->elimstats.n_expected_wins[F4TH]))/4.0,
+               getMean(&(ctx->elimstats.n_expected_wins[FSEMI]))/2.0,
+               getMean(&(ctx->elimstats.n_expected_wins[FGOLD]))/2.0,
                sum, sum/104.0);
 
-    outp("%lf;%lf;%lf\n", elimstats.n_top_q4_e4.avg, elimstats.n_top_q8_e8.avg, elimstats.n_top_q16_e16.avg);
+    outp("%lf;%lf;%lf\n", getMean(&(ctx->elimstats.n_top_q4_e4)), getMean(&(ctx->elimstats.n_top_q8_e8)), getMean(&(ctx->elimstats.n_top_q16_e16)));
 
     }
 
@@ -1615,7 +1886,117 @@ void dumpEliminationStats() /*{{{2*/
 
 /* --- Local functions {{{1 */
 
-static Result doSetMatch(Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
+static void dumpEliminationTables(const SimulationContext *ctx) /*{{{2*/
+/*
+ * Dumps the elimination statistics as binary tables; "elimination" with a
+ * row per stage (from the 1/48 to the finals, stage is the number of matches
+ * in a bracket of the stage) holding the average numbers per competition,
+ * and "elimination_summary"
+ */
+{
+    static const int stage[MAX_STAGES] = { F48TH, F24TH, F16TH, F8TH, F4TH, FSEMI, FGOLD };
+    static const int matches[MAX_STAGES] = { 48, 24, 16, 8, 4, 2, 1 };
+    TableColumn column[7+MAX_SETS] = {
+        { "stage",                 COLUMN_INT },
+        { "n_matches",             COLUMN_INT },
+        { "win_after_shootoff",    COLUMN_DOUBLE },
+        { "second_shootoff",       COLUMN_DOUBLE },
+        { "win_equal_score_no_so", COLUMN_DOUBLE },
+        { "win_lower_score",       COLUMN_DOUBLE },
+        { "expected_wins",         COLUMN_DOUBLE },
+    };
+    TableColumn summary[6] = {
+        { "n_competitions",        COLUMN_INT },
+        { "top_q4_e4",             COLUMN_DOUBLE },
+        { "top_q8_e8",             COLUMN_DOUBLE },
+        { "top_q16_e16",           COLUMN_DOUBLE },
+        { "q_fc",                  COLUMN_DOUBLE },
+        { "e_fc",                  COLUMN_DOUBLE },
+    };
+    char name[MAX_SETS][24];
+    int n_sets = (ctx->e_format.best_of < MAX_SETS) ? ctx->e_format.best_of : MAX_SETS;
+    int i, s;
+
+    for (i = 0; i < n_sets; i++) {
+        snprintf(name[i], sizeof(name[i]), "win_after_sets_%d", i+1);
+        column[7+i].name = name[i];
+        column[7+i].type = COLUMN_DOUBLE;
+    }
+
+    beginTable("elimination", 7+n_sets, column);
+    for (s = 0; s < MAX_STAGES; s++) {
+        tableInt(matches[s]);
+        tableInt(ctx->elimstats.n_matches[stage[s]]);
+        tableDouble(getMean(&(ctx->elimstats.n_win_after_shootoff[stage[s]])));
+        tableDouble(getMean(&(ctx->elimstats.n_second_shootoff_required[stage[s]])));
+        tableDouble(getMean(&(ctx->elimstats.n_win_with_equal_score_no_so[stage[s]])));
+        tableDouble(getMean(&(ctx->elimstats.n_win_with_lower_score[stage[s]])));
+        tableDouble(getMean(&(ctx->elimstats.n_expected_wins[stage[s]])));
+        for (i = 0; i < n_sets; i++) {
+            tableDouble(getMean(&(ctx->elimstats.n_win_after_sets[i][stage[s]])));
+        }
+    }
+
+    beginTable("elimination_summary", 6, summary);
+    tableInt(ctx->elimstats.n_competitions);
+    tableDouble(getMean(&(ctx->elimstats.n_top_q4_e4)));
+    tableDouble(getMean(&(ctx->elimstats.n_top_q8_e8)));
+    tableDouble(getMean(&(ctx->elimstats.n_top_q16_e16)));
+    tableDouble(getMean(&(ctx->qstats.fc)));
+    tableDouble(getMean(&(ctx->elimstats.fc)));
+} /*}}}2*/
+
+static void beginMatrixTable(const char *name, int n_archers) /*{{{2*/
+/*
+ * Starts the binary table of an elimination matrix, a row per cell with the
+ * skill levels of the n_archers archers of the left and of the right side
+ * and the match counts (see addMatrixRow())
+ */
+{
+    static const char *lvl_name[2][3] = {
+        { "left_asl1", "left_asl2", "left_asl3" },
+        { "right_asl1", "right_asl2", "right_asl3" },
+    };
+    static const char *count_name[5] = {
+        "n_runs", "left_wins", "left_wins_shootoff", "right_wins", "right_wins_shootoff"
+    };
+    TableColumn column[2*3+5];
+    int n = 0;
+    int side, i;
+
+    if (output_format != OUTPUT_BINARY) return;
+
+    for (side = 0; side < 2; side++) {
+        for (i = 0; i < n_archers; i++) {
+            column[n].name = (n_archers == 1) ? ((side == 0) ? "left_asl" : "right_asl") : lvl_name[side][i];
+            column[n++].type = COLUMN_DOUBLE;
+        }
+    }
+    for (i = 0; i < 5; i++) {
+        column[n].name = count_name[i];
+        column[n++].type = COLUMN_INT;
+    }
+    beginTable(name, n, column);
+} /*}}}2*/
+
+static void addMatrixRow(const double *left_lvl, const double *right_lvl, int n_archers, MatrixCell cell) /*{{{2*/
+{
+    int i;
+
+    for (i = 0; i < n_archers; i++) {
+        tableDouble(left_lvl[i]);
+    }
+    for (i = 0; i < n_archers; i++) {
+        tableDouble(right_lvl[i]);
+    }
+    tableInt(e_nruns);
+    tableInt(cell.left_wins);
+    tableInt(cell.left_wins_shootoff);
+    tableInt(cell.right_wins);
+    tableInt(cell.right_wins_shootoff);
+} /*}}}2*/
+
+static Result doSetMatch(SimulationContext *ctx, Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a match between two archers based on the set principle, best of <best_of> sets
  * each set consists of <n_arrows> arrows (with possible shootoff) for given competition format
@@ -1625,24 +2006,25 @@ static Result doSetMatch(Archer *me, Archer *opponent, int stage, Counters *coun
  * format   = The competition format (face, distance, n_arrows, best_of)
  */
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
-    const int narrows = e_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
+    const int narrows = ctx->e_format.narrows;
 
     int nsets = 0;
     int my_setpoints = 0;
     int opponent_setpoints = 0;
-    int target_points = e_format.best_of+1;
-    double my_cumulative_score = 0.0;
-    double opponent_cumulative_score = 0.0;
+    int target_points = ctx->e_format.best_of+1;
+    Score my_cumulative_score = 0;
+    Score opponent_cumulative_score = 0;
 
     while (1) {
         /* Set */
         nsets++;
 
-        double my_score       = getScore(me->lvl, face, dist, narrows);
-        double opponent_score = getScore(opponent->lvl, face, dist, narrows);
+        Score my_score        = getArcherScore(&ctx->rs, me->e_table, me->lvl, face, dist, narrows);
+        Score opponent_score  = getArcherScore(&ctx->rs, opponent->e_table, opponent->lvl, face, dist, narrows);
 
+        ctx->n_arrows += 2*narrows;
         my_cumulative_score += my_score;
         opponent_cumulative_score += opponent_score;
 
@@ -1660,6 +2042,7 @@ static Result doSetMatch(Archer *me, Archer *opponent, int stage, Counters *coun
         }
 
         if (my_setpoints >= target_points) {
+            setMatchScore(counters, my_setpoints, opponent_setpoints, nsets, my_cumulative_score, opponent_cumulative_score);
             /* I win! */
             if (my_cumulative_score < opponent_cumulative_score) {
                 /* With lower cumulative score */
@@ -1674,6 +2057,7 @@ static Result doSetMatch(Archer *me, Archer *opponent, int stage, Counters *coun
         }
 
         if (opponent_setpoints >= target_points) {
+            setMatchScore(counters, my_setpoints, opponent_setpoints, nsets, my_cumulative_score, opponent_cumulative_score);
             /* Opponent wins! */
             if (opponent_cumulative_score < my_cumulative_score) {
                 /* With lower cumulative score */
@@ -1691,15 +2075,16 @@ static Result doSetMatch(Archer *me, Archer *opponent, int stage, Counters *coun
              (opponent_setpoints == (target_points-1))   )
         {
             /* We draw -> shootoff */
+            setMatchScore(counters, my_setpoints, opponent_setpoints, nsets, my_cumulative_score, opponent_cumulative_score);
             counters->n_win_after_sets[nsets-1][stage]++;
-            return doShootOff(face, me, opponent, stage, counters);
+            return doShootOff(ctx, face, me, opponent, stage, counters);
         }
 
         /* Nope.. continue */
     }
 } /*}}}2*/
 
-static Result doSetTeamMatch(Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
+static Result doSetTeamMatch(SimulationContext *ctx, Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a match between two teams based on the set principle, best of <best_of> sets
  * each set consists of <n_arrows> arrows per archer (with possible shootoff) for given competition format
@@ -1712,13 +2097,13 @@ static Result doSetTeamMatch(Team *left, Team *right, int stage, Counters *count
     int nsets = 0;
     int left_setpoints = 0;
     int right_setpoints = 0;
-    int target_points = e_format.best_of+1;
-    double left_cumulative_score = 0.0;
-    double right_cumulative_score = 0.0;
-    int narrows = e_format.narrows;
+    int target_points = ctx->e_format.best_of+1;
+    Score left_cumulative_score = 0;
+    Score right_cumulative_score = 0;
+    int narrows = ctx->e_format.narrows;
 
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
 
     D("Team set-match\n");
 
@@ -1726,14 +2111,15 @@ static Result doSetTeamMatch(Team *left, Team *right, int stage, Counters *count
         /* Set */
         nsets++;
 
-        double left_score   = getScore(left->archer[0].lvl,  face, dist, narrows) +
-                              getScore(left->archer[1].lvl,  face, dist, narrows) +
-                              getScore(left->archer[2].lvl,  face, dist, narrows);
-        double right_score  = getScore(right->archer[0].lvl, face, dist, narrows) +
-                              getScore(right->archer[1].lvl, face, dist, narrows) +
-                              getScore(right->archer[2].lvl, face, dist, narrows);
+        Score left_score    = getArcherScore(&ctx->rs, left->archer[0].e_table, left->archer[0].lvl,  face, dist, narrows) +
+                              getArcherScore(&ctx->rs, left->archer[1].e_table, left->archer[1].lvl,  face, dist, narrows) +
+                              getArcherScore(&ctx->rs, left->archer[2].e_table, left->archer[2].lvl,  face, dist, narrows);
+        Score right_score   = getArcherScore(&ctx->rs, right->archer[0].e_table, right->archer[0].lvl, face, dist, narrows) +
+                              getArcherScore(&ctx->rs, right->archer[1].e_table, right->archer[1].lvl, face, dist, narrows) +
+                              getArcherScore(&ctx->rs, right->archer[2].e_table, right->archer[2].lvl, face, dist, narrows);
+        ctx->n_arrows += 6*narrows;
 
-        D("Set %d: %4.1lf - %4.1lf -> ", nsets, left_score, right_score);
+        D("Set %d: %4.1lf - %4.1lf -> ", nsets, SCORE_TO_DOUBLE(left_score), SCORE_TO_DOUBLE(right_score));
 
         left_cumulative_score += left_score;
         right_cumulative_score += right_score;
@@ -1786,14 +2172,14 @@ static Result doSetTeamMatch(Team *left, Team *right, int stage, Counters *count
         {
             /* We draw -> shootoff */
             counters->n_win_after_sets[nsets-1][stage]++;
-            return doTeamShootOff(left, right, stage, counters);
+            return doTeamShootOff(ctx, left, right, stage, counters);
         }
 
         /* Nope.. continue */
     }
 } /*}}}2*/
 
-static Result doSetMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
+static Result doSetMixedTeamMatch(SimulationContext *ctx, MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a match between two mixed-teams based on the set principle, best of <best_of> sets
  * each set consists of <n_arrows> arrows per archer (with possible shootoff) for given competition format
@@ -1806,13 +2192,13 @@ static Result doSetMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage,
     int nsets = 0;
     int left_setpoints = 0;
     int right_setpoints = 0;
-    int target_points = e_format.best_of+1;
-    double left_cumulative_score = 0.0;
-    double right_cumulative_score = 0.0;
-    int narrows = e_format.narrows;
+    int target_points = ctx->e_format.best_of+1;
+    Score left_cumulative_score = 0;
+    Score right_cumulative_score = 0;
+    int narrows = ctx->e_format.narrows;
 
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
 
     D("Mixed-team set-match\n");
 
@@ -1820,12 +2206,13 @@ static Result doSetMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage,
         /* Set */
         nsets++;
 
-        double left_score   = getScore(left->archer[0].lvl,  face, dist, narrows) +
-                              getScore(left->archer[1].lvl,  face, dist, narrows);
-        double right_score  = getScore(right->archer[0].lvl, face, dist, narrows) +
-                              getScore(right->archer[1].lvl, face, dist, narrows);
+        Score left_score    = getArcherScore(&ctx->rs, left->archer[0].e_table, left->archer[0].lvl,  face, dist, narrows) +
+                              getArcherScore(&ctx->rs, left->archer[1].e_table, left->archer[1].lvl,  face, dist, narrows);
+        Score right_score   = getArcherScore(&ctx->rs, right->archer[0].e_table, right->archer[0].lvl, face, dist, narrows) +
+                              getArcherScore(&ctx->rs, right->archer[1].e_table, right->archer[1].lvl, face, dist, narrows);
+        ctx->n_arrows += 4*narrows;
 
-        D("Set %d: %4.1lf - %4.1lf -> ", nsets, left_score, right_score);
+        D("Set %d: %4.1lf - %4.1lf -> ", nsets, SCORE_TO_DOUBLE(left_score), SCORE_TO_DOUBLE(right_score));
 
         left_cumulative_score += left_score;
         right_cumulative_score += right_score;
@@ -1878,14 +2265,14 @@ static Result doSetMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage,
         {
             /* We draw -> shootoff */
             counters->n_win_after_sets[nsets-1][stage]++;
-            return doMixedTeamShootOff(left, right, stage, counters);
+            return doMixedTeamShootOff(ctx, left, right, stage, counters);
         }
 
         /* Nope.. continue */
     }
 } /*}}}2*/
 
-static Result doCumulativeMatch(Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
+static Result doCumulativeMatch(SimulationContext *ctx, Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a cummulative scoring match (with possible shootoff) between two
  * archers in some competition format
@@ -1895,12 +2282,15 @@ static Result doCumulativeMatch(Archer *me, Archer *opponent, int stage, Counter
  * format   = Competition format
  */
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
-    const int narrows = e_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
+    const int narrows = ctx->e_format.narrows;
 
-    double my_score       = getScore(me->lvl, face, dist, narrows);
-    double opponent_score = getScore(opponent->lvl, face, dist, narrows);
+    Score my_score        = getArcherScore(&ctx->rs, me->e_table, me->lvl, face, dist, narrows);
+    Score opponent_score  = getArcherScore(&ctx->rs, opponent->e_table, opponent->lvl, face, dist, narrows);
+
+    ctx->n_arrows += 2*narrows;
+    setMatchScore(counters, 0, 0, 0, my_score, opponent_score);
 
     switch (scoreCompare(my_score, opponent_score)) {
 
@@ -1914,13 +2304,13 @@ static Result doCumulativeMatch(Archer *me, Archer *opponent, int stage, Counter
 
         case DRAW:
             counters->n_win_after_sets[0][stage]++;
-            return doShootOff(face, me, opponent, stage, counters);
+            return doShootOff(ctx, face, me, opponent, stage, counters);
     }
 
     outp("ERROR: doCumulativeMatch()?\n");
 } /*}}}2*/
 
-static Result doCumulativeTeamMatch(Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
+static Result doCumulativeTeamMatch(SimulationContext *ctx, Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a cummulative scoring match (with possible shootoff) between two
  * teams in some competition format
@@ -1930,18 +2320,19 @@ static Result doCumulativeTeamMatch(Team *left, Team *right, int stage, Counters
  * format  = Competition format
  */
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
-    const int narrows = e_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
+    const int narrows = ctx->e_format.narrows;
 
-    double left_score  = getScore(left->archer[0].lvl, face, dist, narrows) +
-                         getScore(left->archer[1].lvl, face, dist, narrows) +
-                         getScore(left->archer[2].lvl, face, dist, narrows);
-    double right_score  = getScore(right->archer[0].lvl, face, dist, narrows) +
-                          getScore(right->archer[1].lvl, face, dist, narrows) +
-                          getScore(right->archer[2].lvl, face, dist, narrows);
+    Score left_score   = getArcherScore(&ctx->rs, left->archer[0].e_table, left->archer[0].lvl, face, dist, narrows) +
+                         getArcherScore(&ctx->rs, left->archer[1].e_table, left->archer[1].lvl, face, dist, narrows) +
+                         getArcherScore(&ctx->rs, left->archer[2].e_table, left->archer[2].lvl, face, dist, narrows);
+    Score right_score   = getArcherScore(&ctx->rs, right->archer[0].e_table, right->archer[0].lvl, face, dist, narrows) +
+                          getArcherScore(&ctx->rs, right->archer[1].e_table, right->archer[1].lvl, face, dist, narrows) +
+                          getArcherScore(&ctx->rs, right->archer[2].e_table, right->archer[2].lvl, face, dist, narrows);
+    ctx->n_arrows += 6*narrows;
 
-    D("Match: %5.1lf - %5.1lf\n", left_score, right_score);
+    D("Match: %5.1lf - %5.1lf\n", SCORE_TO_DOUBLE(left_score), SCORE_TO_DOUBLE(right_score));
 
     switch (scoreCompare(left_score, right_score)) {
 
@@ -1955,13 +2346,13 @@ static Result doCumulativeTeamMatch(Team *left, Team *right, int stage, Counters
 
         case DRAW:
             counters->n_win_after_sets[0][stage]++;
-            return doTeamShootOff(left, right, stage, counters);
+            return doTeamShootOff(ctx, left, right, stage, counters);
     }
 
     outp("ERROR: doCumulativeTeamMatch()?");
 } /*}}}2*/
 
-static Result doCumulativeMixedTeamMatch(MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
+static Result doCumulativeMixedTeamMatch(SimulationContext *ctx, MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a cummulative scoring match (with possible shootoff) between two
  * mixed-teams in some competition format
@@ -1971,16 +2362,17 @@ static Result doCumulativeMixedTeamMatch(MixedTeam *left, MixedTeam *right, int
  * format  = Competition format
  */
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
-    const int narrows = e_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
+    const int narrows = ctx->e_format.narrows;
 
-    double left_score  = getScore(left->archer[0].lvl, face, dist, narrows) +
-                         getScore(left->archer[1].lvl, face, dist, narrows);
-    double right_score  = getScore(right->archer[0].lvl, face, dist, narrows) +
-                          getScore(right->archer[1].lvl, face, dist, narrows);
+    Score left_score   = getArcherScore(&ctx->rs, left->archer[0].e_table, left->archer[0].lvl, face, dist, narrows) +
+                         getArcherScore(&ctx->rs, left->archer[1].e_table, left->archer[1].lvl, face, dist, narrows);
+    Score right_score   = getArcherScore(&ctx->rs, right->archer[0].e_table, right->archer[0].lvl, face, dist, narrows) +
+                          getArcherScore(&ctx->rs, right->archer[1].e_table, right->archer[1].lvl, face, dist, narrows);
+    ctx->n_arrows += 4*narrows;
 
-    D("Match: %5.1lf - %5.1lf\n", left_score, right_score);
+    D("Match: %5.1lf - %5.1lf\n", SCORE_TO_DOUBLE(left_score), SCORE_TO_DOUBLE(right_score));
 
     switch (scoreCompare(left_score, right_score)) {
 
@@ -1994,13 +2386,13 @@ static Result doCumulativeMixedTeamMatch(MixedTeam *left, MixedTeam *right, int
 
         case DRAW:
             counters->n_win_after_sets[0][stage]++;
-            return doMixedTeamShootOff(left, right, stage, counters);
+            return doMixedTeamShootOff(ctx, left, right, stage, counters);
     }
 
     outp("ERROR: doCumulativeMixedTeamMatch()?");
 } /*}}}2*/
 
-static Result doShootOff(const Face *face, Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
+static Result doShootOff(SimulationContext *ctx, const Face *face, Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a single arrow shoot-off between two archers in a
  * competition format (actually, only distance)
@@ -2011,15 +2403,16 @@ static Result doShootOff(const Face *face, Archer *me, Archer *opponent, int sta
  * format   = Competition format
  */
 {
-    const double dist = e_format.distance;
+    const double dist = ctx->e_format.distance;
 
     /* Shootoff */
     counters->n_win_after_shootoff[stage]++;
     int attempt = 0;
     while (1) {
         attempt++;
-        double my_d       = getArrowPosition(me->lvl, dist);
-        double opponent_d = getArrowPosition(opponent->lvl, dist);
+        double my_d       = getArrowPosition(&ctx->rs, me->lvl, dist);
+        double opponent_d = getArrowPosition(&ctx->rs, opponent->lvl, dist);
+        ctx->n_arrows += 2;
         /* This targetface has special 2nd shootoff rule enabled and this is the first attempt */
         if ( (face->ring_for_2nd_so >= 0)  &&
              (attempt == 1)                   )
@@ -2040,7 +2433,7 @@ static Result doShootOff(const Face *face, Archer *me, Archer *opponent, int sta
     }
 } /*}}}2*/
 
-static Result doTeamShootOff(Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
+static Result doTeamShootOff(SimulationContext *ctx, Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a team shoot-off between two teams in a
  * competition format (actually, only distance)
@@ -2050,8 +2443,8 @@ static Result doTeamShootOff(Team *left, Team *right, int stage, Counters *count
  * stage = stage in elimination
  */
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
 
     D("TEAM SHOOTOFF\n");
 
@@ -2063,13 +2456,14 @@ static Result doTeamShootOff(Team *left, Team *right, int stage, Counters *count
         double left_d[3];
         double right_d[3];
 
-        left_d[0] = getArrowPosition(left->archer[0].lvl, dist);
-        left_d[1] = getArrowPosition(left->archer[1].lvl, dist);
-        left_d[2] = getArrowPosition(left->archer[2].lvl, dist);
+        left_d[0] = getArrowPosition(&ctx->rs, left->archer[0].lvl, dist);
+        left_d[1] = getArrowPosition(&ctx->rs, left->archer[1].lvl, dist);
+        left_d[2] = getArrowPosition(&ctx->rs, left->archer[2].lvl, dist);
 
-        right_d[0] = getArrowPosition(right->archer[0].lvl, dist);
-        right_d[1] = getArrowPosition(right->archer[1].lvl, dist);
-        right_d[2] = getArrowPosition(right->archer[2].lvl, dist);
+        right_d[0] = getArrowPosition(&ctx->rs, right->archer[0].lvl, dist);
+        right_d[1] = getArrowPosition(&ctx->rs, right->archer[1].lvl, dist);
+        right_d[2] = getArrowPosition(&ctx->rs, right->archer[2].lvl, dist);
+        ctx->n_arrows += 6;
 
         switch (teamShootoffCompare(left, left_d, right, right_d, face)) {
         case LEFT_WINS_SHOOTOFF: return LEFT_WINS_SHOOTOFF;
@@ -2079,7 +2473,7 @@ static Result doTeamShootOff(Team *left, Team *right, int stage, Counters *count
     }
 } /*}}}2*/
 
-static Result doMixedTeamShootOff(MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
+static Result doMixedTeamShootOff(SimulationContext *ctx, MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a mixed team shoot-off between two mixed teams in a
  * competition format (actually, only distance)
@@ -2089,8 +2483,8 @@ static Result doMixedTeamShootOff(MixedTeam *left, MixedTeam *right, int stage,
  * stage = stage in elimination
  */
 {
-    const Face *face = getFace(e_format.facetype);
-    const double dist = e_format.distance;
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    const double dist = ctx->e_format.distance;
 
     D("MIXED-TEAM SHOOTOFF\n");
 
@@ -2102,11 +2496,12 @@ static Result doMixedTeamShootOff(MixedTeam *left, MixedTeam *right, int stage,
         double left_d[2];
         double right_d[2];
 
-        left_d[0] = getArrowPosition(left->archer[0].lvl, dist);
-        left_d[1] = getArrowPosition(left->archer[1].lvl, dist);
+        left_d[0] = getArrowPosition(&ctx->rs, left->archer[0].lvl, dist);
+        left_d[1] = getArrowPosition(&ctx->rs, left->archer[1].lvl, dist);
 
-        right_d[0] = getArrowPosition(right->archer[0].lvl, dist);
-        right_d[1] = getArrowPosition(right->archer[1].lvl, dist);
+        right_d[0] = getArrowPosition(&ctx->rs, right->archer[0].lvl, dist);
+        right_d[1] = getArrowPosition(&ctx->rs, right->archer[1].lvl, dist);
+        ctx->n_arrows += 4;
 
         switch (mixedTeamShootoffCompare(left, left_d, right, right_d, face)) {
         case LEFT_WINS_SHOOTOFF: return LEFT_WINS_SHOOTOFF;
@@ -2116,34 +2511,65 @@ static Result doMixedTeamShootOff(MixedTeam *left, MixedTeam *right, int stage,
     }
 } /*}}}2*/
 
-static Result doRandomMatch(Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
+static void setMatchScore(Counters *counters, int left_points, int right_points, int n_sets, /*{{{2*/
+                          Score left_score, Score right_score)
+/*
+ * Keeps the score of the match just shot for the event log
+ */
+{
+    counters->left_points = left_points;
+    counters->right_points = right_points;
+    counters->n_sets = n_sets;
+    counters->left_score = left_score;
+    counters->right_score = right_score;
+} /*}}}2*/
+
+static Result doFastMatch(SimulationContext *ctx, Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
+/*
+ * Decides a match between two archers of ctx->archer[] with a single uniform from
+ * the probabilities of initFastBracket(). Only the shoot-off counter is kept,
+ * set counts and second shoot-offs require the full simulation
+ */
+{
+    const double *p = ctx->fast_win[me - ctx->archer][opponent - ctx->archer];
+    double u = getUniformRandom(&ctx->rs);
+
+    if (u < p[0]) return LEFT_WINS;
+    if (u < p[2]) {
+        counters->n_win_after_shootoff[stage]++;
+        return (u < p[1]) ? LEFT_WINS_SHOOTOFF : RIGHT_WINS_SHOOTOFF;
+    }
+    return RIGHT_WINS;
+} /*}}}2*/
+
+static Result doRandomMatch(SimulationContext *ctx, Archer *me, Archer *opponent, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a random match between two skill levels
  * Returns 1 for my win!
  */
 {
-    return rand()>RAND_MAX/2?LEFT_WINS:RIGHT_WINS;
+    return getCoinToss(&ctx->rs)?LEFT_WINS:RIGHT_WINS;
 } /*}}}2*/
 
-static Result doTeamRandomMatch(Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
+static Result doTeamRandomMatch(SimulationContext *ctx, Team *left, Team *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a random match between two teams
  * Returns 1 for left team wins!
  */
 {
-    return rand()>RAND_MAX/2?LEFT_WINS:RIGHT_WINS;
+    return getCoinToss(&ctx->rs)?LEFT_WINS:RIGHT_WINS;
 } /*}}}2*/
 
-static Result doMixedTeamRandomMatch(MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
+static Result doMixedTeamRandomMatch(SimulationContext *ctx, MixedTeam *left, MixedTeam *right, int stage, Counters *counters) /*{{{2*/
 /*
  * Performs a simulation of a random match between two mixed teams
  * Returns 1 for left mixed team wins!
  */
 {
-    return rand()>RAND_MAX/2?LEFT_WINS:RIGHT_WINS;
+    return getCoinToss(&ctx->rs)?LEFT_WINS:RIGHT_WINS;
 } /*}}}2*/
 
-static double getFinalRankingCorrectness(void) /*{{{2*/
+static double getFinalRankingCorrectness(SimulationContext *ctx) /*{{{2*/
 /*
  * Compute the correctness factor for the final ranking
  *
@@ -2161,9 +2587,660 @@ static double getFinalRankingCorrectness(void) /*{{{2*/
     int i;
 
     for (i = 0; i < 104; i++) {
-        f += (archer[i].lvl_rank - archer[i].e_rank) * (archer[i].lvl_rank - archer[i].e_rank);
+        f += (ctx->archer[i].lvl_rank - ctx->archer[i].e_rank) * (ctx->archer[i].lvl_rank - ctx->archer[i].e_rank);
     }
     return sqrt(f)/104.0;
 } /*}}}2*/
 
 
+
+static void computeExactEliminationStats(SimulationContext *ctx) /*{{{2*/
+/*
+ * Computes the elimination matrix (left ASL vs right ASL) exactly from the
+ * end score distributions (see exact.c) and prints the win probability,
+ * the shoot-off probabilities, the probability of a win with a lower or
+ * equal cumulative score and the distribution of the number of sets
+ */
+{
+    ExactMatch *grid;
+    double lasl;
+    double rasl;
+    int n = 0;
+    int n_sets = 0;
+    int i, j;
+    char title[64];
+
+    for (lasl = start_asl; lasl <= end_asl; lasl += step_asl) {
+        n++;
+    }
+    grid = malloc((size_t)n*n*sizeof(ExactMatch));
+    if (grid == NULL) {
+        fatal("computeExactEliminationStats() out of memory");
+    }
+
+    for (i = 0, lasl = start_asl; i < n; i++, lasl += step_asl) {
+        for (j = 0, rasl = start_asl; j < n; j++, rasl += step_asl) {
+            computeExactMatch(ctx, lasl, rasl, &ctx->e_format, &grid[i*n+j]);
+        }
+    }
+
+    if (pretty_print) {
+        outp("Format: %s\n", getFormatName(&ctx->e_format));
+        outp("N     : exact\n");
+    }
+    else {
+        outp("%s\nexact\n", getFormatName(&ctx->e_format));
+    }
+
+    printExactMatrix(ctx, "Left wins", grid, n, 0);
+    printExactMatrix(ctx, "Shoot-off", grid, n, 1);
+    printExactMatrix(ctx, "Second shoot-off", grid, n, 2);
+    printExactMatrix(ctx, "Win with lower cumulative score", grid, n, 3);
+    printExactMatrix(ctx, "Win with equal cumulative score without shoot-off", grid, n, 4);
+
+    if (ctx->e_format.type == SETSYSTEM) n_sets = ctx->e_format.best_of;
+    if (ctx->e_format.type == CUMULATIVE) n_sets = 1;
+    for (i = 0; i < n_sets; i++) {
+        snprintf(title, sizeof(title), "Decided after %d sets", i+1);
+        printExactMatrix(ctx, title, grid, n, 5+i);
+    }
+
+    free(grid);
+
+    outp_close();
+} /*}}}2*/
+
+static void printExactMatrix(const SimulationContext *ctx, const char *title, const ExactMatch *grid, int n, int what) /*{{{2*/
+/*
+ * Prints one quantity of the exact elimination matrix in the layout of
+ * computeEliminationStats(). An exact value has no variance, so the CSV
+ * columns p-var;p;p+var of a cell are all p, where;
+ * ctx = simulation context (elimination format and face)
+ * title = name of the quantity
+ * grid = n x n exact match outcomes, row is left ASL, column is right ASL
+ * what = quantity to print (see getExactValue())
+ */
+{
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    double lasl;
+    double rasl;
+    int i, j;
+
+    if (pretty_print) {
+        outp("\n%s\n", title);
+        outp("Archers Skill Level\n");
+        outp("               ");
+        for (rasl = start_asl, j = 0; j < n; rasl += step_asl, j++) {
+            outp("|    %5.1lf    ", rasl);
+        }
+        outp("+\n");
+        outp("               ");
+        for (rasl = start_asl, j = 0; j < n; rasl += step_asl, j++) {
+            outp("|    %5.1lf    ", getScoreBySkillLevel(rasl, face, ctx->e_format.distance, 72));
+        }
+        outp("|\n---------------");
+        for (j = 0; j < n; j++) {
+            outp("+-------------");
+        }
+        outp("+\n");
+    }
+    else {
+        outp("%s\n;", title);
+        for (rasl = start_asl, j = 0; j < n; rasl += step_asl, j++) {
+            outp(";;%lf;", rasl);
+        }
+        outp("\n;");
+        for (rasl = start_asl, j = 0; j < n; rasl += step_asl, j++) {
+            outp(";;%lf;", getScoreBySkillLevel(rasl, face, ctx->e_format.distance, 72));
+        }
+        outp("\n");
+    }
+
+    for (lasl = start_asl, i = 0; i < n; lasl += step_asl, i++) {
+        if (pretty_print) {
+            outp(" %5.1lf (=%5.1lf)", lasl, getScoreBySkillLevel(lasl, face, ctx->e_format.distance, 72));
+        }
+        else {
+            outp("%lf;%lf", lasl, getScoreBySkillLevel(lasl, face, ctx->e_format.distance, 72));
+        }
+        for (j = 0; j < n; j++) {
+            double p = getExactValue(&grid[i*n+j], what);
+            if (pretty_print) {
+                outp("|   %5.1lf%%    ", 100.0*p);
+            }
+            else {
+                outp(";%lf;%lf;%lf", p, p, p);
+            }
+        }
+        outp(pretty_print ? "|\n" : "\n");
+    }
+} /*}}}2*/
+
+static double getExactValue(const ExactMatch *match, int what) /*{{{2*/
+/*
+ * Returns quantity what of an exact match outcome, 0..4 in the order of
+ * ExactMatch, 5 and up the probability to be decided after what-4 sets
+ */
+{
+    switch (what) {
+    case 0: return match->p_left_wins;
+    case 1: return match->p_shootoff;
+    case 2: return match->p_second_shootoff;
+    case 3: return match->p_win_with_lower_score;
+    case 4: return match->p_win_with_equal_score_no_so;
+    }
+    return match->p_after_sets[what-5];
+} /*}}}2*/
+
+static int computeEliminationMatrix(SimulationContext *ctx, int kind, EliminationMatrix *m) /*{{{2*/
+/*
+ * Simulates the elimination matrix (every skill level start_asl..end_asl
+ * against every skill level, e_nruns matches per cell) on the thread pool,
+ * where;
+ * ctx = context set up by the options (formats, faces and seed)
+ * kind = MATRIX_INDIVIDUAL, MATRIX_TEAM or MATRIX_MIXED_TEAM
+ * m = matrix to fill, release with freeEliminationMatrix()
+ * The matrix is split in tiles of MATRIX_TILE x MATRIX_TILE cells. When the
+ * left and right competitors are made alike, the win probabilities of (b,a)
+ * are those of (a,b) mirrored, so only the tiles on and above the diagonal
+ * are simulated. A shard (--shard) simulates a slice of the tiles and
+ * writes them to its partial results file (--partial-out), returning 1 as
+ * there is nothing to print; with --merge the cells are read from the
+ * partial results files of the shards instead of simulated (returns 0)
+ */
+{
+    double asl;
+    int n_blocks;
+    int n_workers;
+    int bi, bj;
+    int i, w;
+
+    m->ctx = ctx;
+    m->kind = kind;
+    m->n = 0;
+    for (asl = start_asl; asl <= end_asl; asl += step_asl) {
+        m->n++;
+    }
+
+    switch (kind) {
+    case MATRIX_TEAM:
+        m->symmetric = (t1asl1 - t1asl2 == t2asl1 - t2asl2 &&
+                        t1asl1 - t1asl3 == t2asl1 - t2asl3);
+        break;
+    case MATRIX_MIXED_TEAM:
+        m->symmetric = (xt1asl1 - xt1asl2 == xt2asl1 - xt2asl2);
+        break;
+    default:
+        m->symmetric = 1;
+        break;
+    }
+
+    n_blocks = (m->n + MATRIX_TILE - 1)/MATRIX_TILE;
+    m->n_blocks = n_blocks;
+    m->asl = malloc(m->n*sizeof(double));
+    m->tile_row = malloc(n_blocks*n_blocks*sizeof(int));
+    m->tile_col = malloc(n_blocks*n_blocks*sizeof(int));
+    m->cell = calloc((size_t)m->n*m->n, sizeof(MatrixCell));
+    if (m->asl == NULL || m->tile_row == NULL || m->tile_col == NULL || m->cell == NULL) {
+        fatal("computeEliminationMatrix() out of memory");
+    }
+
+    /* Same (accumulated) skill levels as the loops printing the matrix */
+    for (i = 0, asl = start_asl; i < m->n; i++, asl += step_asl) {
+        m->asl[i] = asl;
+    }
+
+    m->n_tiles = 0;
+    for (bi = 0; bi < n_blocks; bi++) {
+        for (bj = (m->symmetric ? bi : 0); bj < n_blocks; bj++) {
+            m->tile_row[m->n_tiles] = bi;
+            m->tile_col[m->n_tiles] = bj;
+            m->n_tiles++;
+        }
+    }
+
+    /* Same slices as the blocks of --competitions */
+    m->n_all_tiles = m->n_tiles;
+    m->first_tile = (int)((long)m->n_tiles*(shard-1)/n_shards);
+    m->last_tile = (int)((long)m->n_tiles*shard/n_shards);
+    m->worker = NULL;
+
+    if (n_merge_files > 0) {
+        mergeEliminationMatrix(m);
+        return 0;
+    }
+
+    /* The tiles of the slice are moved to the front */
+    memmove(m->tile_row, &m->tile_row[m->first_tile], (m->last_tile - m->first_tile)*sizeof(int));
+    memmove(m->tile_col, &m->tile_col[m->first_tile], (m->last_tile - m->first_tile)*sizeof(int));
+    m->n_tiles = m->last_tile - m->first_tile;
+
+    m->checkpoint.fp = NULL;
+    if (checkpoint_file != NULL) {
+        /* Only the tiles not in the checkpoint are simulated */
+        m->n_tiles = resumeEliminationMatrix(m);
+        pthread_mutex_init(&m->lock, NULL);
+    }
+
+    n_workers = getPoolWorkers(m->n_tiles);
+    m->worker = malloc(n_workers*sizeof(SimulationContext*));
+    if (m->worker == NULL) {
+        fatal("computeEliminationMatrix() out of memory");
+    }
+    for (w = 0; w < n_workers; w++) {
+        m->worker[w] = malloc(sizeof(SimulationContext));
+        if (m->worker[w] == NULL) {
+            fatal("computeEliminationMatrix() out of memory");
+        }
+        forkSimulationContext(m->worker[w], ctx, 0);
+    }
+
+    startProgress("matches", (long)getMatrixCells(m, m->n_tiles)*e_nruns, NULL, NULL);
+    runPoolTasks(n_workers, m->n_tiles, doMatrixTile, m);
+    stopProgress();
+
+    if (m->checkpoint.fp != NULL) {
+        pthread_mutex_destroy(&m->lock);
+        closeCheckpoint(&m->checkpoint);
+    }
+
+    for (w = 0; w < n_workers; w++) {
+        free(m->worker[w]);
+    }
+    free(m->worker);
+    m->worker = NULL;
+
+    if (partial_out != NULL) {
+        writeMatrixPartial(m);
+        return 1;
+    }
+    return 0;
+} /*}}}2*/
+
+static uint64_t getMatrixStudy(const EliminationMatrix *m) /*{{{2*/
+/*
+ * Returns the hash of what decides the cells of an elimination matrix; that
+ * of the context, the kind, the skill levels and the team skill levels
+ */
+{
+    static const double *team_asl[10] = { &t1asl1, &t1asl2, &t1asl3, &t2asl1, &t2asl2, &t2asl3,
+                                          &xt1asl1, &xt1asl2, &xt2asl1, &xt2asl2 };
+    uint64_t study = getContextHash(m->ctx);
+    int i;
+
+    study = addContextHash(study, &m->kind, sizeof(int));
+    study = addContextHash(study, m->asl, m->n*sizeof(double));
+    for (i = 0; i < 10; i++) {
+        study = addContextHash(study, team_asl[i], sizeof(double));
+    }
+    return study;
+} /*}}}2*/
+
+static int resumeEliminationMatrix(EliminationMatrix *m) /*{{{2*/
+/*
+ * Opens the checkpoint of the matrix, takes the cells of the tiles finished
+ * before from it (--resume) and returns the number of tiles left, these
+ * are moved to the front of tile_row[] and tile_col[]
+ */
+{
+    MatrixTileRecord record;
+    uint64_t study = getMatrixStudy(m);
+    char *done;
+    long n_records;
+    long r;
+    int n_left = 0;
+    int t;
+
+    done = calloc(m->n_blocks*m->n_blocks, 1);
+    if (done == NULL) {
+        fatal("resumeEliminationMatrix() out of memory");
+    }
+
+    n_records = openCheckpoint(&m->checkpoint, CHECKPOINT_MATRIX, study, e_nruns, sizeof(MatrixTileRecord));
+    for (r = 0; r < n_records; r++) {
+        if (fread(&record, sizeof(record), 1, m->checkpoint.fp) != 1 ||
+            record.tile < 0 || record.tile >= m->n_blocks*m->n_blocks) {
+            fatal("Cannot read checkpoint file");
+        }
+        setMatrixTileRecord(m, &record);
+        done[record.tile] = 1;
+    }
+    continueCheckpoint(&m->checkpoint, n_records);
+
+    for (t = 0; t < m->n_tiles; t++) {
+        if (!done[m->tile_row[t]*m->n_blocks + m->tile_col[t]]) {
+            m->tile_row[n_left] = m->tile_row[t];
+            m->tile_col[n_left] = m->tile_col[t];
+            n_left++;
+        }
+    }
+    free(done);
+
+    return n_left;
+} /*}}}2*/
+
+static void writeMatrixTile(EliminationMatrix *m, int bi, int bj) /*{{{2*/
+/*
+ * Writes the cells of a finished tile to the checkpoint
+ */
+{
+    MatrixTileRecord record;
+
+    getMatrixTileRecord(m, bi, bj, &record);
+
+    pthread_mutex_lock(&m->lock);
+    if (fwrite(&record, sizeof(record), 1, m->checkpoint.fp) != 1) {
+        fatal("Cannot write checkpoint file");
+    }
+    syncCheckpoint(&m->checkpoint);
+    pthread_mutex_unlock(&m->lock);
+} /*}}}2*/
+
+static void getMatrixTileRecord(const EliminationMatrix *m, int bi, int bj, MatrixTileRecord *record) /*{{{2*/
+/*
+ * Fills record with the cells of tile (bi,bj) of the matrix
+ */
+{
+    int i, j;
+
+    memset(record, 0, sizeof(MatrixTileRecord));
+    record->tile = bi*m->n_blocks + bj;
+    for (i = bi*MATRIX_TILE; i < (bi+1)*MATRIX_TILE && i < m->n; i++) {
+        for (j = bj*MATRIX_TILE; j < (bj+1)*MATRIX_TILE && j < m->n; j++) {
+            record->cell[(i-bi*MATRIX_TILE)*MATRIX_TILE + (j-bj*MATRIX_TILE)] = m->cell[i*m->n+j];
+        }
+    }
+} /*}}}2*/
+
+static void setMatrixTileRecord(EliminationMatrix *m, const MatrixTileRecord *record) /*{{{2*/
+/*
+ * Sets the cells of the tile of record (a valid tile index) in the matrix
+ */
+{
+    int bi = record->tile / m->n_blocks;
+    int bj = record->tile % m->n_blocks;
+    int i, j;
+
+    for (i = bi*MATRIX_TILE; i < (bi+1)*MATRIX_TILE && i < m->n; i++) {
+        for (j = bj*MATRIX_TILE; j < (bj+1)*MATRIX_TILE && j < m->n; j++) {
+            m->cell[i*m->n+j] = record->cell[(i-bi*MATRIX_TILE)*MATRIX_TILE + (j-bj*MATRIX_TILE)];
+        }
+    }
+} /*}}}2*/
+
+static void writeMatrixPartial(const EliminationMatrix *m) /*{{{2*/
+/*
+ * Writes the tiles of the slice of this shard to the partial results file
+ * (--partial-out), in the order of computeEliminationMatrix()
+ */
+{
+    MatrixPartialHeader header;
+    MatrixTileRecord record;
+    FILE *fp;
+    int t = 0;
+    int bi, bj;
+
+    fp = fopen(partial_out, "wb");
+    if (fp == NULL) {
+        fatal("Cannot open partial results file for writing");
+    }
+
+    memset(&header, 0, sizeof(MatrixPartialHeader));
+    strcpy(header.magic, MATRIX_PARTIAL_MAGIC);
+    header.version = MATRIX_PARTIAL_VERSION;
+    header.record_size = sizeof(MatrixTileRecord);
+    header.shard = shard;
+    header.n_shards = n_shards;
+    header.kind = m->kind;
+    header.n = m->n;
+    header.n_runs = e_nruns;
+    header.n_tiles = m->n_all_tiles;
+    header.first_tile = m->first_tile;
+    header.last_tile = m->last_tile;
+    header.study = getMatrixStudy(m);
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        fatal("Cannot write partial results file");
+    }
+
+    for (bi = 0; bi < m->n_blocks; bi++) {
+        for (bj = (m->symmetric ? bi : 0); bj < m->n_blocks; bj++, t++) {
+            if (t < m->first_tile || t >= m->last_tile) continue;
+            getMatrixTileRecord(m, bi, bj, &record);
+            if (fwrite(&record, sizeof(record), 1, fp) != 1) {
+                fatal("Cannot write partial results file");
+            }
+        }
+    }
+
+    if (fclose(fp) != 0) {
+        fatal("Cannot write partial results file");
+    }
+} /*}}}2*/
+
+static void mergeEliminationMatrix(EliminationMatrix *m) /*{{{2*/
+/*
+ * Fills the cells of the matrix from the partial results files of the shards
+ * (--merge), given in any order; together they must hold every tile once
+ */
+{
+    uint64_t study = getMatrixStudy(m);
+    char *done;
+    int f, t;
+
+    done = calloc(m->n_tiles, 1);
+    if (done == NULL) {
+        fatal("mergeEliminationMatrix() out of memory");
+    }
+
+    for (f = 0; f < n_merge_files; f++) {
+        readMatrixPartialFile(m, merge_files[f], study, done);
+    }
+    for (t = 0; t < m->n_tiles; t++) {
+        if (!done[t]) {
+            fatal("Partial results files do not cover all tiles (shard missing)");
+        }
+    }
+    free(done);
+} /*}}}2*/
+
+static void readMatrixPartialFile(EliminationMatrix *m, const char *filename, uint64_t study, char *done) /*{{{2*/
+/*
+ * Reads the tiles of a partial results file into the matrix, where;
+ * m = matrix being merged, tile_row[] and tile_col[] hold all its tiles
+ * filename = partial results file written by a shard (--partial-out)
+ * study = getMatrixStudy() of the matrix
+ * done = per tile (in the order of tile_row[]) set when read
+ */
+{
+    MatrixPartialHeader header;
+    MatrixTileRecord record;
+    FILE *fp;
+    int t;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open partial results file %s\n", filename);
+        fatal("Merge failed");
+    }
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, MATRIX_PARTIAL_MAGIC, sizeof(MATRIX_PARTIAL_MAGIC)) != 0 ||
+        header.version != MATRIX_PARTIAL_VERSION || header.record_size != sizeof(MatrixTileRecord)) {
+        fprintf(stderr, "%s is not a partial results file of this program (version)\n", filename);
+        fatal("Merge failed");
+    }
+    if (header.study != study || header.kind != m->kind || header.n != m->n ||
+        header.n_runs != e_nruns || header.n_tiles != m->n_tiles ||
+        header.first_tile < 0 || header.first_tile > header.last_tile || header.last_tile > m->n_tiles) {
+        fprintf(stderr, "%s holds another study (options, seed or number of runs differ)\n", filename);
+        fatal("Merge failed");
+    }
+
+    for (t = header.first_tile; t < header.last_tile; t++) {
+        if (done[t]) {
+            fprintf(stderr, "%s overlaps another shard (tile %d)\n", filename, t);
+            fatal("Merge failed");
+        }
+        if (fread(&record, sizeof(record), 1, fp) != 1) {
+            fprintf(stderr, "%s is truncated\n", filename);
+            fatal("Cannot read partial results file");
+        }
+        if (record.tile != m->tile_row[t]*m->n_blocks + m->tile_col[t]) {
+            fprintf(stderr, "%s is corrupt (tile %d expected)\n", filename, t);
+            fatal("Cannot read partial results file");
+        }
+        setMatrixTileRecord(m, &record);
+        done[t] = 1;
+    }
+    fclose(fp);
+} /*}}}2*/
+
+static void freeEliminationMatrix(EliminationMatrix *m) /*{{{2*/
+{
+    free(m->asl);
+    free(m->tile_row);
+    free(m->tile_col);
+    free(m->cell);
+} /*}}}2*/
+
+static void doMatrixTile(void *arg, int worker, int task) /*{{{2*/
+/*
+ * Pool task simulating the cells of a tile of the elimination matrix
+ */
+{
+    EliminationMatrix *m = arg;
+    long n_arrows = m->worker[worker]->n_arrows;
+    long n_cells = 0;
+    int i_end = (m->tile_row[task]+1)*MATRIX_TILE;
+    int j_end = (m->tile_col[task]+1)*MATRIX_TILE;
+    int i, j;
+
+    if (i_end > m->n) i_end = m->n;
+    if (j_end > m->n) j_end = m->n;
+
+    for (i = m->tile_row[task]*MATRIX_TILE; i < i_end; i++) {
+        for (j = m->tile_col[task]*MATRIX_TILE; j < j_end; j++) {
+            if (m->symmetric && j < i) continue;
+            doMatrixCell(m->worker[worker], m, i, j);
+            n_cells++;
+        }
+    }
+
+    if (m->checkpoint.fp != NULL) {
+        writeMatrixTile(m, m->tile_row[task], m->tile_col[task]);
+    }
+
+    addProgress(n_cells*e_nruns, m->worker[worker]->n_arrows - n_arrows);
+} /*}}}2*/
+
+static long getMatrixCells(const EliminationMatrix *m, int n_tiles) /*{{{2*/
+/*
+ * Returns the number of cells simulated in the first n_tiles tiles of the
+ * elimination matrix
+ */
+{
+    long n_cells = 0;
+    int t, i, j;
+
+    for (t = 0; t < n_tiles; t++) {
+        int i_end = (m->tile_row[t]+1)*MATRIX_TILE;
+        int j_end = (m->tile_col[t]+1)*MATRIX_TILE;
+
+        if (i_end > m->n) i_end = m->n;
+        if (j_end > m->n) j_end = m->n;
+        for (i = m->tile_row[t]*MATRIX_TILE; i < i_end; i++) {
+            for (j = m->tile_col[t]*MATRIX_TILE; j < j_end; j++) {
+                if (!m->symmetric || j >= i) n_cells++;
+            }
+        }
+    }
+    return n_cells;
+} /*}}}2*/
+
+static void doMatrixCell(SimulationContext *ctx, EliminationMatrix *m, int i, int j) /*{{{2*/
+/*
+ * Simulates e_nruns matches of left asl[i] against right asl[j] on the
+ * context of a worker. Every cell is a run of its own (index i*n+j), so the
+ * outcome does not depend on the worker (or number of workers)
+ */
+{
+    const Face *face = getContextFace(ctx, ctx->e_format.facetype);
+    MatrixCell *cell = &m->cell[i*m->n+j];
+    Counters counters = {0};
+    Archer left, right;
+    Team left_team, right_team;
+    MixedTeam left_mixedteam, right_mixedteam;
+    double lvl[3];
+    Result result;
+    int r;
+
+    setContextRun(ctx, (uint64_t)i*m->n+j);
+
+    switch (m->kind) {
+    case MATRIX_TEAM:
+        lvl[0] = m->asl[i];
+        lvl[1] = m->asl[i] - (t1asl1 - t1asl2);
+        lvl[2] = m->asl[i] - (t1asl1 - t1asl3);
+        setTeam(ctx, &left_team, lvl);
+        lvl[0] = m->asl[j];
+        lvl[1] = m->asl[j] - (t2asl1 - t2asl2);
+        lvl[2] = m->asl[j] - (t2asl1 - t2asl3);
+        setTeam(ctx, &right_team, lvl);
+        break;
+    case MATRIX_MIXED_TEAM:
+        lvl[0] = m->asl[i];
+        lvl[1] = m->asl[i] - (xt1asl1 - xt1asl2);
+        setMixedTeam(ctx, &left_mixedteam, lvl);
+        lvl[0] = m->asl[j];
+        lvl[1] = m->asl[j] - (xt2asl1 - xt2asl2);
+        setMixedTeam(ctx, &right_mixedteam, lvl);
+        break;
+    default:
+        setArcher(ctx, &left, 0, m->asl[i]);
+        setArcher(ctx, &right, 0, m->asl[j]);
+        break;
+    }
+
+    cell->left_wins = 0;
+    cell->left_wins_shootoff = 0;
+    cell->right_wins = 0;
+    cell->right_wins_shootoff = 0;
+    for (r = 0; r < e_nruns; r++) {
+        switch (m->kind) {
+        case MATRIX_TEAM:
+            result = doTeamMatch(ctx, &left_team, &right_team, FGOLD, &counters);
+            break;
+        case MATRIX_MIXED_TEAM:
+            result = doMixedTeamMatch(ctx, &left_mixedteam, &right_mixedteam, FGOLD, &counters);
+            break;
+        default:
+            result = doMatch(ctx, face, &left, &right, FGOLD, &counters);
+            break;
+        }
+        switch (result) {
+        case LEFT_WINS:           cell->left_wins++;           break;
+        case LEFT_WINS_SHOOTOFF:  cell->left_wins_shootoff++;  break;
+        case RIGHT_WINS:          cell->right_wins++;          break;
+        case RIGHT_WINS_SHOOTOFF: cell->right_wins_shootoff++; break;
+        }
+    }
+} /*}}}2*/
+
+static MatrixCell getMatrixCell(const EliminationMatrix *m, int i, int j) /*{{{2*/
+/*
+ * Returns cell (i,j) of a simulated elimination matrix, cells below the
+ * diagonal of a symmetric matrix are the mirror of (j,i)
+ */
+{
+    MatrixCell cell;
+
+    if (m->symmetric && j < i) {
+        const MatrixCell *mirror = &m->cell[j*m->n+i];
+        cell.left_wins           = mirror->right_wins;
+        cell.left_wins_shootoff  = mirror->right_wins_shootoff;
+        cell.right_wins          = mirror->left_wins;
+        cell.right_wins_shootoff = mirror->left_wins_shootoff;
+        return cell;
+    }
+    return m->cell[i*m->n+j];
+} /*}}}2*/
@@ -28,6 +28,7 @@
 #include "archer.h"
 #include "score.h"
 #include "format.h"
+#include "random.h"
 
 #define MAX_SETS 10
 
@@ -92,13 +93,19 @@ typedef struct {
 /* --- Interface {{{1 */
 
 extern int e_nruns;
-
-void initEliminationStats(void);
-void doEliminationRound(void);
-void doTeamEliminationRound(void);
-void computeEliminationStats(void);
-void computeTeamEliminationStats(void);
-void computeMixedTeamEliminationStats(void);
-void dumpEliminationStats();
+extern int e_exact;
+extern int fast_bracket;
+
+struct SimulationContext;
+
+void initEliminationStats(struct SimulationContext *ctx);
+void initFastBracket(struct SimulationContext *ctx);
+void doEliminationRound(struct SimulationContext *ctx);
+void doTeamEliminationRound(struct SimulationContext *ctx);
+void computeEliminationStats(struct SimulationContext *ctx);
+void computeTeamEliminationStats(struct SimulationContext *ctx);
+void computeMixedTeamEliminationStats(struct SimulationContext *ctx);
+void dumpEliminationStats(struct SimulationContext *ctx);
+void mergeEliminationStats(EliminationStatistics *dst, const EliminationStatistics *src);
 
 #endif
@@ -0,0 +1,147 @@
+/*****************************************************************************
+*** Name      : eventlog.c                                                 ***
+*** Purpose   : Implements the match event log and its reader              ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "eventlog.h"
+#include "dump.h"
+
+/* --- Implementation {{{1 */
+
+void addMatchEvent(MatchEvents *events, const MatchEvent *event) /*{{{2*/
+/*
+ * Appends an event to the events of a context, where;
+ * events = events to add to (grown as needed)
+ * event = match to add, its run is set to events->run
+ */
+{
+    if (events->n_events == events->size) {
+        events->size = (events->size == 0) ? 1024 : 2*events->size;
+        events->event = realloc(events->event, events->size*sizeof(MatchEvent));
+        if (events->event == NULL) {
+            fatal("addMatchEvent() out of memory");
+        }
+    }
+    events->event[events->n_events] = *event;
+    events->event[events->n_events].run = events->run;
+    events->n_events++;
+} /*}}}2*/
+
+void openEventLog(EventLog *log, const char *filename, int n_runs, uint64_t study) /*{{{2*/
+/*
+ * Creates an event log file and writes its header, where;
+ * log = event log to open
+ * filename = name of the file
+ * n_runs = runs of the study
+ * study = getContextHash() of the study
+ */
+{
+    EventLogHeader header;
+
+    if (openFileWriter(&log->writer, filename, "wb") != 0) {
+        fatal("Cannot open event log for writing");
+    }
+
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, EVENT_LOG_MAGIC);
+    header.version = EVENT_LOG_VERSION;
+    header.record_size = (int32_t)sizeof(MatchEvent);
+    header.n_runs = n_runs;
+    header.study = study;
+    log->writer.write(log->writer.handle, &header, sizeof(header));
+} /*}}}2*/
+
+void writeEventLog(EventLog *log, const MatchEvent *event, size_t n_events) /*{{{2*/
+/*
+ * Appends events (in run order) to an event log
+ */
+{
+    if (n_events > 0) {
+        log->writer.write(log->writer.handle, event, n_events*sizeof(MatchEvent));
+    }
+} /*}}}2*/
+
+void closeEventLog(EventLog *log) /*{{{2*/
+{
+    log->writer.close(log->writer.handle);
+    log->writer.handle = NULL;
+} /*}}}2*/
+
+int mapEventLog(MappedEventLog *log, const char *filename) /*{{{2*/
+/*
+ * Maps an event log file for reading, returns 0 (or -1 when the file cannot
+ * be mapped or is not an event log of this build), where;
+ * log = set to the header and the events of the file
+ * filename = name of the file
+ * The events are read from the mapping, without copying
+ */
+{
+    struct stat st;
+    int fd;
+
+    memset(log, 0, sizeof(MappedEventLog));
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(EventLogHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    log->map_size = (size_t)st.st_size;
+    log->map = mmap(NULL, log->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (log->map == MAP_FAILED) {
+        log->map = NULL;
+        return -1;
+    }
+
+    log->header = log->map;
+    if (memcmp(log->header->magic, EVENT_LOG_MAGIC, sizeof(log->header->magic)) != 0 ||
+        log->header->version != EVENT_LOG_VERSION ||
+        log->header->record_size != (int32_t)sizeof(MatchEvent) ||
+        (log->map_size - sizeof(EventLogHeader)) % sizeof(MatchEvent) != 0) {
+        unmapEventLog(log);
+        return -1;
+    }
+
+    log->event = (const MatchEvent *)(log->header + 1);
+    log->n_events = (log->map_size - sizeof(EventLogHeader))/sizeof(MatchEvent);
+    madvise(log->map, log->map_size, MADV_SEQUENTIAL);
+    return 0;
+} /*}}}2*/
+
+void unmapEventLog(MappedEventLog *log) /*{{{2*/
+{
+    if (log->map != NULL) {
+        munmap(log->map, log->map_size);
+    }
+    memset(log, 0, sizeof(MappedEventLog));
+} /*}}}2*/
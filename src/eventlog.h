@@ -0,0 +1,119 @@
+/*****************************************************************************
+*** Name      : eventlog.h                                                 ***
+*** Purpose   : Defines the match event log and its reader                 ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _EVENTLOG_H
+#define _EVENTLOG_H
+
+/* --- Includes {{{1 */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "dump.h"
+
+/* --- Data types {{{1 */
+
+/*
+ * Flags of a match event
+ */
+#define EVENT_LEFT_WINS   0x01      /* Left archer won (else the right)     */
+#define EVENT_SHOOTOFF    0x02      /* Decided by a shoot-off               */
+#define EVENT_BRONZE      0x04      /* Bronze final (stage 0 is the gold)   */
+
+/*
+ * A match of the elimination round of a competition (--event-log). The
+ * stage is that of the elimination statistics; 6 = 1/48 up to 0 = final.
+ * Set points and sets shot are 0 for cumulative scoring, scores are 0 for
+ * matches that are not shot arrow by arrow (shoot-off and random formats,
+ * --fast-bracket)
+ */
+typedef struct {
+    uint32_t  run;              /* Competition (run index of the seed)  */
+    uint8_t   stage;
+    uint8_t   flags;            /* EVENT_...                            */
+    uint8_t   left_q_rank;      /* Qualification ranks (1..104)         */
+    uint8_t   right_q_rank;
+    uint8_t   left_points;      /* Set points                           */
+    uint8_t   right_points;
+    uint8_t   n_sets;
+    uint8_t   reserved;
+    int32_t   left_score;       /* Match score (Score, tenths of points)*/
+    int32_t   right_score;
+} MatchEvent;
+
+/*
+ * Events of the matches simulated on a context; run is set by the caller
+ * before each competition
+ */
+typedef struct {
+    uint32_t     run;
+    MatchEvent  *event;
+    size_t       n_events;
+    size_t       size;
+} MatchEvents;
+
+/*
+ * An event log file is this header followed by the events in run order,
+ * in the byte order of the machine. A log of a shard (--shard) holds the
+ * runs of the shard only
+ */
+#define EVENT_LOG_MAGIC   "ACSEVT1"
+#define EVENT_LOG_VERSION 1
+
+typedef struct {
+    char      magic[8];
+    int32_t   version;
+    int32_t   record_size;      /* sizeof(MatchEvent)                   */
+    int32_t   n_runs;           /* Runs of the whole study              */
+    int32_t   reserved;
+    uint64_t  study;            /* getContextHash()                     */
+} EventLogHeader;
+
+/*
+ * Event log being written
+ */
+typedef struct {
+    OutputWriter  writer;
+} EventLog;
+
+/*
+ * Event log mapped for reading; event[0..n_events-1] point into the file
+ */
+typedef struct {
+    const EventLogHeader  *header;
+    const MatchEvent      *event;
+    size_t                 n_events;
+    void                  *map;
+    size_t                 map_size;
+} MappedEventLog;
+
+/* --- Interface {{{1 */
+
+void addMatchEvent(MatchEvents *events, const MatchEvent *event);
+void openEventLog(EventLog *log, const char *filename, int n_runs, uint64_t study);
+void writeEventLog(EventLog *log, const MatchEvent *event, size_t n_events);
+void closeEventLog(EventLog *log);
+int mapEventLog(MappedEventLog *log, const char *filename);
+void unmapEventLog(MappedEventLog *log);
+
+#endif
@@ -0,0 +1,286 @@
+/*****************************************************************************
+*** Name      : exact.c                                                    ***
+*** Purpose   : Computes match outcome probabilities exactly from          ***
+***             the end score distributions                                ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dump.h"
+#include "exact.h"
+#include "context.h"
+#include "face.h"
+#include "score.h"
+#include "scoretable.h"
+
+/* --- Local prototypes {{{1 */
+
+static double *getTotalDistribution(ScoreTable *table, int n_arrows, int *n);
+static double *getDifferenceDistribution(ScoreTable *left, ScoreTable *right, int n_arrows, int *m);
+static void computeCumulativeMatch(const double *pd, int m, ExactMatch *match);
+static void computeSetMatch(const double *pd, int m, int best_of, ExactMatch *match);
+
+/* --- Implementation {{{1 */
+
+void computeExactMatch(const SimulationContext *ctx, double left_lvl, double right_lvl, const Format *format, ExactMatch *match) /*{{{2*/
+/*
+ * Computes the outcome probabilities of a match between two archers without
+ * simulation, where;
+ * ctx = simulation context (target faces)
+ * left_lvl = Archers Skill Level of the left archer
+ * right_lvl = Archers Skill Level of the right archer
+ * format = elimination match format
+ * match = filled with the outcome probabilities
+ * The end totals come from the (cached) end distributions of the score
+ * tables, set matches are a dynamic program over the set points and the
+ * cumulative score difference, the shoot-off is getShootoffProbability()
+ */
+{
+    const Face *face = getContextFace(ctx, format->facetype);
+    ScoreTable *left = getScoreTable(left_lvl, face, format->distance);
+    ScoreTable *right = getScoreTable(right_lvl, face, format->distance);
+    double p_second_so;
+    double p_so_left = getShootoffProbability(left_lvl, right_lvl, face, format->distance, &p_second_so);
+    double *pd;
+    int m;
+
+    memset(match, 0, sizeof(ExactMatch));
+
+    switch (format->type) {
+    case CUMULATIVE:
+        pd = getDifferenceDistribution(left, right, format->narrows, &m);
+        computeCumulativeMatch(pd, m, match);
+        free(pd);
+        break;
+    case SETSYSTEM:
+        if (format->best_of > MAX_SETS) {
+            fatal("computeExactMatch() more than MAX_SETS sets");
+        }
+        pd = getDifferenceDistribution(left, right, format->narrows, &m);
+        computeSetMatch(pd, m, format->best_of, match);
+        free(pd);
+        break;
+    case SHOOTOFF:
+        match->p_shootoff = 1.0;
+        break;
+    case RANDOM:
+        match->p_left_wins = 0.5;
+        break;
+    }
+
+    match->p_left_wins_shootoff = match->p_shootoff * p_so_left;
+    match->p_left_wins += match->p_left_wins_shootoff;
+    match->p_second_shootoff = match->p_shootoff * p_second_so;
+} /*}}}2*/
+
+/* --- Internals {{{1 */
+
+static double *getTotalDistribution(ScoreTable *table, int n_arrows, int *n) /*{{{2*/
+/*
+ * Returns the (allocated) distribution of the total of n_arrows arrows in
+ * units of the end distributions, convolving ends of at most MAX_END_ARROWS
+ * arrows, and sets n to its number of totals
+ */
+{
+    double *p = malloc(sizeof(double));
+    int len = 1;
+
+    if (p == NULL) {
+        fatal("getTotalDistribution() out of memory");
+    }
+    p[0] = 1.0;
+
+    while (n_arrows > 0) {
+        int k = (n_arrows < MAX_END_ARROWS) ? n_arrows : MAX_END_ARROWS;
+        EndDistribution *end = getEndDistribution(table, k);
+        double *q = calloc(len+end->n-1, sizeof(double));
+        int i, j;
+
+        if (q == NULL) {
+            fatal("getTotalDistribution() out of memory");
+        }
+        for (i = 0; i < len; i++) {
+            for (j = 0; j < end->n; j++) {
+                q[i+j] += p[i]*end->p[j];
+            }
+        }
+        free(p);
+        p = q;
+        len += end->n-1;
+        n_arrows -= k;
+    }
+
+    *n = len;
+    return p;
+} /*}}}2*/
+
+static double *getDifferenceDistribution(ScoreTable *left, ScoreTable *right, int n_arrows, int *m) /*{{{2*/
+/*
+ * Returns the (allocated) distribution pd[0..2m] of the difference between
+ * the left and right total of n_arrows arrows, where pd[d+m] is the
+ * probability that left scores d units more than right
+ */
+{
+    int n_left, n_right;
+    double *p_left = getTotalDistribution(left, n_arrows, &n_left);
+    double *p_right = getTotalDistribution(right, n_arrows, &n_right);
+    double *pd;
+    int i, j;
+
+    *m = (n_left > n_right ? n_left : n_right) - 1;
+    pd = calloc(2*(*m)+1, sizeof(double));
+    if (pd == NULL) {
+        fatal("getDifferenceDistribution() out of memory");
+    }
+    for (i = 0; i < n_left; i++) {
+        for (j = 0; j < n_right; j++) {
+            pd[i-j+(*m)] += p_left[i]*p_right[j];
+        }
+    }
+
+    free(p_left);
+    free(p_right);
+
+    return pd;
+} /*}}}2*/
+
+static void computeCumulativeMatch(const double *pd, int m, ExactMatch *match) /*{{{2*/
+/*
+ * Cumulative match; left wins on a positive difference, a draw is decided by
+ * shoot-off (added by the caller)
+ */
+{
+    int d;
+
+    for (d = 1; d <= m; d++) {
+        match->p_left_wins += pd[d+m];
+    }
+    match->p_shootoff = pd[m];
+    match->p_after_sets[0] = 1.0;
+} /*}}}2*/
+
+static void computeSetMatch(const double *pd, int m, int best_of, ExactMatch *match) /*{{{2*/
+/*
+ * Set system match, as doSetMatch(); a set win is 2 points, a drawn set 1
+ * point each, best_of+1 points wins and a tie at best_of points each is
+ * decided by shoot-off. The state before each set is the set points of both
+ * archers and the cumulative score difference D (in units), after set s
+ * |D| <= s*m. The set difference d only changes the set points by its sign,
+ * so the transitions are taken per sign (d < 0, d = 0, d > 0)
+ */
+{
+    const int target = best_of+1;
+    const int width = 2*best_of*m+1;
+    const int center = best_of*m;
+    const size_t size = (size_t)target*target*width;
+    double *cur = calloc(size, sizeof(double));
+    double *next = calloc(size, sizeof(double));
+    int s, ml, ol, c, D, d;
+
+    if (cur == NULL || next == NULL) {
+        fatal("computeSetMatch() out of memory");
+    }
+
+#define STATE(a, ml, ol) ((a) + ((size_t)(ml)*target + (ol))*width + center)
+
+    STATE(cur, 0, 0)[0] = 1.0;
+
+    for (s = 1; s <= best_of; s++) {
+        const int reach = (s-1)*m;
+        double *tmp;
+
+        memset(next, 0, size*sizeof(double));
+
+        for (ml = 0; ml < target; ml++) {
+            for (ol = 0; ol < target; ol++) {
+                const double *state = STATE(cur, ml, ol);
+
+                if (ml+ol != 2*(s-1)) continue;
+
+                /* Sign classes; c = 0 right wins the set, 1 draw, 2 left wins */
+                for (c = 0; c < 3; c++) {
+                    const int d_lo = (c == 0) ? -m : (c == 1) ? 0 : 1;
+                    const int d_hi = (c == 0) ? -1 : (c == 1) ? 0 : m;
+                    const int l = ml + c;
+                    const int o = ol + 2 - c;
+
+                    if (l >= target || o >= target) {
+                        /* Match decided, track the cumulative difference of the winner */
+                        double p_win = 0.0;
+                        double p_lower = 0.0;
+                        double p_equal = 0.0;
+                        for (D = -reach; D <= reach; D++) {
+                            if (state[D] == 0.0) continue;
+                            for (d = d_lo; d <= d_hi; d++) {
+                                double q = state[D]*pd[d+m];
+                                p_win += q;
+                                if (D+d == 0) {
+                                    p_equal += q;
+                                }
+                                else if ((l >= target) == (D+d < 0)) {
+                                    p_lower += q;
+                                }
+                            }
+                        }
+                        if (l >= target) match->p_left_wins += p_win;
+                        match->p_win_with_lower_score += p_lower;
+                        match->p_win_with_equal_score_no_so += p_equal;
+                        match->p_after_sets[s-1] += p_win;
+                    }
+                    else if (l == target-1 && o == target-1) {
+                        /* Tied on set points, shoot-off */
+                        double p_class = 0.0;
+                        double p_state = 0.0;
+                        for (d = d_lo; d <= d_hi; d++) {
+                            p_class += pd[d+m];
+                        }
+                        for (D = -reach; D <= reach; D++) {
+                            p_state += state[D];
+                        }
+                        match->p_shootoff += p_state*p_class;
+                        match->p_after_sets[s-1] += p_state*p_class;
+                    }
+                    else {
+                        double *dest = STATE(next, l, o);
+                        for (D = -reach; D <= reach; D++) {
+                            if (state[D] == 0.0) continue;
+                            for (d = d_lo; d <= d_hi; d++) {
+                                dest[D+d] += state[D]*pd[d+m];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        tmp = cur;
+        cur = next;
+        next = tmp;
+    }
+
+#undef STATE
+
+    free(cur);
+    free(next);
+} /*}}}2*/
@@ -0,0 +1,61 @@
+/*****************************************************************************
+*** Name      : exact.h                                                    ***
+*** Purpose   : Defines the exact match probability routines               ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _EXACT_H
+#define _EXACT_H
+
+/* --- Includes {{{1 */
+
+#include "format.h"
+#include "elimination.h"
+
+/* --- Data types {{{1 */
+
+/*
+ * Outcome probabilities of a single elimination match between two archers,
+ * with the same meaning as the simulated counters in elimination.c
+ */
+typedef struct {
+    /* Left archer wins (including shoot-off) */
+    double p_left_wins;
+    /* Match is decided by a shoot-off */
+    double p_shootoff;
+    /* Left archer wins the shoot-off (part of p_left_wins) */
+    double p_left_wins_shootoff;
+    /* A second shoot-off is required */
+    double p_second_shootoff;
+    /* Winner has a lower cumulative score (set system) */
+    double p_win_with_lower_score;
+    /* Winner has an equal cumulative score but no shoot-off (set system) */
+    double p_win_with_equal_score_no_so;
+    /* Match is decided (or goes to shoot-off) after n+1 sets */
+    double p_after_sets[MAX_SETS];
+} ExactMatch;
+
+/* --- Interface {{{1 */
+
+struct SimulationContext;
+
+void computeExactMatch(const struct SimulationContext *ctx, double left_lvl, double right_lvl, const Format *format, ExactMatch *match);
+
+#endif
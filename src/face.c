@@ -24,8 +24,11 @@
 /* --- Includes {{{1 */
 #include <string.h>
 #include <malloc.h>
+#include <math.h>
 
 #include "face.h"
+#include "facekernels.h"
+#include "dump.h"
 
 /* --- Local data {{{1 */
 
@@ -35,16 +38,62 @@ static int faceinit = 0;
 /* --- Local prototypes {{{1 */
 
 static void faceInit(void);
+static void setFaceThresholds(Face *f, double diameter);
 
 /* --- Implementation {{{1*/
 
 Face *getFace(FaceType type) /*{{{2*/
+/*
+ * Returns the definition of a target face (name, rings, values). Its
+ * thresholds are for a zero arrow diameter; the faces scored for the arrow
+ * diameter of a simulation are set up by initFaces()
+ */
 {
     /* Lazy face initialization */
     faceInit();
+
     return &face[type];
 } /*}}}2*/
 
+void initFaces(Face *faces, double diameter) /*{{{2*/
+/*
+ * Fills faces[0..N_FACES-1] with all target faces scored for an arrow
+ * diameter (in mm), where the ring definitions are shared with getFace() and
+ * the thresholds are owned by the faces
+ */
+{
+    int i;
+
+    faceInit();
+
+    for (i = 0; i < N_FACES; i++) {
+        faces[i] = face[i];
+        faces[i].threshold = calloc(face[i].n_rings, sizeof(double));
+        faces[i].threshold2 = calloc(face[i].n_rings, sizeof(double));
+        if (faces[i].threshold == NULL || faces[i].threshold2 == NULL) {
+            fatal("initFaces() out of memory");
+        }
+        setFaceThresholds(&faces[i], diameter);
+        checkFaceKernel(&faces[i]);
+    }
+} /*}}}2*/
+
+void freeFaces(Face *faces) /*{{{2*/
+/*
+ * Frees the thresholds of faces[0..N_FACES-1] (set by initFaces(), or
+ * unset)
+ */
+{
+    int i;
+
+    for (i = 0; i < N_FACES; i++) {
+        free(faces[i].threshold);
+        free(faces[i].threshold2);
+        faces[i].threshold = NULL;
+        faces[i].threshold2 = NULL;
+    }
+} /*}}}2*/
+
 /* --- Local functions {{{1 */
 
 static void faceInit(void) /*{{{2*/
@@ -564,6 +613,38 @@ static void faceInit(void) /*{{{2*/
     f->significant_decimals = 1;
     f->ring_for_2nd_so = -1;
 
+    for (i = 0; i < N_FACES; i++) {
+        int j;
+
+        /* Fixed point ring values, faces score in tenths at most */
+        if (face[i].significant_decimals > 1) {
+            fatal("faceInit() face scores finer than SCORE_SCALE");
+        }
+        face[i].points = calloc(face[i].n_rings, sizeof(Score));
+        for (j = 0; j < face[i].n_rings; j++) {
+            face[i].points[j] = (Score)lround(face[i].value[j]*SCORE_SCALE);
+        }
+
+        face[i].threshold = calloc(face[i].n_rings, sizeof(double));
+        face[i].threshold2 = calloc(face[i].n_rings, sizeof(double));
+        setFaceThresholds(&face[i], 0.0);
+        face[i].kernel = getFaceKernel(i);
+    }
+
     faceinit = 1;
 } /*}}}2*/
 
+static void setFaceThresholds(Face *f, double diameter) /*{{{2*/
+/*
+ * (Re)computes the ring thresholds of a face for a given arrow diameter
+ */
+{
+    int i;
+
+    for (i = 0; i < f->n_rings; i++) {
+        f->threshold[i] = f->radius[i] + diameter/2.0;
+        f->threshold2[i] = f->threshold[i] * f->threshold[i];
+    }
+    f->arrow_diameter = diameter;
+} /*}}}2*/
+
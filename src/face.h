@@ -51,9 +51,19 @@ typedef enum {
 
 #define N_FACES 19
 
+/*
+ * Scores are held as fixed point integers in tenths of a point. No face
+ * scores finer than tenths (significant_decimals <= 1), so all score
+ * arithmetic and comparisons are exact
+ */
+typedef int Score;
+
+#define SCORE_SCALE 10
+#define SCORE_TO_DOUBLE(s) ((double)(s)/SCORE_SCALE)
+
 /* --- Data types {{{1 */
 
-typedef struct {
+typedef struct Face {
     /*
      * Name of the target face
      */
@@ -72,6 +82,10 @@ typedef struct {
      * The value of the ring, same indices as radius array
      */
     double *value;
+    /*
+     * The value of the ring as fixed point Score (tenths)
+     */
+    Score  *points;
     /*
      * Number of siginificant decimals in scoring. This is used to decide
      * whether we use integer scoring (0 significant decimals) or decimal
@@ -83,10 +97,68 @@ typedef struct {
      * there is no second shootoff
      */
     int     ring_for_2nd_so;
+    /*
+     * Arrow diameter (in mm) the thresholds below are computed for
+     */
+    double  arrow_diameter;
+    /*
+     * Per ring (same indices as radius) the largest distance of the arrow
+     * centerline to the center of the face that still touches the ring,
+     * i.e. radius + arrow_diameter/2, and the square of it
+     */
+    double *threshold;
+    double *threshold2;
+    /*
+     * Scoring kernel specialized for this face (facekernels.c), returning
+     * the arrow points for a squared distance from center, or NULL to use
+     * the generic ring lookup
+     */
+    Score (*kernel)(const struct Face *face, double d2);
 } Face;
 
+typedef Score (*FaceKernel)(const Face *face, double d2);
+
 /* --- Prototypes {{{1 */
 
 Face *getFace(FaceType type);
+void initFaces(Face *faces, double diameter);
+void freeFaces(Face *faces);
+
+static inline int getRingFromDistance2(const Face *face, double d2) /*{{{2*/
+/*
+ * Returns the index of the ring hit (or -1 for a miss), where;
+ * face = Target face shot on
+ * d2 = squared distance (in mm^2) of arrow centerline to center of face
+ * Thresholds decrease with the ring index, so the ring hit is the number of
+ * thresholds not below d2, minus one. Small faces count branch free, faces
+ * with many rings (decimal scoring) use a binary search
+ */
+{
+    int n = face->n_rings;
+    int i;
+
+    if (n <= 16) {
+        int count = 0;
+        for (i = 0; i < n; i++) {
+            count += (d2 <= face->threshold2[i]);
+        }
+        return count-1;
+    }
+    else {
+        int lo = 0;
+        int hi = n;
+        /* Find first ring with threshold2 < d2 */
+        while (lo < hi) {
+            int mid = (lo+hi)/2;
+            if (d2 <= face->threshold2[mid]) {
+                lo = mid+1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        return lo-1;
+    }
+} /*}}}2*/
 
 #endif
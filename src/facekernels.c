@@ -0,0 +1,190 @@
+/*****************************************************************************
+*** Name      : facekernels.c                                              ***
+*** Purpose   : Scoring kernels specialized per target face type           ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+#include <stdio.h>
+#include <math.h>
+
+#include "facekernels.h"
+#include "dump.h"
+
+/* --- Kernel construction {{{1 */
+
+/*
+ * Each kernel returns the points (Score) of an arrow at squared distance d2 (in mm^2)
+ * of the center of the face. The ring radii are constants, so the kernel is
+ * a straight line of independent compares without loads from the face; the
+ * number of rings touched indexes a constant table of points in tenths
+ * (index 0 is a miss). Only half the arrow diameter is read from the face, as it is a run
+ * time option
+ */
+#define IN(r) (d2 <= ((r)+h)*((r)+h))
+
+#define FACE_KERNEL(name, count, ...)                                   \
+    static Score name(const Face *face, double d2)                      \
+    {                                                                   \
+        static const Score points[] = { 0, __VA_ARGS__ };               \
+        const double h = face->arrow_diameter/2.0;                      \
+        return points[count];                                           \
+    }
+
+/* --- Kernels {{{1 */
+
+FACE_KERNEL(kernelWA122cm10Rings,
+    IN(610.0) + IN(549.0) + IN(488.0) + IN(427.0) + IN(366.0) +
+    IN(305.0) + IN(244.0) + IN(183.0) + IN(122.0) + IN( 61.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelWA80cm10Rings,
+    IN(400.0) + IN(360.0) + IN(320.0) + IN(280.0) + IN(240.0) +
+    IN(200.0) + IN(160.0) + IN(120.0) + IN( 80.0) + IN( 40.0) + IN( 20.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 100)
+
+FACE_KERNEL(kernelWA80cm6Rings,
+    IN(240.0) + IN(200.0) + IN(160.0) + IN(120.0) + IN( 80.0) +
+    IN( 40.0) + IN( 20.0),
+    50, 60, 70, 80, 90, 100, 100)
+
+FACE_KERNEL(kernelWA60cm10Rings,
+    IN(300.0) + IN(270.0) + IN(240.0) + IN(210.0) + IN(180.0) +
+    IN(150.0) + IN(120.0) + IN( 90.0) + IN( 60.0) + IN( 30.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelWA60cm5Rings,
+    IN(150.0) + IN(120.0) + IN( 90.0) + IN( 60.0) + IN( 30.0),
+    60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelWA40cm5RingsRecurve,
+    IN(100.0) + IN( 80.0) + IN( 60.0) + IN( 40.0) + IN( 20.0),
+    60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelWA40cm5RingsCompound,
+    IN(100.0) + IN( 80.0) + IN( 60.0) + IN( 40.0) + IN( 10.0),
+    60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp38cm5RingsCompound,
+    IN( 90.0) + IN( 70.0) + IN( 50.0) + IN( 30.0) + IN( 10.0),
+    60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp40cm6RingsCompoundX11,
+    IN(100.0) + IN( 80.0) + IN( 60.0) + IN( 40.0) + IN( 20.0) +
+    IN( 10.0),
+    60, 70, 80, 90, 100, 110)
+
+FACE_KERNEL(kernelExp20cm10RingsCompound,
+    IN(100.0) + IN( 90.0) + IN( 80.0) + IN( 70.0) + IN( 60.0) +
+    IN( 50.0) + IN( 40.0) + IN( 30.0) + IN( 20.0) + IN( 10.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp36cm5RingsCompound,
+    IN( 81.0) + IN( 63.0) + IN( 45.0) + IN( 27.0) + IN(  9.0),
+    60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp32cm5RingsCompound,
+    IN( 72.0) + IN( 56.0) + IN( 40.0) + IN( 24.0) + IN(  8.0),
+    60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp80cm6RingsXScores11,
+    IN(240.0) + IN(200.0) + IN(160.0) + IN(120.0) + IN( 80.0) +
+    IN( 40.0) + IN( 20.0),
+    50, 60, 70, 80, 90, 100, 110)
+
+FACE_KERNEL(kernelExp122cmPinholeExtremeScore,
+    IN(610.0) + IN(549.0) + IN(488.0) + IN(427.0) + IN(366.0) +
+    IN(305.0) + IN(244.0) + IN(183.0) + IN(122.0) + IN( 61.0) + IN(  9.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 1000)
+
+FACE_KERNEL(kernelExp110cm10Rings,
+    IN(550.0) + IN(495.0) + IN(440.0) + IN(385.0) + IN(330.0) +
+    IN(275.0) + IN(220.0) + IN(165.0) + IN(110.0) + IN( 55.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp100cm10Rings,
+    IN(500.0) + IN(450.0) + IN(400.0) + IN(350.0) + IN(300.0) +
+    IN(250.0) + IN(200.0) + IN(150.0) + IN(100.0) + IN( 50.0),
+    10, 20, 30, 40, 50, 60, 70, 80, 90, 100)
+
+FACE_KERNEL(kernelExp200cm1Ring,
+    IN(1000.0),
+    100)
+
+FACE_KERNEL(kernelExp80cm12Rings,
+    IN(240.0) + IN(220.0) + IN(200.0) + IN(180.0) + IN(160.0) +
+    IN(140.0) + IN(120.0) + IN(100.0) + IN( 80.0) + IN( 60.0) +
+    IN( 40.0) + IN( 20.0),
+    45, 50, 55, 60, 65, 70, 75, 80, 85, 90, 95, 100)
+
+/* --- Implementation {{{1 */
+
+FaceKernel getFaceKernel(FaceType type) /*{{{2*/
+/*
+ * Returns the specialized kernel of a face type, or NULL if the face uses
+ * the generic ring lookup (the 60 ring decimal scoring face)
+ */
+{
+    switch (type) {
+        case WA_122CM_10RINGS:                return kernelWA122cm10Rings;
+        case WA_80CM_10RINGS:                 return kernelWA80cm10Rings;
+        case WA_80CM_6RINGS:                  return kernelWA80cm6Rings;
+        case WA_60CM_10RINGS:                 return kernelWA60cm10Rings;
+        case WA_60CM_5RINGS:                  return kernelWA60cm5Rings;
+        case WA_40CM_5RINGS_RECURVE:          return kernelWA40cm5RingsRecurve;
+        case WA_40CM_5RINGS_COMPOUND:         return kernelWA40cm5RingsCompound;
+        case EXP_38CM_5RINGS_COMPOUND:        return kernelExp38cm5RingsCompound;
+        case EXP_40CM_6RINGS_COMPOUND_X11:    return kernelExp40cm6RingsCompoundX11;
+        case EXP_20CM_10RINGS_COMPOUND:       return kernelExp20cm10RingsCompound;
+        case EXP_36CM_5RINGS_COMPOUND:        return kernelExp36cm5RingsCompound;
+        case EXP_32CM_5RINGS_COMPOUND:        return kernelExp32cm5RingsCompound;
+        case EXP_80CM_6RINGS_X_SCORES_11:     return kernelExp80cm6RingsXScores11;
+        case EXP_80CM_6RINGS_DECIMAL_SCORING: return NULL;
+        case EXP_122CM_PINHOLE_EXTREMESCORE:  return kernelExp122cmPinholeExtremeScore;
+        case EXP_110CM_10RINGS:               return kernelExp110cm10Rings;
+        case EXP_100CM_10RINGS:               return kernelExp100cm10Rings;
+        case EXP_200CM_1RING:                 return kernelExp200cm1Ring;
+        case EXP_80CM_12RINGS:                return kernelExp80cm12Rings;
+    }
+    return NULL;
+} /*}}}2*/
+
+void checkFaceKernel(const Face *face) /*{{{2*/
+/*
+ * Verifies the kernel of a face against the ring data of the face, on and
+ * just outside every ring threshold. The kernels duplicate the radii and
+ * values of face.c, so a change there must be made here too
+ */
+{
+    int i;
+
+    if (face->kernel == NULL) return;
+
+    for (i = 0; i < face->n_rings; i++) {
+        double d2 = face->threshold2[i];
+        Score outside = (i == 0) ? 0 : face->points[i-1];
+
+        if (face->kernel(face, d2) != face->points[i] ||
+            face->kernel(face, nextafter(d2, INFINITY)) != outside) {
+            fprintf(stderr, "Kernel of '%s' differs at ring %d\n", face->name, i);
+            fatal("checkFaceKernel() kernel does not match face");
+        }
+    }
+} /*}}}2*/
@@ -34,7 +34,7 @@
 
 extern int pretty_print;
 
-Format q_format = {
+const Format default_q_format = {
     "QFormat",
     70.0,
     WA_122CM_10RINGS,
@@ -43,7 +43,7 @@ Format q_format = {
     0
 };
 
-Format e_format = {
+const Format default_e_format = {
     "EFormat",
     70.0,
     WA_122CM_10RINGS,
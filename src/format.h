@@ -53,14 +53,14 @@ typedef struct {
 /* --- Interface {{{1*/
 
 /*
- * Qualification format
+ * Default qualification format (of a new SimulationContext)
  */
-extern Format q_format;
+extern const Format default_q_format;
 
 /*
- * Elimination format
+ * Default elimination format (of a new SimulationContext)
  */
-extern Format e_format;
+extern const Format default_e_format;
 
 const char *getFormatName(const Format *format);
 
@@ -30,6 +30,7 @@
 #include "archer.h"
 #include "dump.h"
 #include "format.h"
+#include "context.h"
 #include "interactive.h"
 #include "qualification.h"
 #include "elimination.h"
@@ -58,8 +59,8 @@ extern double xt2asl2;
 /* --- Local prototypes {{{1*/
 
 static void interactiveSkillLevelRange(void);
-static void interactiveQualificationFormat(void);
-static void interactiveEliminationFormat(void);
+static void interactiveQualificationFormat(SimulationContext *ctx);
+static void interactiveEliminationFormat(SimulationContext *ctx);
 static void interactiveASLDistribution(double*, double*, double*, double*, double*, double*, double*);
 static void interactiveFormatName(Format *format);
 static void interactiveTargetFace(Format *fmt);
@@ -69,7 +70,7 @@ static int requestInt(const char *str, int default_val);
 
 /* --- Implementation {{{1*/
 
-void interactiveASLSimulation(void) /*{{{2*/
+void interactiveASLSimulation(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("ARCHER SKILL LEVEL SIMULATION\n");
@@ -79,12 +80,12 @@ void interactiveASLSimulation(void) /*{{{2*/
 
     interactiveSkillLevelRange();
     q_nruns = requestInt("Number of runs per archer", q_nruns);
-    interactiveQualificationFormat();
-    interactiveFormatName(&q_format);
+    interactiveQualificationFormat(ctx);
+    interactiveFormatName(&ctx->q_format);
     interactiveOutput();
 } /*}}}2*/
 
-void interactiveQualificationRoundSimulation(void) /*{{{2*/
+void interactiveQualificationRoundSimulation(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("QUALIFICATION ROUND SIMULATION\n");
@@ -93,12 +94,12 @@ void interactiveQualificationRoundSimulation(void) /*{{{2*/
     printf("With set of archers with distributed Archers Skill Level\n\n");
 
     interactiveASLDistribution(&asl1, &asl4, &asl8, &asl16, &asl32, &asl56, &asl104);
-    interactiveQualificationFormat();
+    interactiveQualificationFormat(ctx);
     q_nruns = requestInt("Number of runs per archer", q_nruns);
     interactiveOutput();
 } /*}}}2*/
 
-void interactiveCompetitionSimulation(void) /*{{{2*/
+void interactiveCompetitionSimulation(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("SINGLE COMPETITION SIMULATION\n");
@@ -107,13 +108,13 @@ void interactiveCompetitionSimulation(void) /*{{{2*/
     printf("followed by an eliminationround with distributed Archers Skill Levels\n\n");
 
     interactiveASLDistribution(&asl1, &asl4, &asl8, &asl16, &asl32, &asl56, &asl104);
-    interactiveQualificationFormat();
-    interactiveEliminationFormat();
+    interactiveQualificationFormat(ctx);
+    interactiveEliminationFormat(ctx);
     interactiveOutput();
 
 } /*}}}2*/
 
-void interactiveCompetitionsSimulation(void) /*{{{2*/
+void interactiveCompetitionsSimulation(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("COMPETITIONS SIMULATION\n");
@@ -122,13 +123,13 @@ void interactiveCompetitionsSimulation(void) /*{{{2*/
     printf("Performing according to its Archers Skill Level\n\n");
 
     interactiveASLDistribution(&asl1, &asl4, &asl8, &asl16, &asl32, &asl56, &asl104);
-    interactiveQualificationFormat();
-    interactiveEliminationFormat();
+    interactiveQualificationFormat(ctx);
+    interactiveEliminationFormat(ctx);
     q_nruns = requestInt("Number of times for entire round simulation", q_nruns);
     interactiveOutput();
 } /*}}}2*/
 
-void interactiveEliminationStats(void) /*{{{2*/
+void interactiveEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("ELIMINATION STATISTICS\n");
@@ -138,12 +139,12 @@ void interactiveEliminationStats(void) /*{{{2*/
 
     interactiveSkillLevelRange();
     e_nruns = requestInt("Number of simulations", e_nruns);
-    interactiveEliminationFormat();
-    interactiveFormatName(&e_format);
+    interactiveEliminationFormat(ctx);
+    interactiveFormatName(&ctx->e_format);
     interactiveOutput();
 } /*}}}2*/
 
-void interactiveTeamEliminationStats() /*{{{2*/
+void interactiveTeamEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("TEAM ELIMINATION STATISTICS\n");
@@ -162,12 +163,12 @@ void interactiveTeamEliminationStats() /*{{{2*/
 
     interactiveSkillLevelRange();
     e_nruns = requestInt("\nNumber of simulations", e_nruns);
-    interactiveEliminationFormat();
-    interactiveFormatName(&e_format);
+    interactiveEliminationFormat(ctx);
+    interactiveFormatName(&ctx->e_format);
     interactiveOutput();
 } /*}}}2*/
 
-void interactiveMixedTeamEliminationStats() /*{{{2*/
+void interactiveMixedTeamEliminationStats(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("MIXED-TEAM ELIMINATION STATISTICS\n");
@@ -182,8 +183,8 @@ void interactiveMixedTeamEliminationStats() /*{{{2*/
     xt2asl1 = requestDouble("Archers Skill Level archer #1", xt2asl1);
     xt2asl2 = requestDouble("Archers Skill Level archer #2", xt2asl2);
     e_nruns = requestInt("\nNumber of simulations", e_nruns);
-    interactiveEliminationFormat();
-    interactiveFormatName(&e_format);
+    interactiveEliminationFormat(ctx);
+    interactiveFormatName(&ctx->e_format);
     interactiveOutput();
 } /*}}}2*/
 
@@ -199,23 +200,23 @@ static void interactiveSkillLevelRange(void) /*{{{2*/
     }
 } /*}}}2*/
 
-static void interactiveQualificationFormat(void) /*{{{2*/
+static void interactiveQualificationFormat(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("QUALIFICATION FORMAT\n");
     printf("====================\n");
-    interactiveTargetFace(&q_format);
-    q_format.type = CUMULATIVE;
-    q_format.narrows = requestInt("Cumulative scoring for how many arrows", q_format.narrows);
+    interactiveTargetFace(&ctx->q_format);
+    ctx->q_format.type = CUMULATIVE;
+    ctx->q_format.narrows = requestInt("Cumulative scoring for how many arrows", ctx->q_format.narrows);
 } /*}}}2*/
 
-static void interactiveEliminationFormat(void) /*{{{2*/
+static void interactiveEliminationFormat(SimulationContext *ctx) /*{{{2*/
 {
     printf("\n");
     printf("ELIMINATION FORMAT\n");
     printf("==================\n");
-    interactiveTargetFace(&e_format);
-    interactiveMatchFormat(&e_format);
+    interactiveTargetFace(&ctx->e_format);
+    interactiveMatchFormat(&ctx->e_format);
 } /*}}}2*/
 
 static void interactiveASLDistribution(double *a1, double *a4, double *a8, double *a16, double *a32, double *a56, double *a104) /*{{{2*/
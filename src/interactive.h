@@ -30,12 +30,14 @@
 
 extern int interactive;
 
-void interactiveASLSimulation(void);
-void interactiveQualificationRoundSimulation(void);
-void interactiveEliminationStats(void);
-void interactiveTeamEliminationStats(void);
-void interactiveMixedTeamEliminationStats(void);
-void interactiveCompetitionSimulation(void);
-void interactiveCompetitionsSimulation(void);
+struct SimulationContext;
+
+void interactiveASLSimulation(struct SimulationContext *ctx);
+void interactiveQualificationRoundSimulation(struct SimulationContext *ctx);
+void interactiveEliminationStats(struct SimulationContext *ctx);
+void interactiveTeamEliminationStats(struct SimulationContext *ctx);
+void interactiveMixedTeamEliminationStats(struct SimulationContext *ctx);
+void interactiveCompetitionSimulation(struct SimulationContext *ctx);
+void interactiveCompetitionsSimulation(struct SimulationContext *ctx);
 
 #endif
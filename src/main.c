@@ -28,11 +28,14 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <string.h>
+#include <ctype.h>
 #include <time.h>
 
 #include "random.h"
 #include "asl_distribution.h"
 #include "dump.h"
+#include "checkpoint.h"
+#include "progress.h"
 #include "face.h"
 #include "modes.h"
 #include "format.h"
@@ -40,6 +43,8 @@
 #include "qualification.h"
 #include "elimination.h"
 #include "interactive.h"
+#include "context.h"
+#include "pool.h"
 
 /* --- Global data {{{1*/
 
@@ -51,103 +56,221 @@ int pretty_print = 0;
 /* Default with progress */
 int with_progress = 0;
 
+/* Default single threaded */
+int n_threads = 1;
+
+/* Default all runs in one process (shard 1 of 1), no partial results */
+int shard = 1;
+int n_shards = 1;
+char *partial_out = NULL;
+char **merge_files = NULL;
+int n_merge_files = 0;
+
+/* Default no result cache */
+char *cache_dir = NULL;
+
+/* Default no match event log, event log read by --scan-event-log */
+char *event_log = NULL;
+char *scan_event_log = NULL;
+
 /* Default single match values */
 double start_asl =  75.0;
 double end_asl   = 120.0;
 double step_asl  =   1.0;
 
-double arrow_diameter = ARROW_DIAMETER;
-
-long seed = 0L;
+/* --- Local data types {{{1*/
+
+/*
+ * Options of the command line (globals and context settings); every
+ * scenario of a batch starts from these and applies its own options
+ */
+typedef struct {
+    int           mode;
+    Format        q_format;
+    Format        e_format;
+    double        arrow_diameter;
+    long          seed;
+    double        asl[7];
+    double        team_asl[10];
+    char         *name_of_population;
+    double        start_asl;
+    double        end_asl;
+    double        step_asl;
+    int           q_nruns;
+    int           e_nruns;
+    int           e_exact;
+    int           fast_bracket;
+    int           high_loser;
+    int           cut_high_loser;
+    int           pretty_print;
+    OutputFormat  output_format;
+    int           async_output;
+    int           resume;
+    int           with_progress;
+    double        interim_interval;
+    int           interactive;
+    int           n_threads;
+    ArrowSampler  arrow_sampler;
+    char         *output_name;
+    char         *cache_dir;
+} Options;
+
+/* --- Local data {{{1*/
+
+/* Maximum number of options of a batch scenario */
+#define MAX_SCENARIO_ARGS 256
+
+/* Batch file (--batch) and the last output file given (--output) */
+static char *batch_file = NULL;
+static char *output_name = NULL;
+
+static struct option long_options[] = {
+
+    { "score",                     no_argument,       NULL, MODE_SCORE },
+    { "qualification",             no_argument,       NULL, MODE_QUALIFICATION },
+    { "elimination",               no_argument,       NULL, MODE_ELIMINATION },
+    { "team-elimination",          no_argument,       NULL, MODE_TEAM_ELIMINATION },
+    { "mixed-team-elimination",    no_argument,       NULL, MODE_MIXED_TEAM_ELIMINATION },
+    { "competition",               no_argument,       NULL, MODE_COMPETITION },
+    { "competitions",              no_argument,       NULL, MODE_COMPETITIONS },
+    { "check-arrow-sampler",       no_argument,       NULL, MODE_CHECK_ARROW_SAMPLER },
+    { "scan-event-log",            required_argument, NULL, MODE_SCAN_EVENT_LOG },
+
+    { "interactive",               no_argument,       NULL, 906 },
+    { "output",                    required_argument, NULL, 907 },
+    { "output-append",             required_argument, NULL, 917 },
+    { "help",                      no_argument,       NULL, 908 },
+
+    { "level-1",                   required_argument, NULL, 1000 },
+    { "level-4",                   required_argument, NULL, 1001 },
+    { "level-8",                   required_argument, NULL, 1002 },
+    { "level-16",                  required_argument, NULL, 1003 },
+    { "level-32",                  required_argument, NULL, 1004 },
+    { "level-56",                  required_argument, NULL, 1005 },
+    { "level-104",                 required_argument, NULL, 1006 },
+    { "level-name",                required_argument, NULL, 1007 },
+
+    { "team1-level-1",             required_argument, NULL, 1011 },
+    { "team1-level-2",             required_argument, NULL, 1012 },
+    { "team1-level-3",             required_argument, NULL, 1013 },
+    { "team2-level-1",             required_argument, NULL, 1021 },
+    { "team2-level-2",             required_argument, NULL, 1022 },
+    { "team2-level-3",             required_argument, NULL, 1023 },
+
+    { "start-level",               required_argument, NULL, 1100 },
+    { "end-level",                 required_argument, NULL, 1101 },
+    { "level-step",                required_argument, NULL, 1102 },
+
+    { "distance",                  required_argument, NULL, 1103 },
+
+    { "target-face",               required_argument, NULL, 1104 },
+
+    { "arrow-diameter",            required_argument, NULL, 1126 },
+
+    { "n-arrows",                  required_argument, NULL, 1105 },
+    { "n-arrows-qualification",    required_argument, NULL, 1115 },
+    { "n-arrows-elimination",      required_argument, NULL, 1125 },
+
+    { "best-of-sets",              required_argument, NULL, 1106 },
+
+    { "format-name",               required_argument, NULL, 1107 },
+    { "format-name-qualification", required_argument, NULL, 1117 },
+    { "format-name-elimination",   required_argument, NULL, 1127 },
+
+    { "format",                    required_argument, NULL, 1108 },
+    { "format-qualification",      required_argument, NULL, 1118 },
+    { "format-elimination",        required_argument, NULL, 1128 },
+
+    { "n-runs",                    required_argument, NULL, 1200 },
+    { "n-runs-qualification",      required_argument, NULL, 1210 },
+    { "n-runs-elimination",        required_argument, NULL, 1220 },
+    { "exact",                     no_argument,       NULL, 1221 },
+    { "fast-bracket",              no_argument,       NULL, 1222 },
+
+    { "cut-high-loser",            required_argument, NULL, 1301 },
+    { "high-loser",                required_argument, NULL, 1302 },
+
+    { "pretty-print",              no_argument,       NULL, 1400 },
+    { "seed",                      required_argument, NULL, 1401 },
+    { "progress",                  no_argument,       NULL, 1402 },
+    { "arrow-sampler",             required_argument, NULL, 1403 },
+    { "threads",                   required_argument, NULL, 1404 },
+    { "shard",                     required_argument, NULL, 1405 },
+    { "partial-out",               required_argument, NULL, 1406 },
+    { "merge",                     no_argument,       NULL, 1407 },
+    { "batch",                     required_argument, NULL, 1408 },
+    { "cache-dir",                 required_argument, NULL, 1409 },
+    { "output-format",             required_argument, NULL, 1410 },
+    { "async-output",              no_argument,       NULL, 1411 },
+    { "event-log",                 required_argument, NULL, 1412 },
+    { "checkpoint",                required_argument, NULL, 1413 },
+    { "resume",                    no_argument,       NULL, 1414 },
+    { "interim-stats",             required_argument, NULL, 1415 },
+
+
+    { "arrow-diameter",            required_argument, NULL, 999 },
+
+    {0,0,0,0}
+};
 
 /* --- Local prototypes {{{1*/
 
+static int parseOptions(SimulationContext *ctx, int argc, char *argv[], int *mode);
+static int runMode(SimulationContext *ctx, int mode);
+static int runBatch(SimulationContext *ctx, const char *filename, int mode);
+static char *readScenario(FILE *fp, int *n_line);
+static int splitScenario(char *line, char **args, int max);
+static void saveOptions(Options *options, const SimulationContext *ctx, int mode);
+static void restoreOptions(const Options *options, SimulationContext *ctx, int *mode);
 static void help();
 
 /* --- Implementation {{{1*/
 
 int main(int argc, char *argv[]) /*{{{2*/
 {
-    int i = 0;
-    int j = 0;
-    int tcnt = 0;
-    int cnt = 0;
-    int opt = 0;
-
     int mode = 0; /* No mode */
+    int status;
 
-    int option_index = 0;
-    static struct option long_options[] = {
-
-        { "score",                     no_argument,       NULL, MODE_SCORE },
-        { "qualification",             no_argument,       NULL, MODE_QUALIFICATION },
-        { "elimination",               no_argument,       NULL, MODE_ELIMINATION },
-        { "team-elimination",          no_argument,       NULL, MODE_TEAM_ELIMINATION },
-        { "mixed-team-elimination",    no_argument,       NULL, MODE_MIXED_TEAM_ELIMINATION },
-        { "competition",               no_argument,       NULL, MODE_COMPETITION },
-        { "competitions",              no_argument,       NULL, MODE_COMPETITIONS },
-
-        { "interactive",               no_argument,       NULL, 906 },
-        { "output",                    required_argument, NULL, 907 },
-        { "output-append",             required_argument, NULL, 917 },
-        { "help",                      no_argument,       NULL, 908 },
-
-        { "level-1",                   required_argument, NULL, 1000 },
-        { "level-4",                   required_argument, NULL, 1001 },
-        { "level-8",                   required_argument, NULL, 1002 },
-        { "level-16",                  required_argument, NULL, 1003 },
-        { "level-32",                  required_argument, NULL, 1004 },
-        { "level-56",                  required_argument, NULL, 1005 },
-        { "level-104",                 required_argument, NULL, 1006 },
-        { "level-name",                required_argument, NULL, 1007 },
-
-        { "team1-level-1",             required_argument, NULL, 1011 },
-        { "team1-level-2",             required_argument, NULL, 1012 },
-        { "team1-level-3",             required_argument, NULL, 1013 },
-        { "team2-level-1",             required_argument, NULL, 1021 },
-        { "team2-level-2",             required_argument, NULL, 1022 },
-        { "team2-level-3",             required_argument, NULL, 1023 },
-
-        { "start-level",               required_argument, NULL, 1100 },
-        { "end-level",                 required_argument, NULL, 1101 },
-        { "level-step",                required_argument, NULL, 1102 },
+    SimulationContext *ctx = getDefaultContext();
 
-        { "distance",                  required_argument, NULL, 1103 },
+    /* Arrow diameter of the population (asl_distribution.h) unless given */
+    ctx->arrow_diameter = ARROW_DIAMETER;
 
-        { "target-face",               required_argument, NULL, 1104 },
-
-        { "arrow-diameter",            required_argument, NULL, 1126 },
-
-        { "n-arrows",                  required_argument, NULL, 1105 },
-        { "n-arrows-qualification",    required_argument, NULL, 1115 },
-        { "n-arrows-elimination",      required_argument, NULL, 1125 },
-
-        { "best-of-sets",              required_argument, NULL, 1106 },
-
-        { "format-name",               required_argument, NULL, 1107 },
-        { "format-name-qualification", required_argument, NULL, 1117 },
-        { "format-name-elimination",   required_argument, NULL, 1127 },
-
-        { "format",                    required_argument, NULL, 1108 },
-        { "format-qualification",      required_argument, NULL, 1118 },
-        { "format-elimination",        required_argument, NULL, 1128 },
-
-        { "n-runs",                    required_argument, NULL, 1200 },
-        { "n-runs-qualification",      required_argument, NULL, 1210 },
-        { "n-runs-elimination",        required_argument, NULL, 1220 },
-
-        { "cut-high-loser",            required_argument, NULL, 1301 },
-        { "high-loser",                required_argument, NULL, 1302 },
+    status = parseOptions(ctx, argc, argv, &mode);
+    if (status != 0) {
+        /* Error, or help given */
+        return (status < 0) ? 0 : status;
+    }
 
-        { "pretty-print",              no_argument,       NULL, 1400 },
-        { "seed",                      required_argument, NULL, 1401 },
-        { "progress",                  no_argument,       NULL, 1402 },
+    if (batch_file != NULL) {
+        status = runBatch(ctx, batch_file, mode);
+    }
+    else {
+        startSimulationContext(ctx);
+        runMode(ctx, mode);
+    }
 
+    outp_close();
+    return status;
+} /*}}}2*/
 
-        { "arrow-diameter",            required_argument, NULL, 999 },
+/* --- Internals {{{1*/
+
+static int parseOptions(SimulationContext *ctx, int argc, char *argv[], int *mode) /*{{{2*/
+/*
+ * Applies command line options to the globals and the context, where;
+ * ctx = context to set up
+ * argc, argv = options (argv[0] is the program name)
+ * mode = set to the mode given (unchanged if none)
+ * Returns 0 when the options are fine, 1 on an error and -1 when only the
+ * help was asked for
+ */
+{
+    int option_index = 0;
+    int opt = 0;
 
-        {0,0,0,0}
-    };
+    /* Rescan from the start, a batch parses an argument list per scenario */
+    optind = 0;
 
     while ( (opt = getopt_long(argc, argv, "", long_options, &option_index)) != -1) {
 
@@ -172,42 +295,90 @@ int main(int argc, char *argv[]) /*{{{2*/
         case 1101: end_asl   = atof(optarg); break;
         case 1102: step_asl  = atof(optarg); break;
 
-        case 1103: q_format.distance = e_format.distance = atof(optarg); break;
+        case 1103: ctx->q_format.distance = ctx->e_format.distance = atof(optarg); break;
 
-        case 1104: q_format.facetype = e_format.facetype = atoi(optarg); break;
+        case 1104: ctx->q_format.facetype = ctx->e_format.facetype = atoi(optarg); break;
 
-        case 1105: q_format.narrows = e_format.narrows = atoi(optarg); break;
-        case 1115: q_format.narrows = atoi(optarg); break;
-        case 1125: e_format.narrows = atoi(optarg); break;
-        case 1126: arrow_diameter = (double)atof(optarg); break;
+        case 1105: ctx->q_format.narrows = ctx->e_format.narrows = atoi(optarg); break;
+        case 1115: ctx->q_format.narrows = atoi(optarg); break;
+        case 1125: ctx->e_format.narrows = atoi(optarg); break;
+        case 1126: ctx->arrow_diameter = (double)atof(optarg); break;
 
-        case 1106: q_format.best_of = e_format.best_of = atoi(optarg); break;
+        case 1106: ctx->q_format.best_of = ctx->e_format.best_of = atoi(optarg); break;
 
         case 1107:
-            strcpy(q_format.name, optarg);
-            strcpy(e_format.name, optarg);
+            strcpy(ctx->q_format.name, optarg);
+            strcpy(ctx->e_format.name, optarg);
             break;
         case 1117:
-            strcpy(q_format.name, optarg);
+            strcpy(ctx->q_format.name, optarg);
             break;
         case 1127:
-            strcpy(e_format.name, optarg);
+            strcpy(ctx->e_format.name, optarg);
             break;
 
-        case 1108: q_format.type = e_format.type = atoi(optarg); break;
-        case 1118: q_format.type = atoi(optarg); break;
-        case 1128: e_format.type = atoi(optarg); break;
+        case 1108: ctx->q_format.type = ctx->e_format.type = atoi(optarg); break;
+        case 1118: ctx->q_format.type = atoi(optarg); break;
+        case 1128: ctx->e_format.type = atoi(optarg); break;
 
         case 1200: q_nruns = e_nruns = atoi(optarg); break;
         case 1210: q_nruns = atoi(optarg); break;
         case 1220: e_nruns = atoi(optarg); break;
+        case 1221: e_exact = 1; break;
+        case 1222: fast_bracket = 1; break;
 
         case 1301: cut_high_loser = atoi(optarg); break;
         case 1302: high_loser = atoi(optarg); break;
 
-        case 1400: pretty_print = 1; break;
-        case 1401: seed = (long)atoi(optarg); break;
+        case 1400: pretty_print = 1; output_format = OUTPUT_TEXT; break;
+        case 1401: ctx->seed = (long)atoi(optarg); break;
         case 1402: with_progress = 1; break;
+        case 1404: n_threads = atoi(optarg); break;
+        case 1405:
+            if (sscanf(optarg, "%d/%d", &shard, &n_shards) != 2 || n_shards < 1 || shard < 1 || shard > n_shards) {
+                fprintf(stderr, "Invalid shard '%s' (use <i>/<n> with 1 <= i <= n)\n", optarg);
+                return 1;
+            }
+            break;
+        case 1406: partial_out = strdup(optarg); break;
+        case 1407: n_merge_files = -1; break;
+        case 1408: batch_file = optarg; break;
+        case 1409: cache_dir = strdup(optarg); break;
+        case 1410:
+            if (strcmp(optarg, "text") == 0) {
+                pretty_print = 1;
+                output_format = OUTPUT_TEXT;
+            }
+            else if (strcmp(optarg, "csv") == 0) {
+                pretty_print = 0;
+                output_format = OUTPUT_CSV;
+            }
+            else if (strcmp(optarg, "binary") == 0) {
+                pretty_print = 0;
+                output_format = OUTPUT_BINARY;
+            }
+            else {
+                fprintf(stderr, "Invalid output format '%s' (use text, csv or binary)\n", optarg);
+                return 1;
+            }
+            break;
+        case 1411: async_output = 1; break;
+        case 1412: event_log = strdup(optarg); break;
+        case 1413: checkpoint_file = strdup(optarg); break;
+        case 1414: resume = 1; break;
+        case 1415:
+            interim_interval = atof(optarg);
+            if (interim_interval <= 0.0) {
+                fprintf(stderr, "Invalid interim statistics interval '%s' (seconds > 0)\n", optarg);
+                return 1;
+            }
+            break;
+        case 1403:
+            if (setArrowSampler(optarg) != 0) {
+                fprintf(stderr, "Unknown arrow sampler '%s' (use alias, rayleigh or gaussian2d)\n", optarg);
+                return 1;
+            }
+            break;
 
         case MODE_SCORE:
         case MODE_QUALIFICATION:
@@ -216,7 +387,13 @@ int main(int argc, char *argv[]) /*{{{2*/
         case MODE_MIXED_TEAM_ELIMINATION:
         case MODE_COMPETITION:
         case MODE_COMPETITIONS:
-            mode = opt;
+        case MODE_CHECK_ARROW_SAMPLER:
+            *mode = opt;
+            break;
+
+        case MODE_SCAN_EVENT_LOG:
+            *mode = opt;
+            scan_event_log = strdup(optarg);
             break;
 
         case 906:
@@ -225,58 +402,417 @@ int main(int argc, char *argv[]) /*{{{2*/
 
         case 907:
             getOutput(optarg, "w");
+            output_name = optarg;
             break;
 
         case 917:
             getOutput(optarg, "a");
+            output_name = optarg;
             break;
 
         case 908:
             help();
-            return 0;
+            return -1;
 
-        case 999: arrow_diameter = atof(optarg); break;
+        case 999: ctx->arrow_diameter = atof(optarg); break;
         }
     }
 
-    initRandomGenerator();
+    if (n_merge_files < 0) {
+        /* Partial result files to merge are the remaining arguments */
+        merge_files = &argv[optind];
+        n_merge_files = argc - optind;
+        if (n_merge_files == 0) {
+            fprintf(stderr, "--merge requires the partial result files to merge\n");
+            return 1;
+        }
+    }
+    if ((n_shards > 1 || partial_out != NULL || n_merge_files > 0) && ctx->seed == 0L) {
+        /* A clock seed would make every shard a different study */
+        fprintf(stderr, "--shard, --partial-out and --merge require --seed\n");
+        return 1;
+    }
+    if ((n_shards > 1 || partial_out != NULL || n_merge_files > 0) &&
+        !(*mode == MODE_COMPETITIONS ||
+          (!e_exact && (*mode == MODE_ELIMINATION || *mode == MODE_TEAM_ELIMINATION ||
+                        *mode == MODE_MIXED_TEAM_ELIMINATION)))) {
+        fprintf(stderr, "--shard, --partial-out and --merge are only supported with --competitions and the (simulated) elimination matrices\n");
+        return 1;
+    }
+    if (cache_dir != NULL && *mode == MODE_COMPETITIONS && ctx->seed == 0L) {
+        fprintf(stderr, "--cache-dir requires --seed\n");
+        return 1;
+    }
+    if (event_log != NULL && (*mode != MODE_COMPETITIONS || n_merge_files > 0 || cache_dir != NULL)) {
+        /* Events are only known for the runs simulated */
+        fprintf(stderr, "--event-log is only supported with --competitions (without --merge or --cache-dir)\n");
+        return 1;
+    }
+    if (checkpoint_file != NULL) {
+        if (*mode != MODE_COMPETITIONS && *mode != MODE_ELIMINATION &&
+            *mode != MODE_TEAM_ELIMINATION && *mode != MODE_MIXED_TEAM_ELIMINATION) {
+            fprintf(stderr, "--checkpoint is only supported with --competitions and the elimination matrices\n");
+            return 1;
+        }
+        if (ctx->seed == 0L) {
+            /* A clock seed would make the resumed runs another study */
+            fprintf(stderr, "--checkpoint requires --seed\n");
+            return 1;
+        }
+        if (n_merge_files > 0 || event_log != NULL) {
+            fprintf(stderr, "--checkpoint cannot be combined with --merge or --event-log\n");
+            return 1;
+        }
+    }
+    if (resume && checkpoint_file == NULL) {
+        fprintf(stderr, "--resume requires --checkpoint\n");
+        return 1;
+    }
+    if (n_shards > 1 && (partial_out == NULL || n_merge_files > 0)) {
+        fprintf(stderr, "--shard requires --partial-out (and cannot be merged into)\n");
+        return 1;
+    }
+
+    return 0;
+} /*}}}2*/
 
+static int runMode(SimulationContext *ctx, int mode) /*{{{2*/
+/*
+ * Runs the simulation of a mode on a started context, returns 0 (or 1 when
+ * no mode is given)
+ */
+{
     switch (mode) {
     case MODE_SCORE:
-        modeScore();
+        modeScore(ctx);
         break;
 
     case MODE_QUALIFICATION:
-        modeQualification();
+        modeQualification(ctx);
         break;
 
     case MODE_ELIMINATION:
-        modeElimination();
+        modeElimination(ctx);
         break;
 
     case MODE_TEAM_ELIMINATION:
-        modeTeamElimination();
+        modeTeamElimination(ctx);
         break;
 
     case MODE_MIXED_TEAM_ELIMINATION:
-        modeMixedTeamElimination();
+        modeMixedTeamElimination(ctx);
         break;
 
     case MODE_COMPETITION:
-        modeCompetition();
+        modeCompetition(ctx);
         break;
 
     case MODE_COMPETITIONS:
-        modeCompetitions();
+        modeCompetitions(ctx);
+        break;
+
+    case MODE_CHECK_ARROW_SAMPLER:
+        modeCheckArrowSampler(ctx);
+        break;
+
+    case MODE_SCAN_EVENT_LOG:
+        modeScanEventLog(ctx);
         break;
 
     default:
         fprintf(stderr, "Mode option is required!\n");
+        return 1;
     }
 
     return 0;
 } /*}}}2*/
 
+static int runBatch(SimulationContext *ctx, const char *filename, int mode) /*{{{2*/
+/*
+ * Runs the scenarios of a batch file one after the other in this process,
+ * where;
+ * ctx = context set up by the command line
+ * filename = batch file, a scenario per line; its name followed by options
+ *            (as on the command line, quotes group, '\' continues a line and
+ *            '#' starts a comment)
+ * mode = mode of the command line
+ * Every scenario starts from the command line options. The context is
+ * reused, so scenarios with the same arrow diameter share the target faces
+ * and the score tables built for them (skill level, face and distance).
+ * Results are tagged with the scenario name. Returns 0, or 1 when a
+ * scenario failed
+ */
+{
+    char *options_batch = batch_file;
+    Options options;
+    FILE *fp;
+    char *scenario;
+    int n_line = 0;
+    int n_failed = 0;
+    int status;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open batch file %s\n", filename);
+        return 1;
+    }
+
+    saveOptions(&options, ctx, mode);
+
+    while ((scenario = readScenario(fp, &n_line)) != NULL) {
+        char *args[MAX_SCENARIO_ARGS+1];
+        char *name;
+        int n_args;
+
+        args[0] = "archerystats";
+        n_args = splitScenario(scenario, &args[1], MAX_SCENARIO_ARGS);
+        if (n_args == 0) {
+            /* Empty line or comment */
+            free(scenario);
+            continue;
+        }
+        if (n_args < 0 || strncmp(args[1], "--", 2) == 0) {
+            fprintf(stderr, "%s:%d: %s\n", filename, n_line,
+                    (n_args < 0) ? "too many options" : "scenario name expected before the options");
+            n_failed++;
+            free(scenario);
+            continue;
+        }
+
+        /* Options follow the name, in place of the program name */
+        name = args[1];
+        args[1] = args[0];
+
+        restoreOptions(&options, ctx, &mode);
+        if (output_name != NULL) {
+            getOutput(output_name, "a");
+        }
+        status = parseOptions(ctx, n_args, &args[1], &mode);
+        if (batch_file != options_batch) {
+            fprintf(stderr, "%s:%d: --batch cannot be nested\n", filename, n_line);
+            batch_file = options_batch;
+            status = 1;
+        }
+        if (status == 0) {
+            startSimulationContext(ctx);
+            if (pretty_print) {
+                outp("\nSCENARIO: %s\n", name);
+            }
+            else if (output_format == OUTPUT_BINARY) {
+                char table[256];
+
+                snprintf(table, sizeof(table), "scenario:%s", name);
+                beginTable(table, 0, NULL);
+            }
+            else {
+                outp("\"scenario\";\"%s\"\n", name);
+            }
+            status = runMode(ctx, mode);
+        }
+        if (status > 0) {
+            fprintf(stderr, "%s:%d: scenario %s failed\n", filename, n_line, name);
+            n_failed++;
+        }
+        outp_close();
+
+        free(scenario);
+    }
+    fclose(fp);
+
+    return (n_failed > 0) ? 1 : 0;
+} /*}}}2*/
+
+static char *readScenario(FILE *fp, int *n_line) /*{{{2*/
+/*
+ * Returns the next scenario of a batch file (allocated, lines ending in '\'
+ * joined) or NULL at the end of the file, where;
+ * fp = batch file
+ * n_line = number of lines read, updated
+ */
+{
+    char *scenario = NULL;
+    size_t len = 0;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t n;
+
+    while ((n = getline(&line, &size, fp)) != -1) {
+        int more;
+
+        (*n_line)++;
+        while (n > 0 && (line[n-1] == '\n' || line[n-1] == '\r')) {
+            line[--n] = '\0';
+        }
+        more = (n > 0 && line[n-1] == '\\');
+        if (more) {
+            line[--n] = ' ';
+        }
+
+        scenario = realloc(scenario, len+n+1);
+        if (scenario == NULL) {
+            fatal("readScenario() out of memory");
+        }
+        memcpy(scenario+len, line, n+1);
+        len += n;
+
+        if (!more) break;
+    }
+    free(line);
+
+    return scenario;
+} /*}}}2*/
+
+static int splitScenario(char *line, char **args, int max) /*{{{2*/
+/*
+ * Splits a scenario line in place into its arguments and returns their
+ * number (or -1 when there are more than max), where;
+ * line = scenario, whitespace separates the arguments, single or double
+ *        quotes group (and are removed) and '#' starts a comment
+ * args = set to the arguments
+ * max = maximum number of arguments
+ */
+{
+    char *src = line;
+    char *dst = line;
+    int n = 0;
+
+    for (;;) {
+        while (isspace((unsigned char)*src)) src++;
+        if (*src == '\0' || *src == '#') break;
+
+        if (n == max) return -1;
+        args[n++] = dst;
+
+        while (*src != '\0' && !isspace((unsigned char)*src)) {
+            if (*src == '"' || *src == '\'') {
+                char quote = *src++;
+
+                while (*src != '\0' && *src != quote) *dst++ = *src++;
+                if (*src == quote) src++;
+            }
+            else {
+                *dst++ = *src++;
+            }
+        }
+        if (*src != '\0') src++;
+        *dst++ = '\0';
+    }
+
+    return n;
+} /*}}}2*/
+
+static void saveOptions(Options *options, const SimulationContext *ctx, int mode) /*{{{2*/
+/*
+ * Saves the options of the command line (see restoreOptions())
+ */
+{
+    options->mode = mode;
+    options->q_format = ctx->q_format;
+    options->e_format = ctx->e_format;
+    options->arrow_diameter = ctx->arrow_diameter;
+    options->seed = ctx->seed;
+    options->asl[0] = asl1;
+    options->asl[1] = asl4;
+    options->asl[2] = asl8;
+    options->asl[3] = asl16;
+    options->asl[4] = asl32;
+    options->asl[5] = asl56;
+    options->asl[6] = asl104;
+    options->team_asl[0] = t1asl1;
+    options->team_asl[1] = t1asl2;
+    options->team_asl[2] = t1asl3;
+    options->team_asl[3] = t2asl1;
+    options->team_asl[4] = t2asl2;
+    options->team_asl[5] = t2asl3;
+    options->team_asl[6] = xt1asl1;
+    options->team_asl[7] = xt1asl2;
+    options->team_asl[8] = xt2asl1;
+    options->team_asl[9] = xt2asl2;
+    options->name_of_population = name_of_population;
+    options->start_asl = start_asl;
+    options->end_asl = end_asl;
+    options->step_asl = step_asl;
+    options->q_nruns = q_nruns;
+    options->e_nruns = e_nruns;
+    options->e_exact = e_exact;
+    options->fast_bracket = fast_bracket;
+    options->high_loser = high_loser;
+    options->cut_high_loser = cut_high_loser;
+    options->pretty_print = pretty_print;
+    options->output_format = output_format;
+    options->async_output = async_output;
+    options->resume = resume;
+    options->with_progress = with_progress;
+    options->interim_interval = interim_interval;
+    options->interactive = interactive;
+    options->n_threads = n_threads;
+    options->arrow_sampler = arrow_sampler;
+    options->output_name = output_name;
+    options->cache_dir = cache_dir;
+} /*}}}2*/
+
+static void restoreOptions(const Options *options, SimulationContext *ctx, int *mode) /*{{{2*/
+/*
+ * Sets the globals and context back to the saved options of the command
+ * line for the next scenario of a batch. Sharding (--shard, --partial-out
+ * and --merge) only applies to the scenario it is given for
+ */
+{
+    resetSimulationContext(ctx);
+
+    *mode = options->mode;
+    ctx->q_format = options->q_format;
+    ctx->e_format = options->e_format;
+    ctx->arrow_diameter = options->arrow_diameter;
+    ctx->seed = options->seed;
+    asl1 = options->asl[0];
+    asl4 = options->asl[1];
+    asl8 = options->asl[2];
+    asl16 = options->asl[3];
+    asl32 = options->asl[4];
+    asl56 = options->asl[5];
+    asl104 = options->asl[6];
+    t1asl1 = options->team_asl[0];
+    t1asl2 = options->team_asl[1];
+    t1asl3 = options->team_asl[2];
+    t2asl1 = options->team_asl[3];
+    t2asl2 = options->team_asl[4];
+    t2asl3 = options->team_asl[5];
+    xt1asl1 = options->team_asl[6];
+    xt1asl2 = options->team_asl[7];
+    xt2asl1 = options->team_asl[8];
+    xt2asl2 = options->team_asl[9];
+    name_of_population = options->name_of_population;
+    start_asl = options->start_asl;
+    end_asl = options->end_asl;
+    step_asl = options->step_asl;
+    q_nruns = options->q_nruns;
+    e_nruns = options->e_nruns;
+    e_exact = options->e_exact;
+    fast_bracket = options->fast_bracket;
+    high_loser = options->high_loser;
+    cut_high_loser = options->cut_high_loser;
+    pretty_print = options->pretty_print;
+    output_format = options->output_format;
+    async_output = options->async_output;
+    resume = options->resume;
+    with_progress = options->with_progress;
+    interim_interval = options->interim_interval;
+    interactive = options->interactive;
+    n_threads = options->n_threads;
+    arrow_sampler = options->arrow_sampler;
+    output_name = options->output_name;
+    cache_dir = options->cache_dir;
+
+    shard = 1;
+    n_shards = 1;
+    partial_out = NULL;
+    event_log = NULL;
+    checkpoint_file = NULL;
+    merge_files = NULL;
+    n_merge_files = 0;
+} /*}}}2*/
+
 static void help() /*{{{2*/
 {
     int i;
@@ -325,6 +861,7 @@ static void help() /*{{{2*/
     printf("--format-name=<name>               Name of all formats (for logging)\n");
     printf("--format=<format>                  Format code\n");
     printf("--n-runs=<n>                       Number op times an elimination is run between two archers\n");
+    printf("--exact                            Compute the match probabilities exactly instead of simulating\n");
 
     printf("\nMode: TEAM ELIMINATION\n");
     printf("--team-elimination                 Perform simulation of team elimination between two teams\n");
@@ -404,6 +941,25 @@ static void help() /*{{{2*/
     printf("--n-runs=<n>                       Number of times the entire competition is run\n");
     printf("--high-loser=<n>                   How much positions lower is an archer called a high-loser\n");
     printf("--cut-high-loser=<n>               To be a high-loser the q-rank needs to be at least n\n");
+    printf("--fast-bracket                     Decide each elimination match from precomputed win probabilities (no set/shoot-off details)\n");
+    printf("--shard=<i>/<n>                    Simulate only part <i> of <n> of the runs or matrix tiles (requires --seed and --partial-out)\n");
+    printf("--partial-out=<file>               Write the raw statistics to <file> (for --merge) instead of the results\n");
+    printf("--merge <file>...                  Combine the partial results of all shards into the results (same options as the shards)\n");
+    printf("--cache-dir=<dir>                  Keep the results in <dir>, simulate only runs not simulated before (requires --seed)\n");
+    printf("--event-log=<file>                 Write every elimination match (a fixed size record) to <file>\n");
+
+    printf("\nMode: CHECK-ARROW-SAMPLER\n");
+    printf("--check-arrow-sampler              Chi-square test of the arrow samplers against the ring probabilities\n");
+    printf("--start-level=<level>              Start (lowest) Archers Skill Level\n");
+    printf("--end-level=<level>                End (highest) Archers Skill Level\n");
+    printf("--level-step=<step>                Steps in Archers Skill Level\n");
+    printf("--distance=<distance>              Shooting distance in [m]\n");
+    printf("--target-face=<face-code>          Target face code\n");
+    printf("--n-arrows=<n>                     Number of arrows per run\n");
+    printf("--n-runs=<n>                       Number of runs (each sampler shoots n-runs x n-arrows arrows)\n");
+
+    printf("\nMode: SCAN-EVENT-LOG\n");
+    printf("--scan-event-log=<file>            Statistics per stage of the matches of an event log (--event-log)\n");
 
     printf("\n<face-code>\n");
     for (i = 0; i < N_FACES; i++) {
@@ -421,7 +977,16 @@ static void help() /*{{{2*/
     printf("--interactive                      Start in interactive mode\n");
     printf("--output=<file>                    Write output to file <file>\n");
     printf("--output-append=<file>             Append output to file <file>\n");
-    printf("--pretty-print                     Pretty print the results (default is CSV print of results)\n\n");
+    printf("--pretty-print                     Pretty print the results (default is CSV print of results)\n");
+    printf("--output-format=<format>           Output format; text (as --pretty-print), csv (default) or binary\n");
+    printf("--async-output                     Write the output on a separate thread\n");
+    printf("--arrow-sampler=<sampler>          Arrow sampler; alias (default), rayleigh or gaussian2d\n");
+    printf("--threads=<n>                      Number of threads to run the simulations on (default 1)\n");
+    printf("--progress                         Report progress, rates and ETA on stderr\n");
+    printf("--interim-stats=<seconds>          Print the --competitions statistics so far on stderr every <seconds>\n");
+    printf("--checkpoint=<file>                Keep the finished runs in <file> while simulating (requires --seed)\n");
+    printf("--resume                           Continue from the --checkpoint file of an interrupted simulation\n");
+    printf("--batch=<file>                     Run the scenarios of <file> (a line per scenario; <name> <options>)\n\n");
     printf("--help                             This help file\n");
 
 } /*}}}2*/
@@ -27,29 +27,27 @@
 #include "dump.h"
 #include "mixedteam.h"
 #include "archer.h"
+#include "context.h"
 
 /* --- Global data {{{1 */
 
-MixedTeam  mixedteam[24];
-MixedTeam *mixedteamrank[24];
-
 extern int pretty_print;
 
 /* --- Local prototypes {{{1*/
 
 /* --- Implementation {{{1*/
 
-void setMixedTeam(MixedTeam *mixedteam, double lvl[2]) /*{{{2*/
+void setMixedTeam(const SimulationContext *ctx, MixedTeam *mixedteam, double lvl[2]) /*{{{2*/
 {
     int i;
 
-    setArcher(&(mixedteam->archer[0]), 1, lvl[0]);
-    setArcher(&(mixedteam->archer[1]), 2, lvl[1]);
+    setArcher(ctx, &(mixedteam->archer[0]), 1, lvl[0]);
+    setArcher(ctx, &(mixedteam->archer[1]), 2, lvl[1]);
     mixedteam->q_rank = 0;
     mixedteam->e_rank = 0;
 } /*}}}2*/
 
-void setMixedTeams(double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl_16[2], double lvl_24[2]) /*{{{2*/
+void setMixedTeams(SimulationContext *ctx, double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl_16[2], double lvl_24[2]) /*{{{2*/
 /*
  * Setup an array of teams with different skill levels
  * where;
@@ -59,7 +57,7 @@ void setMixedTeams(double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl
  * lvl_16   = array of level of archers of 16th ranked mixedteam
  * lvl_24   = array of level of archers of 24th ranked mixedteam
  *
- * Returns nothing, but fills the archers array
+ * Returns nothing, but fills the mixed-teams array of the context
  */
 {
     double lvl[2];
@@ -72,7 +70,7 @@ void setMixedTeams(double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl
     for (i = 0; i < 4; i++) {
         lvl[0] = lvl_1[0] - i*dlvl[0];
         lvl[1] = lvl_1[1] - i*dlvl[1];
-        setMixedTeam(&mixedteam[i], lvl);
+        setMixedTeam(ctx, &ctx->mixedteam[i], lvl);
     }
 
     /* team 5..8 */
@@ -81,7 +79,7 @@ void setMixedTeams(double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl
     for (i = 4; i < 8; i++) {
         lvl[0] = lvl_4[0] - (i-4)*dlvl[0];
         lvl[1] = lvl_4[1] - (i-4)*dlvl[1];
-        setMixedTeam(&mixedteam[i], lvl);
+        setMixedTeam(ctx, &ctx->mixedteam[i], lvl);
     }
 
     /* 9..16 */
@@ -90,7 +88,7 @@ void setMixedTeams(double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl
     for (i = 8; i < 16; i++) {
         lvl[0] = lvl_8[0] - (i-8)*dlvl[0];
         lvl[1] = lvl_8[1] - (i-8)*dlvl[1];
-        setMixedTeam(&mixedteam[i], lvl);
+        setMixedTeam(ctx, &ctx->mixedteam[i], lvl);
     }
 
     /* 17..24 */
@@ -99,11 +97,11 @@ void setMixedTeams(double lvl_1[2], double lvl_4[2], double lvl_8[2], double lvl
     for (i = 16; i < 24; i++) {
         lvl[0] = lvl_8[0] - (i-16)*dlvl[0];
         lvl[1] = lvl_8[1] - (i-16)*dlvl[1];
-        setMixedTeam(&mixedteam[i], lvl);
+        setMixedTeam(ctx, &ctx->mixedteam[i], lvl);
     }
 } /*}}}2*/
 
-double getMixedTeamScore(const MixedTeam *mixedteam) /*{{{2*/
+Score getMixedTeamScore(const MixedTeam *mixedteam) /*{{{2*/
 {
     return mixedteam->archer[0].q_score + mixedteam->archer[1].q_score;
 } /*}}}2*/
@@ -128,17 +126,17 @@ void dumpMixedTeam(const MixedTeam *mixedteam) /*{{{2*/
 
     if (pretty_print) {
         outp("|   %3d  | %s |   %3d  |  %8.2lf (%6.1lf, %6.1lf) |\n",
-                mixedteam->q_rank, ' ', mixedteam->e_rank, getMixedTeamScore(mixedteam),
-                mixedteam->archer[0].q_score, mixedteam->archer[1].q_score);
+                mixedteam->q_rank, ' ', mixedteam->e_rank, SCORE_TO_DOUBLE(getMixedTeamScore(mixedteam)),
+                SCORE_TO_DOUBLE(mixedteam->archer[0].q_score), SCORE_TO_DOUBLE(mixedteam->archer[1].q_score));
     }
     else {
         outp("%d;\"%s\";%d;%lf;%lf;%lf\n",
-               mixedteam->q_rank, ' ', mixedteam->e_rank, getMixedTeamScore(mixedteam),
-               mixedteam->archer[0].q_score, mixedteam->archer[1].q_score);
+               mixedteam->q_rank, ' ', mixedteam->e_rank, SCORE_TO_DOUBLE(getMixedTeamScore(mixedteam)),
+               SCORE_TO_DOUBLE(mixedteam->archer[0].q_score), SCORE_TO_DOUBLE(mixedteam->archer[1].q_score));
     }
 } /*}}}2*/
 
-void rankMixedTeams(int from_rank, int to_rank) /*{{{2*/
+void rankMixedTeams(SimulationContext *ctx, int from_rank, int to_rank) /*{{{2*/
 {
     int i, j;
     int start_idx = from_rank-1;
@@ -150,16 +148,16 @@ void rankMixedTeams(int from_rank, int to_rank) /*{{{2*/
         max = NULL;
         for (j = i; j <= end_idx; j++) {
             if ( (max == NULL) ||
-                 (getMixedTeamScore(mixedteamrank[j]) > getMixedTeamScore(max)) )
+                 (getMixedTeamScore(ctx->mixedteamrank[j]) > getMixedTeamScore(max)) )
             {
-                max = mixedteamrank[j];
+                max = ctx->mixedteamrank[j];
                 j_found = j;
             }
         }
         /* swap */
-        tmp = mixedteamrank[i];
-        mixedteamrank[i] = max;
-        mixedteamrank[j_found] = tmp;
+        tmp = ctx->mixedteamrank[i];
+        ctx->mixedteamrank[i] = max;
+        ctx->mixedteamrank[j_found] = tmp;
     }
 } /*}}}2*/
 
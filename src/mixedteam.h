@@ -38,12 +38,14 @@ typedef struct {
 
 /* --- Interface {{{1 */
 
-extern MixedTeam  mixedteam[];
-extern MixedTeam *mixedteamrank[];
-
-void setMixedTeam(MixedTeam *mixedteam, double *lvls);
-double getMixedTeamScore(const MixedTeam *mixedteam);
-void rankMixedTeams(int from_rank, int to_rank);
+/*
+ * The mixed-teams and their ranking are part of the simulation (context.h)
+ */
+struct SimulationContext;
+
+void setMixedTeam(const struct SimulationContext *ctx, MixedTeam *mixedteam, double *lvls);
+Score getMixedTeamScore(const MixedTeam *mixedteam);
+void rankMixedTeams(struct SimulationContext *ctx, int from_rank, int to_rank);
 
 #endif
 
@@ -25,126 +25,905 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "skilllevelscores.h"
 #include "interactive.h"
 #include "format.h"
 #include "qualification.h"
 #include "elimination.h"
+#include "random.h"
+#include "score.h"
+#include "face.h"
+#include "dump.h"
+#include "context.h"
+#include "pool.h"
+#include "eventlog.h"
+#include "checkpoint.h"
+#include "progress.h"
 
 /* --- Global data {{{1*/
 
 extern int pretty_print;
-extern int with_progress;
 extern int interactive;
+extern double start_asl;
+extern double end_asl;
+extern double step_asl;
+extern int shard;
+extern int n_shards;
+extern char *partial_out;
+extern char **merge_files;
+extern int n_merge_files;
+extern char *cache_dir;
+extern char *event_log;
+extern char *scan_event_log;
+
+/* --- Local data types {{{1*/
+
+/*
+ * Competitions are simulated (and added up) in blocks of COMPETITIONS_BLOCK
+ * runs, within a block QUALIFICATION_LANES competitions side by side (the
+ * block is a multiple of it, so the lanes do not depend on the threads)
+ */
+#define COMPETITIONS_BLOCK 256
+
+/*
+ * Statistics of a block of competitions
+ */
+typedef struct {
+    Archer                   archer[104];
+    QualificationStatistics  qstats;
+    EliminationStatistics    elimstats;
+    /* Matches of the block in run order (--event-log), or NULL */
+    MatchEvent              *event;
+    size_t                   n_events;
+} CompetitionsBlock;
+
+/*
+ * Competitions simulated on the thread pool, the blocks are added to ctx in
+ * block order (whatever order they finish in), so the sums do not depend on
+ * the number of threads. A shard simulates blocks first_block up to
+ * last_block and writes them to its partial results file instead
+ */
+typedef struct {
+    SimulationContext   *ctx;
+    SimulationContext  **worker;        /* QUALIFICATION_LANES per worker */
+    int                  n_runs;
+    int                  n_blocks;
+    int                  first_block;   /* Blocks simulated (this shard) */
+    int                  last_block;
+    CompetitionsBlock  **block;         /* Finished blocks not yet added */
+    int                  n_added;       /* Blocks added to ctx so far    */
+    FILE                *partial;       /* Partial results file, or NULL */
+    FILE                *cache;         /* New result cache file, or NULL*/
+    int                  n_cache_blocks;/* Blocks written to it          */
+    EventLog             log;           /* Event log (--event-log)       */
+    MatchEvents         *events;        /* Events per lane context, or NULL */
+    Checkpoint           checkpoint;    /* Checkpoint (--checkpoint)     */
+    pthread_mutex_t      lock;
+} Competitions;
+
+/*
+ * Header of a partial results file (--partial-out), followed by the blocks
+ * first_block up to last_block. A block is written as its index, per archer
+ * q_n and q_score_stat, qstats and elimstats. The file is binary, to be
+ * merged by the same build (record_size guards against others). The result
+ * cache (--cache-dir) holds a file of the same format per study, with all
+ * full blocks simulated so far
+ */
+#define PARTIAL_MAGIC   "ACSPART"
+#define PARTIAL_VERSION 1
+
+typedef struct {
+    char                 magic[8];
+    int32_t              version;
+    int32_t              record_size;   /* Bytes per block written       */
+    int32_t              shard;         /* Shard (1..n_shards)           */
+    int32_t              n_shards;
+    int32_t              n_runs;        /* Runs of the whole study       */
+    int32_t              n_blocks;      /* Blocks of the whole study     */
+    int32_t              first_block;   /* Blocks in the file            */
+    int32_t              last_block;
+    uint64_t             study;         /* getContextHash()              */
+} PartialHeader;
+
+#define PARTIAL_RECORD_SIZE ((int32_t)(sizeof(int32_t) + 104*(sizeof(int) + sizeof(Stat)) + \
+                                       sizeof(QualificationStatistics) + sizeof(EliminationStatistics)))
+
+/* --- Local prototypes {{{1*/
+
+static void doCompetitionsBlock(void *arg, int worker, int task);
+static void reportCompetitions(void *arg, FILE *out);
+static void printInterimStat(FILE *out, const char *name, const Stat *stat);
+static void getBlockEvents(CompetitionsBlock *block, MatchEvents *events, int from, int to);
+static void addCompetitionsBlocks(Competitions *comp);
+static void addCompetitionsBlock(Competitions *comp, int index, const CompetitionsBlock *block);
+static void readCompetitionsCache(Competitions *comp, char *cache_name, size_t size);
+static void resumeCompetitions(Competitions *comp);
+static void writePartialHeader(FILE *fp, const Competitions *comp, int n_runs, int n_blocks,
+                               int first_block, int last_block);
+static void writePartialBlock(FILE *fp, int32_t index, const CompetitionsBlock *block);
+static int readPartialHeader(FILE *fp, PartialHeader *header);
+static CompetitionsBlock *readPartialBlock(FILE *fp, int32_t index, const char *filename);
+static void readPartialFile(Competitions *comp, const char *filename);
+static void writePartial(FILE *fp, const void *data, size_t size);
+static void readPartial(FILE *fp, void *data, size_t size, const char *filename);
 
 /* --- Implementation {{{1*/
 
-void modeScore(void) /*{{{2*/
+void modeScore(SimulationContext *ctx) /*{{{2*/
 {
-    q_format.best_of = 0;
-    q_format.type = CUMULATIVE;
-    if (interactive) interactiveASLSimulation();
-    ASLSimulation();
+    ctx->q_format.best_of = 0;
+    ctx->q_format.type = CUMULATIVE;
+    if (interactive) interactiveASLSimulation(ctx);
+    ASLSimulation(ctx);
 } /*}}}2*/
 
-void modeQualification(void) /*{{{2*/
+void modeQualification(SimulationContext *ctx) /*{{{2*/
 {
     int i;
 
-    initQualificationStats();
+    initQualificationStats(ctx);
 
-    if (interactive) interactiveQualificationRoundSimulation();
+    if (interactive) interactiveQualificationRoundSimulation(ctx);
 
-    setArchers();
+    setArchers(ctx);
 
-    doQualificationRounds(q_nruns);
+    doQualificationRounds(ctx, q_nruns);
 
-    dumpQualificationStats();
+    dumpQualificationStats(ctx);
 #if 1
     dumpArcher(NULL); /* Force dump header */
     for (i = 0; i < 104; i++) {
-        dumpArcher(archerrank[i]);
+        dumpArcher(ctx->archerrank[i]);
     }
 #endif
 } /*}}}2*/
 
-void modeElimination(void) /*{{{2*/
+void modeElimination(SimulationContext *ctx) /*{{{2*/
 {
-    if (interactive) interactiveEliminationStats();
-    computeEliminationStats();
+    if (interactive) interactiveEliminationStats(ctx);
+    computeEliminationStats(ctx);
 } /*}}}2*/
 
-void modeTeamElimination(void) /*{{{2*/
+void modeTeamElimination(SimulationContext *ctx) /*{{{2*/
 {
-    if (interactive) interactiveTeamEliminationStats();
-    computeTeamEliminationStats();
+    if (interactive) interactiveTeamEliminationStats(ctx);
+    computeTeamEliminationStats(ctx);
 } /*}}}2*/
 
-void modeMixedTeamElimination(void) /*{{{2*/
+void modeMixedTeamElimination(SimulationContext *ctx) /*{{{2*/
 {
-    if (interactive) interactiveMixedTeamEliminationStats();
-    computeMixedTeamEliminationStats();
+    if (interactive) interactiveMixedTeamEliminationStats(ctx);
+    computeMixedTeamEliminationStats(ctx);
 } /*}}}2*/
 
-void modeCompetition(void) /*{{{2*/
+void modeCompetition(SimulationContext *ctx) /*{{{2*/
 {
     int i;
 
-    initQualificationStats();
-    initEliminationStats();
+    initQualificationStats(ctx);
+    initEliminationStats(ctx);
 
-    if (interactive) interactiveCompetitionSimulation();
+    if (interactive) interactiveCompetitionSimulation(ctx);
 
-    setArchers();
+    setArchers(ctx);
 
-    doQualificationRound();
+    if (fast_bracket) {
+        initFastBracket(ctx);
+    }
+
+    doQualificationRound(ctx);
 
-    dumpQualificationStats();
+    dumpQualificationStats(ctx);
     dumpArcher(NULL); /* Force dump header */
     for (i = 0; i < 104; i++) {
-        dumpArcher(archerrank[i]);
+        dumpArcher(ctx->archerrank[i]);
     }
 
-    doEliminationRound();
+    doEliminationRound(ctx);
 
-    dumpEliminationStats();
+    dumpEliminationStats(ctx);
     dumpArcher(NULL); /* Force dump header */
     for (i = 0; i < 104; i++) {
-        dumpArcher(archerrank[i]);
+        dumpArcher(ctx->archerrank[i]);
+    }
+} /*}}}2*/
+
+void modeCompetitions(SimulationContext *ctx) /*{{{2*/
+/*
+ * Simulates q_nruns competitions. Competition j draws from run j of the seed
+ * (setContextRun()) and starts from the skill level ranking, so the result
+ * is the same for any number of threads (--threads), for any split into
+ * shards (--shard) merged afterwards (--merge) and when (part of) the runs
+ * come from the result cache (--cache-dir)
+ */
+{
+    Competitions comp;
+    char cache_name[FILENAME_MAX];
+    int n_workers;
+    int w;
+    int b;
+
+    initQualificationStats(ctx);
+    initEliminationStats(ctx);
+
+    if (interactive) interactiveCompetitionsSimulation(ctx);
+
+    setArchers(ctx);
+
+    comp.ctx = ctx;
+    comp.n_runs = q_nruns;
+    comp.n_blocks = (q_nruns + COMPETITIONS_BLOCK - 1)/COMPETITIONS_BLOCK;
+    comp.first_block = (int)((long)comp.n_blocks*(shard-1)/n_shards);
+    comp.last_block = (int)((long)comp.n_blocks*shard/n_shards);
+    comp.n_added = comp.first_block;
+    comp.partial = NULL;
+    comp.cache = NULL;
+    comp.n_cache_blocks = 0;
+    comp.events = NULL;
+    comp.checkpoint.fp = NULL;
+    comp.block = calloc(comp.n_blocks+1, sizeof(CompetitionsBlock*));
+    if (comp.block == NULL) {
+        fatal("modeCompetitions() out of memory");
+    }
+
+    if (partial_out != NULL) {
+        comp.partial = fopen(partial_out, "wb");
+        if (comp.partial == NULL) {
+            fatal("Cannot open partial results file for writing");
+        }
+        writePartialHeader(comp.partial, &comp, comp.n_runs, comp.n_blocks, comp.first_block, comp.last_block);
+    }
+
+    if (cache_dir != NULL && n_shards == 1 && partial_out == NULL && n_merge_files == 0) {
+        /* Only the runs not in the cache are simulated */
+        readCompetitionsCache(&comp, cache_name, sizeof(cache_name));
+    }
+
+    if (checkpoint_file != NULL) {
+        /* Only the runs not in the checkpoint are simulated */
+        resumeCompetitions(&comp);
+    }
+
+    /* Not needed when nothing is left to simulate */
+    if (fast_bracket && n_merge_files == 0 && comp.first_block < comp.last_block) {
+        initFastBracket(ctx);
+    }
+
+    n_workers = (n_merge_files > 0) ? 1 : getPoolWorkers(comp.last_block - comp.first_block);
+    comp.worker = malloc(n_workers*QUALIFICATION_LANES*sizeof(SimulationContext*));
+    if (comp.worker == NULL) {
+        fatal("modeCompetitions() out of memory");
+    }
+    for (w = 0; w < n_workers*QUALIFICATION_LANES; w++) {
+        comp.worker[w] = malloc(sizeof(SimulationContext));
+        if (comp.worker[w] == NULL) {
+            fatal("modeCompetitions() out of memory");
+        }
+        forkSimulationContext(comp.worker[w], ctx, 0);
+    }
+    pthread_mutex_init(&comp.lock, NULL);
+
+    if (event_log != NULL) {
+        comp.events = calloc(n_workers*QUALIFICATION_LANES, sizeof(MatchEvents));
+        if (comp.events == NULL) {
+            fatal("modeCompetitions() out of memory");
+        }
+        for (w = 0; w < n_workers*QUALIFICATION_LANES; w++) {
+            comp.worker[w]->events = &comp.events[w];
+        }
+        openEventLog(&comp.log, event_log, comp.n_runs, getContextHash(ctx));
+    }
+
+    if (n_merge_files > 0) {
+        /* Add the blocks of the shards instead of simulating them */
+        for (w = 0; w < n_merge_files; w++) {
+            readPartialFile(&comp, merge_files[w]);
+        }
+        if (comp.n_added < comp.last_block) {
+            fatal("Partial results files do not cover all runs (shard missing)");
+        }
+    }
+    else {
+        long first_run = (long)comp.n_added*COMPETITIONS_BLOCK;
+        long last_run = ((long)comp.last_block*COMPETITIONS_BLOCK < comp.n_runs) ?
+                        (long)comp.last_block*COMPETITIONS_BLOCK : comp.n_runs;
+
+        startProgress("competitions", last_run - first_run, reportCompetitions, &comp);
+        runPoolTasks(n_workers, comp.last_block - comp.first_block, doCompetitionsBlock, &comp);
+        stopProgress();
+    }
+
+    pthread_mutex_destroy(&comp.lock);
+    if (comp.events != NULL) {
+        closeEventLog(&comp.log);
+        for (w = 0; w < n_workers*QUALIFICATION_LANES; w++) {
+            free(comp.events[w].event);
+        }
+        free(comp.events);
+    }
+    for (w = 0; w < n_workers*QUALIFICATION_LANES; w++) {
+        free(comp.worker[w]);
+    }
+    free(comp.worker);
+    for (b = 0; b < comp.n_blocks; b++) {
+        free(comp.block[b]);
+    }
+    free(comp.block);
+
+    if (comp.cache != NULL) {
+        char tmp_name[FILENAME_MAX+32];
+
+        /* Replaced at once, other processes read the old or the new file */
+        snprintf(tmp_name, sizeof(tmp_name), "%s.%ld", cache_name, (long)getpid());
+        if (fclose(comp.cache) != 0 || rename(tmp_name, cache_name) != 0) {
+            fatal("Cannot write result cache file");
+        }
+    }
+
+    if (comp.partial != NULL) {
+        if (fclose(comp.partial) != 0) {
+            fatal("Cannot write partial results file");
+        }
+    }
+    else {
+        dumpEliminationStats(ctx);
+    }
+
+    if (comp.checkpoint.fp != NULL) {
+        closeCheckpoint(&comp.checkpoint);
     }
 } /*}}}2*/
 
-void modeCompetitions(void) /*{{{2*/
+void modeCheckArrowSampler(SimulationContext *ctx) /*{{{2*/
 {
-    int j;
+    double asl;
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    long n_arrows = (long)q_nruns * ctx->q_format.narrows;
+
+    if (pretty_print) {
+        outp("Format               : %s\n", getFormatName(&ctx->q_format));
+        outp("Arrows per sampler   : %ld\n", n_arrows);
+        outp("| ASL    | Sampler    |   N arrows | Chi-square | DoF | Test |\n");
+        outp("+--------+------------+------------+------------+-----+------|\n");
+        /*    | XXX.XX | xxxxxxxxxx | XXXXXXXXXX | XXXXXX.XXX | XXX | xxxx | */
+    }
+    else {
+        outp("\"%s\";%ld\n", getFormatName(&ctx->q_format), n_arrows);
+        outp("\"asl\";\"sampler\";\"n-arrows\";\"chi-square\";\"dof\";\"test\"\n");
+    }
+    for (asl = start_asl; asl <= end_asl; asl += step_asl) {
+        checkArrowSamplers(&ctx->rs, asl, face, ctx->q_format.distance, n_arrows);
+    }
+
+    outp_close();
+} /*}}}2*/
+
+void modeScanEventLog(SimulationContext *ctx) /*{{{2*/
+/*
+ * Reads the event log of --scan-event-log and prints per stage the number of
+ * matches, the fraction decided by a shoot-off, the fraction won by the lower
+ * qualified archer (upsets) and the average number of sets shot
+ */
+{
+    static const char *name[8] = { "1/48", "1/24", "1/16", "1/8", "1/4", "1/2", "Bronze", "Gold" };
+    static const TableColumn column[5] = {
+        { "round",      COLUMN_INT },     /* 0 = 1/48 .. 7 = gold */
+        { "n_matches",  COLUMN_INT },
+        { "shootoffs",  COLUMN_DOUBLE },
+        { "upsets",     COLUMN_DOUBLE },
+        { "sets",       COLUMN_DOUBLE },
+    };
+    MappedEventLog log;
+    long n_matches[8] = {0};
+    long n_shootoffs[8] = {0};
+    long n_upsets[8] = {0};
+    long n_sets[8] = {0};
+    size_t e;
+    int s;
+
+    (void)ctx;
+
+    if (mapEventLog(&log, scan_event_log) != 0) {
+        fprintf(stderr, "%s is not an event log of this build\n", scan_event_log);
+        fatal("Cannot read event log");
+    }
+
+    for (e = 0; e < log.n_events; e++) {
+        const MatchEvent *event = &log.event[e];
+        int left_wins = (event->flags & EVENT_LEFT_WINS) != 0;
+        int winner = left_wins ? event->left_q_rank : event->right_q_rank;
+        int loser = left_wins ? event->right_q_rank : event->left_q_rank;
+
+        /* Rows from the 1/48 (stage 6) to the gold final (stage 0) */
+        s = (event->flags & EVENT_BRONZE) ? 6 : (event->stage == 0) ? 7 : MAX_STAGES-1-event->stage;
+        n_matches[s]++;
+        n_shootoffs[s] += (event->flags & EVENT_SHOOTOFF) != 0;
+        n_upsets[s] += (winner > loser);
+        n_sets[s] += event->n_sets;
+    }
+
+    if (pretty_print) {
+        outp("Event log            : %s\n", scan_event_log);
+        outp("Runs (study)         : %d\n", log.header->n_runs);
+        outp("Matches              : %zu\n", log.n_events);
+        outp("| Stage  |    Matches | Shoot-off | Upset  | Sets  |\n");
+        outp("+--------+------------+-----------+--------+-------|\n");
+        /*    | xxxxxx | XXXXXXXXXX |    XX.XX% | XX.XX% | X.XXX | */
+    }
+    else if (output_format == OUTPUT_BINARY) {
+        beginTable("event_log_stages", 5, column);
+    }
+    else {
+        outp("\"%s\";%d;%zu\n", scan_event_log, log.header->n_runs, log.n_events);
+        outp("\"stage\";\"n-matches\";\"shootoffs\";\"upsets\";\"sets\"\n");
+    }
+    for (s = 0; s < 8; s++) {
+        double n = (n_matches[s] > 0) ? (double)n_matches[s] : 1.0;
+
+        if (pretty_print) {
+            outp("| %-6s | %10ld |    %5.2lf%% | %5.2lf%% | %5.3lf |\n", name[s], n_matches[s],
+                 100.0*n_shootoffs[s]/n, 100.0*n_upsets[s]/n, n_sets[s]/n);
+        }
+        else if (output_format == OUTPUT_BINARY) {
+            tableInt(s);
+            tableInt(n_matches[s]);
+            tableDouble(n_shootoffs[s]/n);
+            tableDouble(n_upsets[s]/n);
+            tableDouble(n_sets[s]/n);
+        }
+        else {
+            outp("\"%s\";%ld;%lf;%lf;%lf\n", name[s], n_matches[s], n_shootoffs[s]/n, n_upsets[s]/n, n_sets[s]/n);
+        }
+    }
+
+    unmapEventLog(&log);
+    outp_close();
+} /*}}}2*/
+
+/* --- Internals {{{1*/
+
+static void doCompetitionsBlock(void *arg, int worker, int task) /*{{{2*/
+/*
+ * Pool task simulating block first_block+task of the competitions on the
+ * lane contexts of a worker and adding the finished blocks to the
+ * statistics. Lane l simulates competitions from+l,
+ * from+l+QUALIFICATION_LANES, ..
+ */
+{
+    Competitions *comp = arg;
+    SimulationContext **lane = &comp->worker[worker*QUALIFICATION_LANES];
+    CompetitionsBlock *block;
+    int index = comp->first_block + task;
+    int from = index*COMPETITIONS_BLOCK;
+    int to = (from + COMPETITIONS_BLOCK < comp->n_runs) ? from + COMPETITIONS_BLOCK : comp->n_runs;
+    long n_arrows;
+    int i, j, l;
+
+    for (l = 0; l < QUALIFICATION_LANES; l++) {
+        initQualificationStats(lane[l]);
+        initEliminationStats(lane[l]);
+        lane[l]->n_arrows = 0;
+        if (lane[l]->events != NULL) {
+            lane[l]->events->n_events = 0;
+        }
+    }
+
+    for (j = from; j < to; j += QUALIFICATION_LANES) {
+        int n_lanes = (to-j < QUALIFICATION_LANES) ? to-j : QUALIFICATION_LANES;
+
+        for (l = 0; l < n_lanes; l++) {
+            setContextRun(lane[l], (uint64_t)(j+l));
+            resetArcherRanking(lane[l]);
+        }
+
+        doQualificationRoundLanes(lane, n_lanes);
+
+        /* Elimination, ranks and bracket differ per lane */
+        for (l = 0; l < n_lanes; l++) {
+            if (lane[l]->events != NULL) {
+                lane[l]->events->run = (uint32_t)(j+l);
+            }
+            doEliminationRound(lane[l]);
+        }
+    }
+
+    block = malloc(sizeof(CompetitionsBlock));
+    if (block == NULL) {
+        fatal("doCompetitionsBlock() out of memory");
+    }
+    for (i = 0; i < 104; i++) {
+        block->archer[i] = lane[0]->archer[i];
+    }
+    block->qstats = lane[0]->qstats;
+    block->elimstats = lane[0]->elimstats;
+    for (l = 1; l < QUALIFICATION_LANES; l++) {
+        for (i = 0; i < 104; i++) {
+            mergeArcherStats(&(block->archer[i]), &(lane[l]->archer[i]));
+        }
+        mergeQualificationStats(&(block->qstats), &(lane[l]->qstats));
+        mergeEliminationStats(&(block->elimstats), &(lane[l]->elimstats));
+    }
+    block->event = NULL;
+    block->n_events = 0;
+    if (comp->events != NULL) {
+        getBlockEvents(block, &comp->events[worker*QUALIFICATION_LANES], from, to);
+    }
+
+    pthread_mutex_lock(&comp->lock);
+    comp->block[index] = block;
+    addCompetitionsBlocks(comp);
+    pthread_mutex_unlock(&comp->lock);
+
+    n_arrows = (long)(to-from)*104*lane[0]->q_format.narrows;
+    for (l = 0; l < QUALIFICATION_LANES; l++) {
+        n_arrows += lane[l]->n_arrows;
+    }
+    addProgress(to-from, n_arrows);
+} /*}}}2*/
+
+static void reportCompetitions(void *arg, FILE *out) /*{{{2*/
+/*
+ * Prints the fitness functions and top rankings of the competitions added so
+ * far with their 95% confidence intervals (--interim-stats), where;
+ * arg = the Competitions
+ * out = stream to print to
+ */
+{
+    Competitions *comp = arg;
+    QualificationStatistics qstats;
+    EliminationStatistics elimstats;
+
+    pthread_mutex_lock(&comp->lock);
+    qstats = comp->ctx->qstats;
+    elimstats = comp->ctx->elimstats;
+    pthread_mutex_unlock(&comp->lock);
+
+    fprintf(out, "Competitions         : %ld\n", elimstats.n_competitions);
+    printInterimStat(out, "Qualification fc", &qstats.fc);
+    printInterimStat(out, "Elimination fc", &elimstats.fc);
+    printInterimStat(out, "Top Q4 in E4", &elimstats.n_top_q4_e4);
+    printInterimStat(out, "Top Q8 in E8", &elimstats.n_top_q8_e8);
+    printInterimStat(out, "Top Q16 in E16", &elimstats.n_top_q16_e16);
+} /*}}}2*/
+
+static void printInterimStat(FILE *out, const char *name, const Stat *stat) /*{{{2*/
+/*
+ * Prints the mean of a statistic with its 95% confidence interval, where;
+ * out = stream to print to
+ * name = name of the statistic
+ * stat = the statistic
+ */
+{
+    double ci = (stat->n > 1) ? 1.96*getStdev(stat)/sqrt((double)stat->n) : 0.0;
+
+    fprintf(out, "%-20s : %10.4f +/- %.4f\n", name, getMean(stat), ci);
+} /*}}}2*/
+
+static void getBlockEvents(CompetitionsBlock *block, MatchEvents *events, int from, int to) /*{{{2*/
+/*
+ * Collects the events of the lanes of a block in run order, where;
+ * block = block to set the events of
+ * events = events of the QUALIFICATION_LANES lanes that simulated it
+ * from, to = runs of the block, run j was simulated on lane (j-from) %
+ *            QUALIFICATION_LANES
+ */
+{
+    size_t next[QUALIFICATION_LANES] = {0};
+    size_t n = 0;
+    int j, l;
+
+    for (l = 0; l < QUALIFICATION_LANES; l++) {
+        n += events[l].n_events;
+    }
+    block->event = malloc((n > 0 ? n : 1)*sizeof(MatchEvent));
+    if (block->event == NULL) {
+        fatal("getBlockEvents() out of memory");
+    }
+
+    for (j = from; j < to; j++) {
+        MatchEvents *lane = &events[(j-from) % QUALIFICATION_LANES];
+        size_t *k = &next[(j-from) % QUALIFICATION_LANES];
+
+        while (*k < lane->n_events && lane->event[*k].run == (uint32_t)j) {
+            block->event[block->n_events++] = lane->event[(*k)++];
+        }
+    }
+} /*}}}2*/
+
+static void addCompetitionsBlocks(Competitions *comp) /*{{{2*/
+/*
+ * Adds the finished blocks that are next in block order to the statistics
+ * of the context (or writes them to the partial results file), call with
+ * comp->lock held
+ */
+{
+    while (comp->n_added < comp->last_block && comp->block[comp->n_added] != NULL) {
+        CompetitionsBlock *block = comp->block[comp->n_added];
+
+        addCompetitionsBlock(comp, comp->n_added, block);
+        if (comp->checkpoint.fp != NULL) {
+            writePartialBlock(comp->checkpoint.fp, comp->n_added, block);
+            syncCheckpoint(&comp->checkpoint);
+        }
+
+        free(block->event);
+        free(block);
+        comp->block[comp->n_added] = NULL;
+        comp->n_added++;
+    }
+} /*}}}2*/
+
+static void addCompetitionsBlock(Competitions *comp, int index, const CompetitionsBlock *block) /*{{{2*/
+/*
+ * Adds block 'index' to the statistics of the context, or writes it to the
+ * partial results file. Blocks for the new result cache file are written
+ * to it as well
+ */
+{
+    SimulationContext *ctx = comp->ctx;
     int i;
 
-    initQualificationStats();
-    initEliminationStats();
+    if (comp->partial != NULL) {
+        writePartialBlock(comp->partial, index, block);
+    }
+    else {
+        for (i = 0; i < 104; i++) {
+            mergeArcherStats(&(ctx->archer[i]), &(block->archer[i]));
+        }
+        mergeQualificationStats(&(ctx->qstats), &(block->qstats));
+        mergeEliminationStats(&(ctx->elimstats), &(block->elimstats));
+    }
+    if (comp->cache != NULL && index < comp->n_cache_blocks) {
+        writePartialBlock(comp->cache, index, block);
+    }
+    if (comp->events != NULL) {
+        writeEventLog(&comp->log, block->event, block->n_events);
+    }
+} /*}}}2*/
+
+static void readCompetitionsCache(Competitions *comp, char *cache_name, size_t size) /*{{{2*/
+/*
+ * Adds the blocks of the competitions that are in the result cache and
+ * starts the simulation after them, where;
+ * comp = competitions to simulate, first_block is moved past the cache
+ * cache_name = set to the name of the cache file of the study
+ * size = size of cache_name
+ * The cache file of a study (getContextHash()) holds its full blocks (a
+ * last block of less than COMPETITIONS_BLOCK runs is always simulated).
+ * When more full blocks are simulated than cached, a new cache file with
+ * all of them is opened (comp->cache), to replace the old one when done
+ */
+{
+    PartialHeader header;
+    FILE *fp;
+    uint64_t study = getContextHash(comp->ctx);
+    int n_full = comp->n_runs/COMPETITIONS_BLOCK;
+    int n_cached = 0;
+    int b;
+
+    if (mkdir(cache_dir, 0777) != 0 && errno != EEXIST) {
+        fatal("Cannot create result cache directory");
+    }
+    snprintf(cache_name, size, "%s/competitions-%016llx.bin", cache_dir, (unsigned long long)study);
+
+    fp = fopen(cache_name, "rb");
+    if (fp != NULL) {
+        /* Unusable files (other build or version) are replaced */
+        if (readPartialHeader(fp, &header) == 0 && header.study == study && header.first_block == 0 &&
+            header.last_block >= 0 && header.n_runs == header.last_block*COMPETITIONS_BLOCK) {
+            n_cached = header.last_block;
+        }
+    }
+
+    if (n_full > n_cached) {
+        char tmp_name[FILENAME_MAX+32];
+
+        snprintf(tmp_name, sizeof(tmp_name), "%s.%ld", cache_name, (long)getpid());
+        comp->cache = fopen(tmp_name, "wb");
+        if (comp->cache == NULL) {
+            fatal("Cannot open result cache file for writing");
+        }
+        comp->n_cache_blocks = n_full;
+        writePartialHeader(comp->cache, comp, n_full*COMPETITIONS_BLOCK, n_full, 0, n_full);
+    }
+
+    for (b = 0; b < n_cached && b < n_full; b++) {
+        CompetitionsBlock *block = readPartialBlock(fp, b, cache_name);
+
+        addCompetitionsBlock(comp, b, block);
+        free(block);
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+
+    comp->first_block = comp->n_added = b;
+} /*}}}2*/
+
+static void resumeCompetitions(Competitions *comp) /*{{{2*/
+/*
+ * Opens the checkpoint of the competitions, adds the blocks finished before
+ * from it (--resume) and starts the simulation after them. The blocks are
+ * added in block order as when simulated, so the results are the same as
+ * those of a run that was not interrupted
+ */
+{
+    uint64_t study = getContextHash(comp->ctx);
+    long n_records;
+    int b;
+
+    /* The blocks of a shard (or after the cached blocks) */
+    study = addContextHash(study, &comp->first_block, sizeof(int));
+    study = addContextHash(study, &comp->last_block, sizeof(int));
+
+    n_records = openCheckpoint(&comp->checkpoint, CHECKPOINT_COMPETITIONS, study, comp->n_runs, PARTIAL_RECORD_SIZE);
+    for (b = comp->first_block; b < comp->last_block && b - comp->first_block < n_records; b++) {
+        CompetitionsBlock *block = readPartialBlock(comp->checkpoint.fp, b, checkpoint_file);
+
+        addCompetitionsBlock(comp, b, block);
+        free(block);
+    }
+    continueCheckpoint(&comp->checkpoint, b - comp->first_block);
+
+    comp->first_block = comp->n_added = b;
+} /*}}}2*/
 
-    if (interactive) interactiveCompetitionsSimulation();
+static void writePartialHeader(FILE *fp, const Competitions *comp, int n_runs, int n_blocks, /*{{{2*/
+                               int first_block, int last_block)
+/*
+ * Writes the header of a partial results (or result cache) file, where;
+ * fp = file to write to
+ * comp = competitions of the file
+ * n_runs, n_blocks = runs and blocks of the whole study
+ * first_block, last_block = blocks in the file (last_block not included)
+ */
+{
+    PartialHeader header;
+
+    memset(&header, 0, sizeof(PartialHeader));
+    strcpy(header.magic, PARTIAL_MAGIC);
+    header.version = PARTIAL_VERSION;
+    header.record_size = PARTIAL_RECORD_SIZE;
+    header.shard = shard;
+    header.n_shards = n_shards;
+    header.n_runs = n_runs;
+    header.n_blocks = n_blocks;
+    header.first_block = first_block;
+    header.last_block = last_block;
+    header.study = getContextHash(comp->ctx);
+
+    writePartial(fp, &header, sizeof(PartialHeader));
+} /*}}}2*/
 
-    setArchers();
+static void writePartialBlock(FILE *fp, int32_t index, const CompetitionsBlock *block) /*{{{2*/
+/*
+ * Writes the raw statistics (counters and Stat moments) of a block to a
+ * partial results file, where;
+ * fp = partial results file
+ * index = index of the block in the study
+ * block = statistics of the block
+ */
+{
+    int i;
 
-    if (with_progress && q_nruns>50) {
-        printf("\n0----------------------------------------------100\n");
+    writePartial(fp, &index, sizeof(int32_t));
+    for (i = 0; i < 104; i++) {
+        writePartial(fp, &(block->archer[i].q_n), sizeof(int));
+        writePartial(fp, &(block->archer[i].q_score_stat), sizeof(Stat));
     }
+    writePartial(fp, &(block->qstats), sizeof(QualificationStatistics));
+    writePartial(fp, &(block->elimstats), sizeof(EliminationStatistics));
+} /*}}}2*/
 
-    for (j = 0; j < q_nruns; j++) {
-        doQualificationRound();
+static void readPartialFile(Competitions *comp, const char *filename) /*{{{2*/
+/*
+ * Reads the blocks of a partial results file (of the same study) and adds
+ * the ones that are next in block order to the statistics, where;
+ * comp = competitions being merged
+ * filename = partial results file written by a shard (--partial-out)
+ */
+{
+    PartialHeader header;
+    FILE *fp;
+    int b;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Cannot open partial results file %s\n", filename);
+        fatal("Merge failed");
+    }
 
-        /* Elimination */
-        doEliminationRound();
+    if (readPartialHeader(fp, &header) != 0) {
+        fprintf(stderr, "%s is not a partial results file of this program (version)\n", filename);
+        fatal("Merge failed");
+    }
+    if (header.study != getContextHash(comp->ctx) || header.n_runs != comp->n_runs ||
+        header.n_blocks != comp->n_blocks ||
+        header.first_block < 0 || header.last_block > comp->n_blocks) {
+        fprintf(stderr, "%s holds another study (options, seed or number of runs differ)\n", filename);
+        fatal("Merge failed");
+    }
 
-        if (with_progress && q_nruns>50 && j%(q_nruns/50)==0) {
-            printf("#"); fflush(stdout);
+    for (b = header.first_block; b < header.last_block; b++) {
+        if (b < comp->n_added || comp->block[b] != NULL) {
+            fprintf(stderr, "%s overlaps another shard (block %d)\n", filename, b);
+            fatal("Merge failed");
         }
+        comp->block[b] = readPartialBlock(fp, b, filename);
     }
-    if (with_progress && q_nruns>50) {
-        printf("\n");
+    fclose(fp);
+
+    /* Shards can be given in any order, the blocks are added in block order */
+    addCompetitionsBlocks(comp);
+} /*}}}2*/
+
+static int readPartialHeader(FILE *fp, PartialHeader *header) /*{{{2*/
+/*
+ * Reads the header of a partial results file, returns 0 when it is written
+ * by this build (-1 otherwise)
+ */
+{
+    if (fread(header, sizeof(PartialHeader), 1, fp) != 1 ||
+        memcmp(header->magic, PARTIAL_MAGIC, sizeof(PARTIAL_MAGIC)) != 0 ||
+        header->version != PARTIAL_VERSION || header->record_size != PARTIAL_RECORD_SIZE) {
+        return -1;
     }
+    return 0;
+} /*}}}2*/
 
-    dumpEliminationStats();
+static CompetitionsBlock *readPartialBlock(FILE *fp, int32_t index, const char *filename) /*{{{2*/
+/*
+ * Returns the next block (allocated) of a partial results file, where;
+ * fp = partial results file
+ * index = index of the block expected
+ * filename = name of the file (for errors)
+ */
+{
+    CompetitionsBlock *block;
+    int32_t found;
+    int i;
+
+    readPartial(fp, &found, sizeof(int32_t), filename);
+    if (found != index) {
+        fprintf(stderr, "%s is corrupt (block %d expected)\n", filename, index);
+        fatal("Cannot read partial results file");
+    }
+
+    block = malloc(sizeof(CompetitionsBlock));
+    if (block == NULL) {
+        fatal("readPartialBlock() out of memory");
+    }
+    for (i = 0; i < 104; i++) {
+        readPartial(fp, &(block->archer[i].q_n), sizeof(int), filename);
+        readPartial(fp, &(block->archer[i].q_score_stat), sizeof(Stat), filename);
+    }
+    readPartial(fp, &(block->qstats), sizeof(QualificationStatistics), filename);
+    readPartial(fp, &(block->elimstats), sizeof(EliminationStatistics), filename);
+    block->event = NULL;
+    block->n_events = 0;
+
+    return block;
+} /*}}}2*/
+
+static void writePartial(FILE *fp, const void *data, size_t size) /*{{{2*/
+{
+    if (fwrite(data, size, 1, fp) != 1) {
+        fatal("Cannot write partial results file");
+    }
 } /*}}}2*/
 
+static void readPartial(FILE *fp, void *data, size_t size, const char *filename) /*{{{2*/
+{
+    if (fread(data, size, 1, fp) != 1) {
+        fprintf(stderr, "%s is truncated\n", filename);
+        fatal("Cannot read partial results file");
+    }
+} /*}}}2*/
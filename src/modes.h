@@ -30,6 +30,8 @@
 
 /* --- Interface {{{1 */
 
+struct SimulationContext;
+
 #define MODE_SCORE                      1
 #define MODE_QUALIFICATION              2
 #define MODE_ELIMINATION                3
@@ -37,13 +39,17 @@
 #define MODE_MIXED_TEAM_ELIMINATION     5
 #define MODE_COMPETITION                6
 #define MODE_COMPETITIONS               7
+#define MODE_CHECK_ARROW_SAMPLER        8
+#define MODE_SCAN_EVENT_LOG             9
 
-void modeScore(void);
-void modeQualification(void);
-void modeElimination(void);
-void modeTeamElimination(void);
-void modeMixedTeamElimination(void);
-void modeCompetition(void);
-void modeCompetitions(void);
+void modeScore(struct SimulationContext *ctx);
+void modeQualification(struct SimulationContext *ctx);
+void modeElimination(struct SimulationContext *ctx);
+void modeTeamElimination(struct SimulationContext *ctx);
+void modeMixedTeamElimination(struct SimulationContext *ctx);
+void modeCompetition(struct SimulationContext *ctx);
+void modeCompetitions(struct SimulationContext *ctx);
+void modeCheckArrowSampler(struct SimulationContext *ctx);
+void modeScanEventLog(struct SimulationContext *ctx);
 
 #endif
@@ -0,0 +1,132 @@
+/*****************************************************************************
+*** Name      : pool.c                                                     ***
+*** Purpose   : Implements a pool of threads running independent tasks     ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pool.h"
+#include "dump.h"
+
+/* --- Local data types {{{1 */
+
+typedef struct {
+    PoolTask  task;
+    void     *arg;
+    int       n_tasks;
+    int       next;     /* Next task not yet taken by a worker */
+} Pool;
+
+typedef struct {
+    Pool     *pool;
+    int       worker;
+} Worker;
+
+/* --- Local prototypes {{{1 */
+
+static void runWorker(Pool *pool, int worker);
+static void *runWorkerThread(void *arg);
+
+/* --- Implementation {{{1 */
+
+int getPoolWorkers(int n_tasks) /*{{{2*/
+/*
+ * Returns the number of workers to run n_tasks tasks on; n_threads, but no
+ * more than there are tasks (and at least 1)
+ */
+{
+    int n = n_threads;
+
+    if (n > n_tasks) n = n_tasks;
+    if (n < 1) n = 1;
+    return n;
+} /*}}}2*/
+
+void runPoolTasks(int n_workers, int n_tasks, PoolTask task, void *arg) /*{{{2*/
+/*
+ * Runs tasks 0..n_tasks-1 on n_workers workers and returns when all are
+ * done, where;
+ * n_workers = number of workers, worker 0 is the calling thread
+ * n_tasks = number of tasks
+ * task = function running a task
+ * arg = argument passed to every task
+ * Idle workers take the next task not yet taken, so tasks of uneven
+ * length are balanced over the workers. Tasks must be independent
+ */
+{
+    Pool pool;
+    Worker *worker;
+    pthread_t *thread;
+    int w;
+
+    pool.task = task;
+    pool.arg = arg;
+    pool.n_tasks = n_tasks;
+    pool.next = 0;
+
+    if (n_workers <= 1) {
+        runWorker(&pool, 0);
+        return;
+    }
+
+    worker = malloc(n_workers*sizeof(Worker));
+    thread = malloc(n_workers*sizeof(pthread_t));
+    if (worker == NULL || thread == NULL) {
+        fatal("runPoolTasks() out of memory");
+    }
+
+    for (w = 1; w < n_workers; w++) {
+        worker[w].pool = &pool;
+        worker[w].worker = w;
+        if (pthread_create(&thread[w], NULL, runWorkerThread, &worker[w]) != 0) {
+            fatal("runPoolTasks() cannot create thread");
+        }
+    }
+    runWorker(&pool, 0);
+    for (w = 1; w < n_workers; w++) {
+        pthread_join(thread[w], NULL);
+    }
+
+    free(thread);
+    free(worker);
+} /*}}}2*/
+
+/* --- Internals {{{1 */
+
+static void runWorker(Pool *pool, int worker) /*{{{2*/
+{
+    int t;
+
+    while ((t = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->n_tasks) {
+        pool->task(pool->arg, worker, t);
+    }
+} /*}}}2*/
+
+static void *runWorkerThread(void *arg) /*{{{2*/
+{
+    Worker *worker = arg;
+
+    runWorker(worker->pool, worker->worker);
+    return NULL;
+} /*}}}2*/
@@ -0,0 +1,48 @@
+/*****************************************************************************
+*** Name      : pool.h                                                     ***
+*** Purpose   : Defines a pool of threads running independent tasks        ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _POOL_H
+#define _POOL_H
+
+/* --- Data types {{{1 */
+
+/*
+ * A task of the pool, where;
+ * arg = argument given to runPoolTasks()
+ * worker = index (0..n_workers-1) of the worker running the task, so a task
+ *          can use state owned by its worker (e.g. a context)
+ * task = index (0..n_tasks-1) of the task
+ */
+typedef void (*PoolTask)(void *arg, int worker, int task);
+
+/* --- Interface {{{1 */
+
+/*
+ * Number of threads (--threads) the simulations are run on
+ */
+extern int n_threads;
+
+int getPoolWorkers(int n_tasks);
+void runPoolTasks(int n_workers, int n_tasks, PoolTask task, void *arg);
+
+#endif
@@ -0,0 +1,259 @@
+/*****************************************************************************
+*** Name      : progress.c                                                 ***
+*** Purpose   : Implements the progress reporter of long simulations       ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "progress.h"
+#include "dump.h"
+
+/* --- Local data types {{{1 */
+
+/* Seconds between progress reports on a terminal (redrawn) and otherwise */
+#define PROGRESS_INTERVAL_TTY   1.0
+#define PROGRESS_INTERVAL_LOG  10.0
+
+typedef struct {
+    int              running;
+    int              stop;
+    int              tty;
+    const char      *unit;
+    long             n_total;
+    long             n_done;        /* Updated by the workers (atomic)  */
+    long             n_arrows;
+    InterimReport    interim;
+    void            *arg;
+    struct timespec  start;
+    pthread_t        thread;
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+} Progress;
+
+/* --- Global data {{{1 */
+
+double interim_interval = 0.0;
+
+/* --- Local data {{{1 */
+
+/* The condition (on the monotonic clock) is set up by startProgress() */
+static Progress progress = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/* --- Local prototypes {{{1 */
+
+static void *runProgress(void *arg);
+static void printProgress(int final);
+static double getElapsed(void);
+static const char *formatTime(char *buf, size_t size, double seconds);
+static const char *formatRate(char *buf, size_t size, double rate);
+
+/* --- Implementation {{{1 */
+
+void startProgress(const char *unit, long n_total, InterimReport interim, void *arg) /*{{{2*/
+/*
+ * Starts reporting the progress of a simulation on stderr (with --progress
+ * or --interim-stats), where;
+ * unit = what is simulated (plural, e.g. "competitions")
+ * n_total = number of units to simulate
+ * interim = prints the interim statistics, or NULL when there are none
+ * arg = argument passed to interim
+ * The workers report finished units with addProgress()
+ */
+{
+    pthread_condattr_t attr;
+
+    if ((!with_progress && interim_interval <= 0.0) || n_total <= 0) return;
+
+    /* Waits until a deadline on the monotonic clock (as the elapsed time) */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&progress.cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    progress.stop = 0;
+    progress.tty = isatty(STDERR_FILENO);
+    progress.unit = unit;
+    progress.n_total = n_total;
+    progress.n_done = 0;
+    progress.n_arrows = 0;
+    progress.interim = interim;
+    progress.arg = arg;
+    clock_gettime(CLOCK_MONOTONIC, &progress.start);
+
+    if (pthread_create(&progress.thread, NULL, runProgress, NULL) != 0) {
+        fatal("Cannot create progress thread");
+    }
+    progress.running = 1;
+} /*}}}2*/
+
+void addProgress(long n_done, long n_arrows) /*{{{2*/
+/*
+ * Adds finished units (and the arrows shot for them) to the progress, may
+ * be called from any worker
+ */
+{
+    if (!progress.running) return;
+
+    __atomic_fetch_add(&progress.n_done, n_done, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&progress.n_arrows, n_arrows, __ATOMIC_RELAXED);
+} /*}}}2*/
+
+void stopProgress(void) /*{{{2*/
+/*
+ * Ends the progress reporting with a final report
+ */
+{
+    if (!progress.running) return;
+
+    pthread_mutex_lock(&progress.lock);
+    progress.stop = 1;
+    pthread_cond_broadcast(&progress.cond);
+    pthread_mutex_unlock(&progress.lock);
+
+    pthread_join(progress.thread, NULL);
+    pthread_cond_destroy(&progress.cond);
+    progress.running = 0;
+
+    printProgress(1);
+} /*}}}2*/
+
+/* --- Local functions {{{1 */
+
+static void *runProgress(void *arg) /*{{{2*/
+/*
+ * Reporter thread; reports the progress and the interim statistics at
+ * their intervals until stopped
+ */
+{
+    double interval = progress.tty ? PROGRESS_INTERVAL_TTY : PROGRESS_INTERVAL_LOG;
+    double next_report = with_progress ? interval : -1.0;
+    double next_interim = (progress.interim != NULL && interim_interval > 0.0) ? interim_interval : -1.0;
+
+    pthread_mutex_lock(&progress.lock);
+    while (!progress.stop) {
+        struct timespec until = progress.start;
+        double next = next_report;
+        double t;
+
+        if (next < 0.0 || (next_interim >= 0.0 && next_interim < next)) next = next_interim;
+        if (next < 0.0) next = 3600.0;  /* Nothing to report, wait to be stopped */
+
+        until.tv_sec += (time_t)next;
+        until.tv_nsec += (long)((next - (double)(time_t)next)*1e9);
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        if (pthread_cond_timedwait(&progress.cond, &progress.lock, &until) != ETIMEDOUT) continue;
+
+        pthread_mutex_unlock(&progress.lock);
+        t = getElapsed();
+        if (next_interim >= 0.0 && t >= next_interim) {
+            if (progress.tty && with_progress) fprintf(stderr, "\r\033[K");
+            progress.interim(progress.arg, stderr);
+            fflush(stderr);
+            while (next_interim <= t) next_interim += interim_interval;
+        }
+        if (next_report >= 0.0 && t >= next_report) {
+            printProgress(0);
+            while (next_report <= t) next_report += interval;
+        }
+        pthread_mutex_lock(&progress.lock);
+    }
+    pthread_mutex_unlock(&progress.lock);
+
+    return arg;
+} /*}}}2*/
+
+static void printProgress(int final) /*{{{2*/
+/*
+ * Prints the progress; done, throughput, elapsed time and expected time
+ * left. On a terminal the line is redrawn, the final report ends it
+ */
+{
+    long n_done = __atomic_load_n(&progress.n_done, __ATOMIC_RELAXED);
+    long n_arrows = __atomic_load_n(&progress.n_arrows, __ATOMIC_RELAXED);
+    double t = getElapsed();
+    double rate = (t > 0.0) ? n_done/t : 0.0;
+    char units[32], arrows[32], elapsed[32], eta[32];
+
+    if (!with_progress) return;
+
+    fprintf(stderr, "%s%5.1lf%% %ld/%ld %s, %s %s/s, %s arrows/s, elapsed %s",
+            progress.tty ? "\r\033[K" : "",
+            100.0*n_done/progress.n_total, n_done, progress.n_total, progress.unit,
+            formatRate(units, sizeof(units), rate), progress.unit,
+            formatRate(arrows, sizeof(arrows), (t > 0.0) ? n_arrows/t : 0.0),
+            formatTime(elapsed, sizeof(elapsed), t));
+    if (!final) {
+        fprintf(stderr, ", ETA %s",
+                (n_done > 0) ? formatTime(eta, sizeof(eta), (progress.n_total-n_done)/rate) : "-");
+    }
+    if (!progress.tty || final) fputc('\n', stderr);
+    fflush(stderr);
+} /*}}}2*/
+
+static double getElapsed(void) /*{{{2*/
+/*
+ * Returns the seconds since startProgress()
+ */
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - progress.start.tv_sec) + 1e-9*(now.tv_nsec - progress.start.tv_nsec);
+} /*}}}2*/
+
+static const char *formatTime(char *buf, size_t size, double seconds) /*{{{2*/
+/*
+ * Formats seconds as H:MM:SS in buf (of size bytes) and returns it. Times
+ * are clamped to 99999 hours, the ETA is huge while the rate is still low
+ */
+{
+    long s = (seconds < 99999*3600.0) ? (long)(seconds + 0.5) : 99999*3600L;
+
+    snprintf(buf, size, "%ld:%02ld:%02ld", s/3600, (s/60)%60, s%60);
+    return buf;
+} /*}}}2*/
+
+static const char *formatRate(char *buf, size_t size, double rate) /*{{{2*/
+{
+    if (rate >= 1e9) {
+        snprintf(buf, size, "%.2lfG", rate/1e9);
+    }
+    else if (rate >= 1e6) {
+        snprintf(buf, size, "%.2lfM", rate/1e6);
+    }
+    else if (rate >= 1e4) {
+        snprintf(buf, size, "%.1lfk", rate/1e3);
+    }
+    else {
+        snprintf(buf, size, "%.0lf", rate);
+    }
+    return buf;
+} /*}}}2*/
@@ -0,0 +1,54 @@
+/*****************************************************************************
+*** Name      : progress.h                                                 ***
+*** Purpose   : Defines the progress reporter of long simulations          ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _PROGRESS_H
+#define _PROGRESS_H
+
+/* --- Includes {{{1 */
+
+#include <stdio.h>
+
+/* --- Data types {{{1 */
+
+/*
+ * Prints the statistics gathered so far of a simulation (--interim-stats),
+ * called from the reporter thread, where;
+ * arg = argument given to startProgress()
+ * out = stream to print to
+ */
+typedef void (*InterimReport)(void *arg, FILE *out);
+
+/* --- Interface {{{1 */
+
+/*
+ * Report progress (--progress) and print interim statistics every
+ * interim_interval seconds (--interim-stats, 0 = never)
+ */
+extern int with_progress;
+extern double interim_interval;
+
+void startProgress(const char *unit, long n_total, InterimReport interim, void *arg);
+void addProgress(long n_done, long n_arrows);
+void stopProgress(void);
+
+#endif
@@ -35,186 +35,306 @@
 #include "score.h"
 #include "format.h"
 #include "stats.h"
+#include "random.h"
+#include "context.h"
 
 /* --- Global data {{{1*/
 
 extern int pretty_print;
 
 int q_nruns = 5000;
-QualificationStatistics qstats;
+
+/* Uniforms per lane drawn at once by doQualificationRoundLanes() (even) */
+#define QUALIFICATION_CHUNK 64
 
 /* --- Local prototypes {{{1*/
 
-static void createQualificationRanking(int signdec);
-static double getQualificationRankCorrectness(void);
-static int isTied(int sign_dec, double s1, double s2);
-static void randomizeRange(int from, int to);
+static void finishQualificationRound(SimulationContext *ctx);
+
+static void createQualificationRanking(SimulationContext *ctx);
+static double getQualificationRankCorrectness(SimulationContext*);
+static void sortOnScore(Archer **rank, int n);
+static void randomizeRange(SimulationContext *ctx, int from, int to);
 
 /* --- Implementation {{{1*/
 
-void initQualificationStats(void) /*{{{2*/
+void initQualificationStats(SimulationContext *ctx) /*{{{2*/
 /*
  * Initialize (set zero) qualification statistics
  */
 {
     for (int i = 0; i < 104; i++) {
-        resetStat(&(archer[i].q_score_stat));
+        resetStat(&(ctx->archer[i].q_score_stat));
     }
-    qstats.n = 0;
-    resetStat(&(qstats.n_ties));
-    resetStat(&(qstats.fc));
+    ctx->qstats.n = 0;
+    resetStat(&(ctx->qstats.n_ties));
+    resetStat(&(ctx->qstats.fc));
+} /*}}}2*/
+
+void mergeQualificationStats(QualificationStatistics *dst, const QualificationStatistics *src) /*{{{2*/
+/*
+ * Adds the qualification statistics of separately simulated rounds (of the
+ * same population) to dst, where;
+ * dst = statistics to add to
+ * src = statistics to add
+ */
+{
+    dst->n += src->n;
+    combineStat(&(dst->n_ties), &(src->n_ties));
+    combineStat(&(dst->fc), &(src->fc));
 } /*}}}2*/
 
-void doQualificationRound(void) /*{{{2*/
+void doQualificationRound(SimulationContext *ctx) /*{{{2*/
 /*
  * Perform a single qualification round for archers in set format
+ * ctx : simulation context
  */
 {
-    const Face *face = getFace(q_format.facetype);
-    const double dist = q_format.distance;
-    const int narrows = q_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    const double dist = ctx->q_format.distance;
+    const int narrows = ctx->q_format.narrows;
     int i;
-    int n_tie;
 
     for (i = 0; i < 104; i++) {
-        /* Compute score (theoretical) based on skill level */
-        archer[i].lvl_score = getScoreBySkillLevel(archer[i].lvl, face, dist, narrows);
-
         /* Simulate Q round */
-        archer[i].q_score = getScore(archer[i].lvl, face, dist, narrows);
+        ctx->archer[i].q_score = getArcherScore(&ctx->rs, ctx->archer[i].q_table, ctx->archer[i].lvl, face, dist, narrows);
+    }
+
+    finishQualificationRound(ctx);
+} /*}}}2*/
+
+void doQualificationRoundLanes(SimulationContext **lane, int n_lanes) /*{{{2*/
+/*
+ * Perform a qualification round on each of n_lanes contexts at once, with
+ * the same result as doQualificationRound() on each, where;
+ * lane = contexts (copies of one context, so with the same archers and
+ *        arrow value tables) each at its own run
+ * n_lanes = number of contexts (at most QUALIFICATION_LANES)
+ * The scores of all lanes are drawn in lockstep; archer by archer and end by
+ * end, with the uniforms of all lanes generated side by side
+ * (getUniformRandomLanes()) and sampled from the same end distribution
+ */
+{
+    SimulationContext *ctx = lane[0];
+    const int narrows = ctx->q_format.narrows;
+    const int n_full = narrows / MAX_END_ARROWS;
+    const int n_ends = n_full + ((narrows % MAX_END_ARROWS) > 0);
+    const int n_draws = 104*n_ends;
+    const EndDistribution *full[104];
+    const EndDistribution *last[104];
+    RandomStream *rs[QUALIFICATION_LANES];
+    Score q_score[QUALIFICATION_LANES][104];
+    double u[QUALIFICATION_CHUNK*QUALIFICATION_LANES];
+    int i, k, l;
+
+    if (n_lanes > QUALIFICATION_LANES || arrow_sampler != ARROW_SAMPLER_ALIAS || n_ends == 0) {
+        for (l = 0; l < n_lanes; l++) {
+            doQualificationRound(lane[l]);
+        }
+        return;
+    }
+
+    for (i = 0; i < 104; i++) {
+        full[i] = (n_full > 0) ? getEndDistribution(ctx->archer[i].q_table, MAX_END_ARROWS) : NULL;
+        last[i] = (narrows % MAX_END_ARROWS) ? getEndDistribution(ctx->archer[i].q_table, narrows % MAX_END_ARROWS) : NULL;
+    }
+    for (l = 0; l < n_lanes; l++) {
+        rs[l] = &lane[l]->rs;
+        for (i = 0; i < 104; i++) {
+            q_score[l][i] = 0;
+        }
+    }
+
+    /* Draw k is end k%n_ends of archer k/n_ends, as getScoreFromTable() */
+    for (k = 0; k < n_draws; k += QUALIFICATION_CHUNK) {
+        int n = (n_draws-k < QUALIFICATION_CHUNK) ? n_draws-k : QUALIFICATION_CHUNK;
+        int j;
+
+        getUniformRandomLanes(rs, n_lanes, u, n);
+        for (j = 0; j < n; j++) {
+            const int archer = (k+j) / n_ends;
+            const EndDistribution *end = ((k+j) % n_ends < n_full) ? full[archer] : last[archer];
+
+            for (l = 0; l < n_lanes; l++) {
+                q_score[l][archer] += end->unit * sampleAliasTable(end->alias, u[j*n_lanes+l]);
+            }
+        }
+    }
+
+    for (l = 0; l < n_lanes; l++) {
+        for (i = 0; i < 104; i++) {
+            lane[l]->archer[i].q_score = q_score[l][i];
+        }
+        finishQualificationRound(lane[l]);
+    }
+} /*}}}2*/
+
+static void finishQualificationRound(SimulationContext *ctx) /*{{{2*/
+/*
+ * Ranks a qualification round of which the scores (q_score) are shot and
+ * adds it to the statistics
+ */
+{
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    int i;
+    int n_tie;
+
+    for (i = 0; i < 104; i++) {
+        /* Compute score (theoretical) based on skill level, once per archer */
+        if (ctx->archer[i].lvl_score < 0.0) {
+            ctx->archer[i].lvl_score = getScoreBySkillLevel(ctx->archer[i].lvl, face, ctx->q_format.distance, ctx->q_format.narrows);
+        }
 
         /* Following parameters are needed for multiple Q rounds */
-        addStat(&(archer[i].q_score_stat), archer[i].q_score);
+        addStat(&(ctx->archer[i].q_score_stat), SCORE_TO_DOUBLE(ctx->archer[i].q_score));
     }
 
     /* Create the qualification ranking */
-    createQualificationRanking(face->significant_decimals);
+    createQualificationRanking(ctx);
 
     /* Add some statistics (e.g. ranking statistics) */
 
     /* Determine and add number of ties */
     n_tie = 0;
     for (i = 0; i < 103; i++) {
-        if (isTied(face->significant_decimals, archerrank[i]->q_score, archerrank[i+1]->q_score)) {
+        if (ctx->archerrank[i]->q_score == ctx->archerrank[i+1]->q_score) {
             n_tie++;
         }
     }
-    addStat(&(qstats.n_ties), n_tie);
+    addStat(&(ctx->qstats.n_ties), n_tie);
     /* Add qualification rank correctness */
-    addStat(&(qstats.fc), getQualificationRankCorrectness());
+    addStat(&(ctx->qstats.fc), getQualificationRankCorrectness(ctx));
 
-    qstats.n = qstats.n + 1;
+    ctx->qstats.n = ctx->qstats.n + 1;
 } /*}}}2*/
 
-void doQualificationRounds(int n) /*{{{2*/
+void doQualificationRounds(SimulationContext *ctx, int n) /*{{{2*/
 /*
  * Perform n qualification rounds for archers in given format, compute their average and stddev
+ * ctx : simulation context
  * format : this format
  */
 {
-    const Face *face = getFace(q_format.facetype);
-    const double dist = q_format.distance;
-    const int narrows = q_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    const double dist = ctx->q_format.distance;
+    const int narrows = ctx->q_format.narrows;
     double sum = 0.0;
     int i, j;
 
-    initQualificationStats();
+    initQualificationStats(ctx);
 
     /* Simulate n Q rounds */
     for (j = 0; j < n; j++) {
-        doQualificationRound();
+        doQualificationRound(ctx);
     }
     for (i = 0; i < 104; i++) {
-        /* Replace last q_score for average to get sorting right */
-        archer[i].q_score = archer[i].q_score_stat.avg;
+        /* Replace last q_score for (rounded) average, ranking is on the exact average */
+        ctx->archer[i].q_score = (Score)lround(getMean(&(ctx->archer[i].q_score_stat))*SCORE_SCALE);
     }
 
-    rankArchersOnQualifyingScore(1, 104);
+    rankArchersOnQualifyingScore(ctx, 1, 104);
     for (i = 0; i < 104; i++) {
-        archerrank[i]->q_rank = (i+1);
+        ctx->archerrank[i]->q_rank = (i+1);
     }
 
 } /*}}}2*/
 
-void doTeamQualificationRound(void) /*{{{2*/
+void doTeamQualificationRound(SimulationContext *ctx) /*{{{2*/
 /*
  * Perform a single qualification round for teams in given format
+ * ctx : simulation context
  * format : this format
  */
 {
-    const Face *face = getFace(q_format.facetype);
-    const double dist = q_format.distance;
-    const int narrows = q_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    const double dist = ctx->q_format.distance;
+    const int narrows = ctx->q_format.narrows;
     int i;
 
     for (i = 0; i < 16; i++) {
         /* Simulate Q round */
-        team[i].archer[0].q_score = getScore(team[i].archer[0].lvl, face, dist, narrows);
-        team[i].archer[1].q_score = getScore(team[i].archer[1].lvl, face, dist, narrows);
-        team[i].archer[2].q_score = getScore(team[i].archer[2].lvl, face, dist, narrows);
+        ctx->team[i].archer[0].q_score = getArcherScore(&ctx->rs, ctx->team[i].archer[0].q_table, ctx->team[i].archer[0].lvl, face, dist, narrows);
+        ctx->team[i].archer[1].q_score = getArcherScore(&ctx->rs, ctx->team[i].archer[1].q_table, ctx->team[i].archer[1].lvl, face, dist, narrows);
+        ctx->team[i].archer[2].q_score = getArcherScore(&ctx->rs, ctx->team[i].archer[2].q_table, ctx->team[i].archer[2].lvl, face, dist, narrows);
     }
 
     for (i = 0; i < 16; i++) {
-        teamrank[i] = &(team[i]);
+        ctx->teamrank[i] = &(ctx->team[i]);
     }
-    rankTeams(1, 16);
+    rankTeams(ctx, 1, 16);
     for (i = 0; i < 16; i++) {
-        teamrank[i]->q_rank = (i+1);
+        ctx->teamrank[i]->q_rank = (i+1);
     }
 
 } /*}}}2*/
 
-void doMixedTeamQualificationRound(void) /*{{{2*/
+void doMixedTeamQualificationRound(SimulationContext *ctx) /*{{{2*/
 /*
  * Perform a single qualification round for mixedteams in given format
+ * ctx : simulation context
  * format : this format
  */
 {
-    const Face *face = getFace(q_format.facetype);
-    const double dist = q_format.distance;
-    const int narrows = q_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    const double dist = ctx->q_format.distance;
+    const int narrows = ctx->q_format.narrows;
     int i;
 
     for (i = 0; i < 24; i++) {
         /* Simulate Q round */
-        mixedteam[i].archer[0].q_score = getScore(team[i].archer[0].lvl, face, dist, narrows);
-        mixedteam[i].archer[1].q_score = getScore(team[i].archer[1].lvl, face, dist, narrows);
+        ctx->mixedteam[i].archer[0].q_score = getArcherScore(&ctx->rs, ctx->mixedteam[i].archer[0].q_table, ctx->mixedteam[i].archer[0].lvl, face, dist, narrows);
+        ctx->mixedteam[i].archer[1].q_score = getArcherScore(&ctx->rs, ctx->mixedteam[i].archer[1].q_table, ctx->mixedteam[i].archer[1].lvl, face, dist, narrows);
     }
 
     for (i = 0; i < 24; i++) {
-        mixedteamrank[i] = &(mixedteam[i]);
+        ctx->mixedteamrank[i] = &(ctx->mixedteam[i]);
     }
-    rankMixedTeams(1, 24);
+    rankMixedTeams(ctx, 1, 24);
     for (i = 0; i < 24; i++) {
-        mixedteamrank[i]->q_rank = (i+1);
+        ctx->mixedteamrank[i]->q_rank = (i+1);
     }
 
 } /*}}}2*/
 
-void dumpQualificationStats(void) /*{{{2*/
+void dumpQualificationStats(SimulationContext *ctx) /*{{{2*/
 {
     if (pretty_print) {
         outp("\nQualification statistics\n");
         outp("========================\n");
         outp("Population: %s\n", name_of_population);
-        outp("Format    : %s\n", getFormatName(&q_format));
+        outp("Format    : %s\n", getFormatName(&ctx->q_format));
         outp("Runs      : %ld\n\n", q_nruns);
         outp("Results\n");
-        outp("Average number of ties : %5.2lf\n", qstats.n_ties.avg);
-        outp("                StdDev : %5.2lf\n", qstats.n_ties.stdev);
-        outp("Average correctness    : %lf\n", qstats.fc.avg);
-        outp("                StdDev : %lf\n\n", qstats.fc.stdev);
+        outp("Average number of ties : %5.2lf\n", getMean(&(ctx->qstats.n_ties)));
+        outp("                StdDev : %5.2lf\n", getStdev(&(ctx->qstats.n_ties)));
+        outp("Average correctness    : %lf\n", getMean(&(ctx->qstats.fc)));
+        outp("                StdDev : %lf\n\n", getStdev(&(ctx->qstats.fc)));
+    }
+    else if (output_format == OUTPUT_BINARY) {
+        static const TableColumn column[5] = {
+            { "n_runs",     COLUMN_INT },
+            { "ties_mean",  COLUMN_DOUBLE },
+            { "ties_stdev", COLUMN_DOUBLE },
+            { "fc_mean",    COLUMN_DOUBLE },
+            { "fc_stdev",   COLUMN_DOUBLE },
+        };
+        beginTable("qualification", 5, column);
+        tableInt(q_nruns);
+        tableDouble(getMean(&(ctx->qstats.n_ties)));
+        tableDouble(getStdev(&(ctx->qstats.n_ties)));
+        tableDouble(getMean(&(ctx->qstats.fc)));
+        tableDouble(getStdev(&(ctx->qstats.fc)));
     }
     else {
         outp("\"%s\";%s;%lf;%lf;%lf;%lf;%ld\n",
                 name_of_population,
-                getFormatName(&q_format), qstats.n_ties.avg, qstats.n_ties.stdev, qstats.fc.avg, qstats.fc.stdev,q_nruns);
+                getFormatName(&ctx->q_format), getMean(&(ctx->qstats.n_ties)), getStdev(&(ctx->qstats.n_ties)), getMean(&(ctx->qstats.fc)), getStdev(&(ctx->qstats.fc)),q_nruns);
     }
 } /*}}}2*/
 
 /* --- Local functions {{{1 */
 
-static double getQualificationRankCorrectness(void) /*{{{2*/
+static double getQualificationRankCorrectness(SimulationContext *ctx) /*{{{2*/
 /*
  * Compute the correctness factor for this ranking
  *
@@ -232,12 +352,12 @@ static double getQualificationRankCorrectness(void) /*{{{2*/
     int i;
 
     for (i = 0; i < 104; i++) {
-        f += (archer[i].lvl_rank - archer[i].q_rank) * (archer[i].lvl_rank - archer[i].q_rank);
+        f += (ctx->archer[i].lvl_rank - ctx->archer[i].q_rank) * (ctx->archer[i].lvl_rank - ctx->archer[i].q_rank);
     }
     return sqrt(f)/104.0;
 } /*}}}2*/
 
-static void createQualificationRanking(int signdec) /*{{{2*/
+static void createQualificationRanking(SimulationContext *ctx) /*{{{2*/
 /*
  * Order a single qualification round a bit according to WA rules.
  * We do not order with 'X' count, but if there is a tie, a coin toss
@@ -245,57 +365,41 @@ static void createQualificationRanking(int signdec) /*{{{2*/
  */
 {
     int i, j;
-    double sc1, sc2;
+    Score sc1, sc2;
 
 #ifdef DEBUG
     dumpArcher(NULL);
     for (i = 0; i < 104; i++) {
         /* Have each archerrank point to an archer */
-        archerrank[i] = &(archer[i]);
-        dumpArcher(archerrank[i]);
+        ctx->archerrank[i] = &(ctx->archer[i]);
+        dumpArcher(ctx->archerrank[i]);
     }
 #endif
 
     /* Order them to score */
-    for (i = 0; i < 103; i++) {
-        int max_idx = i;
-        double max_value = archerrank[i]->q_score;
-        for (j = i+1; j < 104; j++) {
-            if (archerrank[j]->q_score > max_value) {
-                max_idx = j;
-                max_value = archerrank[max_idx]->q_score;
-            }
-        }
-        if (max_idx != i) {
-            /* swap */
-            D("Sort swap %d with %d\n", i+1, max_idx+1);
-            Archer *tmp = archerrank[i];
-            archerrank[i] = archerrank[max_idx];
-            archerrank[max_idx] = tmp;
-        }
-    }
+    sortOnScore(ctx->archerrank, 104);
 
 #ifdef DEBUG
     dumpArcher(NULL);
     for (i = 0; i < 104; i++) {
         /* Have each archerrank point to an archer */
-        dumpArcher(archerrank[i]);
+        dumpArcher(ctx->archerrank[i]);
     }
 #endif
 
     /* Now scan for ties */
     for (i = 0; i < 103;) {
         D("Scan for ties from %d\n", i);
-        sc1 = archerrank[i]->q_score;
+        sc1 = ctx->archerrank[i]->q_score;
         j = 0;
         do {
             j++;
-            sc2 = archerrank[i+j]->q_score;
-        } while ((i+j<103) && isTied(signdec, sc1, sc2));
+            sc2 = ctx->archerrank[i+j]->q_score;
+        } while ((i+j<103) && (sc1 == sc2));
         if (j >= 2) {
             /* 2-way or more */
             D("Found a %d-way tie\n", j);
-            randomizeRange(i, i+(j-1));
+            randomizeRange(ctx, i, i+(j-1));
         }
         i = i + j;
         D("Next is %d\n", i);
@@ -303,32 +407,68 @@ static void createQualificationRanking(int signdec) /*{{{2*/
 
     /* Set qualification ranking value */
     for (i = 0; i < 104; i++) {
-        archerrank[i]->q_rank = (i+1);
+        ctx->archerrank[i]->q_rank = (i+1);
     }
 
 #ifdef DEBUG
     dumpArcher(NULL);
     for (i = 0; i < 104; i++) {
         /* Have each archerrank point to an archer */
-        dumpArcher(archerrank[i]);
+        dumpArcher(ctx->archerrank[i]);
     }
 #endif
 
 } /*}}}2*/
 
-static int isTied(int sign_dec, double s1, double s2) /*{{{2*/
+static void sortOnScore(Archer **rank, int n) /*{{{2*/
+/*
+ * Sorts rank[0..n-1] (at most 104) on descending q_score. Scores are
+ * integers in a small range, so this is an LSD radix sort on the distance
+ * to the highest score, 8 bits per pass and only as many passes as the
+ * range of scores needs
+ */
 {
-    D("isTied(%d,%lf, %lf)\n", sign_dec, s1, s2);
-    long ls1 = (long)round(pow(10.0, sign_dec) * s1);
-    long ls2 = (long)round(pow(10.0, sign_dec) * s2);
-    int istied = (ls1 == ls2)?1:0;
+    Archer *tmp_rank[104];
+    unsigned int key[104];
+    unsigned int tmp_key[104];
+    unsigned int range;
+    Score max = rank[0]->q_score;
+    Score min = rank[0]->q_score;
+    int shift;
+    int i;
 
-    D("Is tied (signdec=%d) %ld %ld -> %s\n", sign_dec, ls1, ls2, (istied==1)?"yes":"no");
+    for (i = 1; i < n; i++) {
+        if (rank[i]->q_score > max) max = rank[i]->q_score;
+        if (rank[i]->q_score < min) min = rank[i]->q_score;
+    }
+    for (i = 0; i < n; i++) {
+        key[i] = (unsigned int)(max - rank[i]->q_score);
+    }
+    range = (unsigned int)(max - min);
+
+    for (shift = 0; shift < 32 && (range >> shift) > 0; shift += 8) {
+        int count[257] = { 0 };
+        int d;
 
-    return istied;
+        for (i = 0; i < n; i++) {
+            count[((key[i] >> shift) & 0xff) + 1]++;
+        }
+        for (d = 0; d < 256; d++) {
+            count[d+1] += count[d];
+        }
+        for (i = 0; i < n; i++) {
+            int pos = count[(key[i] >> shift) & 0xff]++;
+            tmp_rank[pos] = rank[i];
+            tmp_key[pos] = key[i];
+        }
+        for (i = 0; i < n; i++) {
+            rank[i] = tmp_rank[i];
+            key[i] = tmp_key[i];
+        }
+    }
 } /*}}}2*/
 
-static void randomizeRange(int from, int to) /*{{{2*/
+static void randomizeRange(SimulationContext *ctx, int from, int to) /*{{{2*/
 /*
  * Range <from> to <to> (to including) has tied, randomize these
  * tied archers
@@ -345,19 +485,19 @@ static void randomizeRange(int from, int to) /*{{{2*/
     D("Solving a %d-way tie\n", n+1);
 
     /* Randomize a number between 0 and n, pick that one to go on top and repeat */
-    int pick = (int)round((1.0 * n * (1.0 * rand() / RAND_MAX) )); /* 0 <= pick <= n */
+    int pick = getRandomInt(&ctx->rs, n); /* 0 <= pick <= n */
 
     if (pick > 0) {
         /* swap */
-        D("..swap %d(asl=%lf) with %d(asl=%lf)\n", from, archerrank[from]->lvl, from+pick, archerrank[from+pick]->lvl);
-        tmp = archerrank[from];
-        archerrank[from] = archerrank[from+pick];
-        archerrank[from+pick] = tmp;
+        D("..swap %d(asl=%lf) with %d(asl=%lf)\n", from, ctx->archerrank[from]->lvl, from+pick, ctx->archerrank[from+pick]->lvl);
+        tmp = ctx->archerrank[from];
+        ctx->archerrank[from] = ctx->archerrank[from+pick];
+        ctx->archerrank[from+pick] = tmp;
     }
     else {
         D("..No swap %d\n", from);
     }
 
-    randomizeRange(from+1, to);
+    randomizeRange(ctx, from+1, to);
 } /*}}}2*/
 
@@ -28,6 +28,7 @@
 
 #include "format.h"
 #include "stats.h"
+#include "random.h"
 
 /* --- Types {{{1 */
 
@@ -44,12 +45,19 @@ typedef struct {
 
 /* --- Interface {{{1 */
 
+/* Maximum number of competitions simulated in lockstep by doQualificationRoundLanes() */
+#define QUALIFICATION_LANES 8
+
 extern int q_nruns;
 
-void initQualificationStats(void);
-void doQualificationRound(void);
-void doQualificationRounds(int n);
-void doTeamQualificationRound(void);
-void dumpQualificationStats();
+struct SimulationContext;
+
+void initQualificationStats(struct SimulationContext *ctx);
+void doQualificationRound(struct SimulationContext *ctx);
+void doQualificationRoundLanes(struct SimulationContext **lane, int n_lanes);
+void doQualificationRounds(struct SimulationContext *ctx, int n);
+void doTeamQualificationRound(struct SimulationContext *ctx);
+void dumpQualificationStats(struct SimulationContext *ctx);
+void mergeQualificationStats(QualificationStatistics *dst, const QualificationStatistics *src);
 
 #endif
@@ -1,6 +1,7 @@
 /*****************************************************************************
 *** Name      : random.c                                                   ***
-*** Purpose   : Implements a random generator (using Box-Muller algo)      ***
+*** Purpose   : Implements counter-based random streams (Philox4x32-10)    ***
+***             and Gaussian random values (using Box-Muller algo)         ***
 *** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
 *** Copyright : 2013-2021                                                  ***
 ***                                                                        ***
@@ -23,96 +24,391 @@
 
 /* --- Includes {{{1 */
 #include <stdlib.h>
-#include <float.h>
+#include <unistd.h>
+#include <time.h>
 #include <math.h>
 
 #include "random.h"
 #include "debug.h"
 
-/* --- Local data {{{1 */
+/* --- Constants {{{1 */
 
-#ifdef WITH_GSL
-gsl_rng *gslr;
-#endif
+/* Philox4x32 multipliers and Weyl key increments (Salmon et al., 2011) */
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
 
-extern long seed;
+/* Number of Philox blocks generated side by side in the batch kernel */
+#define PHILOX_LANES 8
+
+/* Number of uniforms per chunk in the Gaussian batch */
+#define BATCH_CHUNK 512
 
 /* --- Local prototypes {{{1*/
 
-static void seedGaussian(unsigned seed);
-static double getGaussianBoxMullerRandom(double m, double s);
+static void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+static void nextBlock(RandomStream *rs);
+static void philox4x32Uniforms(uint32_t ctr[4], const uint32_t key[2], double *out, int nblocks);
+static void philox4x32UniformLanes(RandomStream **rs, int n_lanes, double *out, int nblocks);
 
 /* --- Implementation {{{1*/
 
-void initRandomGenerator(void) /*{{{2*/
+long getClockSeed(void) /*{{{2*/
+/*
+ * Returns a seed taken from the clock and process id, for simulations
+ * without a given seed
+ */
+{
+    return (long)time(NULL) ^ ((long)getpid() << 16);
+} /*}}}2*/
+
+void initRandomStream(RandomStream *rs, uint64_t seed, uint64_t stream_id) /*{{{2*/
+/*
+ * Initialize a random stream, where;
+ * seed      = the key of the generator
+ * stream_id = selects an independent stream (i.e. the upper half of the counter)
+ */
+{
+    rs->key[0] = (uint32_t)(seed);
+    rs->key[1] = (uint32_t)(seed >> 32);
+    rs->ctr[0] = 0;
+    rs->ctr[1] = 0;
+    rs->ctr[2] = (uint32_t)(stream_id);
+    rs->ctr[3] = (uint32_t)(stream_id >> 32);
+    rs->n_out = 0;
+    rs->has_gauss = 0;
+    rs->gauss = 0.0;
+} /*}}}2*/
+
+uint32_t getRandom32(RandomStream *rs) /*{{{2*/
+/*
+ * Returns the next uniformly distributed 32 bit value of the stream
+ */
+{
+    if (rs->n_out == 0) nextBlock(rs);
+    rs->n_out--;
+    return rs->out[rs->n_out];
+} /*}}}2*/
+
+double getUniformRandom(RandomStream *rs) /*{{{2*/
+/*
+ * Returns a uniformly distributed value in the open interval (0,1), using
+ * 53 random bits
+ */
+{
+    uint64_t hi = getRandom32(rs);
+    uint64_t lo = getRandom32(rs);
+    uint64_t x = ((hi << 32) | lo) >> 11;
+    return ((double)x + 0.5) * (1.0/9007199254740992.0);
+} /*}}}2*/
+
+int getRandomInt(RandomStream *rs, int n) /*{{{2*/
+/*
+ * Returns a uniformly distributed integer 0 <= i <= n
+ */
+{
+    return (int)(getUniformRandom(rs) * (n+1));
+} /*}}}2*/
+
+int getCoinToss(RandomStream *rs) /*{{{2*/
+/*
+ * Returns 0 or 1, each with a probability of 1/2
+ */
+{
+    return (int)(getRandom32(rs) >> 31);
+} /*}}}2*/
+
+double getGaussianRandom(RandomStream *rs, double stddev) /*{{{2*/
+/*
+ * Return a random Gaussian (normal) distributed value with a mean
+ * of 0.0 and a given standard deviation (Box-Muller transform, the
+ * second value of each pair is kept in the stream)
+ */
+{
+    double u1, u2, r;
+
+    if (rs->has_gauss) {
+        rs->has_gauss = 0;
+        return rs->gauss * stddev;
+    }
+
+    u1 = getUniformRandom(rs);
+    u2 = getUniformRandom(rs);
+
+    r = sqrt(-2.0 * log(u1));
+    rs->gauss = r * sin(2.0*M_PI * u2);
+    rs->has_gauss = 1;
+
+    return r * cos(2.0*M_PI * u2) * stddev;
+} /*}}}2*/
+
+void getUniformRandomBatch(RandomStream *rs, double *out, int n) /*{{{2*/
+/*
+ * Fill <out> with <n> uniformly distributed values in (0,1). The result is
+ * identical to <n> calls of getUniformRandom(), but whole Philox blocks are
+ * generated in a vectorized kernel
+ */
+{
+    int i = 0;
+    int nblocks;
+
+    /* Use up the words left in the current block first */
+    while (i < n && rs->n_out != 0) {
+        out[i++] = getUniformRandom(rs);
+    }
+
+    /* Two uniforms per block */
+    nblocks = (n - i) / 2;
+    if (nblocks > 0) {
+        philox4x32Uniforms(rs->ctr, rs->key, &out[i], nblocks);
+        i += 2*nblocks;
+    }
+
+    if (i < n) {
+        out[i] = getUniformRandom(rs);
+    }
+} /*}}}2*/
+
+void getUniformRandomLanes(RandomStream **rs, int n_lanes, double *out, int n) /*{{{2*/
+/*
+ * Fill <out> with <n> uniformly distributed values of each of <n_lanes>
+ * streams, where value k of stream rs[l] is out[k*n_lanes+l]. The result is
+ * identical to <n> calls of getUniformRandom() on each stream, but the
+ * Philox blocks of the streams (at most PHILOX_LANES) are generated side by
+ * side in a vectorized kernel
+ */
 {
-#ifdef WITH_GSL
-    /* Setup the GSL random generator */
-    const gsl_rng_type *T;
-    gsl_rng_env_setup();
-    T = gsl_rng_default;
-    gslr = gsl_rng_alloc(T);
-    if (seed != 0L) gsl_rng_set(gslr, seed);
-#else
-    if (seed > 0) {
-        seedGaussian(seed);
+    int aligned = (n_lanes <= PHILOX_LANES);
+    int k, l;
+
+    for (l = 0; l < n_lanes; l++) {
+        if (rs[l]->n_out != 0) aligned = 0;
     }
-    else if (seed == 0) {
-        time_t t;
-        seedGaussian((unsigned)time(&t));
+
+    if (!aligned) {
+        /* Streams in the middle of a block, draw them one by one */
+        for (k = 0; k < n; k++) {
+            for (l = 0; l < n_lanes; l++) {
+                out[k*n_lanes+l] = getUniformRandom(rs[l]);
+            }
+        }
+        return;
+    }
+
+    /* Two uniforms per block */
+    philox4x32UniformLanes(rs, n_lanes, out, n/2);
+
+    if (n % 2) {
+        for (l = 0; l < n_lanes; l++) {
+            out[(n-1)*n_lanes+l] = getUniformRandom(rs[l]);
+        }
     }
-#endif
 } /*}}}2*/
 
-double getGaussianRandom(double stddev) /*{{{2*/
+void getGaussianRandomBatch(RandomStream *rs, double *out, int n, double stddev) /*{{{2*/
 /*
- * Return a random Gaussian (normal) distributed value with a mean
- * of 0.0 and a given standard deviation
+ * Fill <out> with <n> Gaussian (normal) distributed values with a mean of 0.0
+ * and a given standard deviation. The result is identical to <n> calls of
+ * getGaussianRandom(), but the uniforms of a whole chunk are drawn at once
  */
 {
-#ifdef WITH_GSL
-    return gsl_ran_gaussian_ziggurat(gslr, stddev);
-#else
-    return getGaussianBoxMullerRandom(0.0, stddev);
-#endif
+    double u[BATCH_CHUNK];
+    int i = 0;
+
+    if (n > 0 && rs->has_gauss) {
+        rs->has_gauss = 0;
+        out[i++] = rs->gauss * stddev;
+    }
+
+    while (n - i >= 2) {
+        int npairs = (n - i) / 2;
+        int j;
+
+        if (npairs > BATCH_CHUNK/2) npairs = BATCH_CHUNK/2;
+        getUniformRandomBatch(rs, u, 2*npairs);
+
+        for (j = 0; j < npairs; j++) {
+            double r = sqrt(-2.0 * log(u[2*j])) * stddev;
+            out[i++] = r * cos(2.0*M_PI * u[2*j+1]);
+            out[i++] = r * sin(2.0*M_PI * u[2*j+1]);
+        }
+    }
+
+    if (i < n) {
+        out[i] = getGaussianRandom(rs, stddev);
+    }
 } /*}}}2*/
 
 /* --- Local functions {{{1 */
 
-static void seedGaussian(unsigned seed) { /*{{{2*/
-    printf("Seeding %d\n", seed);
-    srand(seed);
+static void nextBlock(RandomStream *rs) /*{{{2*/
+/*
+ * Generate the next 4 words of the stream and increment the (64 bit)
+ * position part of the counter
+ */
+{
+    philox4x32(rs->ctr, rs->key, rs->out);
+    rs->n_out = 4;
+    if (++rs->ctr[0] == 0) rs->ctr[1]++;
 } /*}}}2*/
 
-static double getGaussianBoxMullerRandom(double m, double s) /*{{{2*/
+__attribute__((target_clones("avx2","default")))
+static void philox4x32Uniforms(uint32_t ctr[4], const uint32_t key[2], double *out, int nblocks) /*{{{2*/
 /*
- * Box-Muller transform to generate random values from a standard normal distribution
+ * Generate <nblocks> consecutive Philox blocks from position ctr[0..1] and
+ * convert each into two uniforms (in the same word order as getUniformRandom).
+ * PHILOX_LANES blocks are computed side by side, so the compiler can keep them
+ * in vector registers; an AVX2 and a generic version are built and the
+ * matching one is chosen at runtime. The position in ctr is advanced
  */
 {
-    D("    getGaussianRandom(%lf,%lf)\n", m, s);
+    uint64_t pos = ((uint64_t)ctr[1] << 32) | ctr[0];
+    int b = 0;
+
+    while (b < nblocks) {
+        uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+        uint32_t k0 = key[0], k1 = key[1];
+        int nlanes = nblocks - b;
+        int r, l;
+
+        if (nlanes > PHILOX_LANES) nlanes = PHILOX_LANES;
 
-    static double z0;
-    static double z1;
-    static int generated = 0;
+        for (l = 0; l < PHILOX_LANES; l++) {
+            uint64_t p = pos + (uint64_t)l;
+            c0[l] = (uint32_t)p;
+            c1[l] = (uint32_t)(p >> 32);
+            c2[l] = ctr[2];
+            c3[l] = ctr[3];
+        }
 
-    if (generated) {
-        generated = 0;
-        return z1 * s + m;
+        for (r = 0; r < PHILOX_ROUNDS; r++) {
+            for (l = 0; l < PHILOX_LANES; l++) {
+                uint64_t p0 = (uint64_t)PHILOX_M0 * c0[l];
+                uint64_t p1 = (uint64_t)PHILOX_M1 * c2[l];
+                uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0;
+                uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1;
+                c1[l] = (uint32_t)p1;
+                c3[l] = (uint32_t)p0;
+                c0[l] = n0;
+                c2[l] = n2;
+            }
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+
+        for (l = 0; l < nlanes; l++) {
+            uint64_t x0 = (((uint64_t)c3[l] << 32) | c2[l]) >> 11;
+            uint64_t x1 = (((uint64_t)c1[l] << 32) | c0[l]) >> 11;
+            out[2*(b+l)]   = ((double)x0 + 0.5) * (1.0/9007199254740992.0);
+            out[2*(b+l)+1] = ((double)x1 + 0.5) * (1.0/9007199254740992.0);
+        }
+
+        pos += (uint64_t)nlanes;
+        b += nlanes;
     }
 
-    double u1, u2;
+    ctr[0] = (uint32_t)pos;
+    ctr[1] = (uint32_t)(pos >> 32);
+} /*}}}2*/
+
+static void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) /*{{{2*/
+/*
+ * The Philox4x32-10 bijection; 10 rounds of multiply/xor over the counter
+ * with a Weyl sequence over the key
+ */
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    int i;
 
-    do {
-        u1 = rand() * (1.0/RAND_MAX);
-        u2 = rand() * (1.0/RAND_MAX);
-    } while (u1 <= DBL_MIN);
+    for (i = 0; i < PHILOX_ROUNDS; i++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t hi0 = (uint32_t)(p0 >> 32), lo0 = (uint32_t)p0;
+        uint32_t hi1 = (uint32_t)(p1 >> 32), lo1 = (uint32_t)p1;
 
-    z0 = sqrt(-2.0 * log(u1)) * cos(2.0*M_PI * u2);
-    z1 = sqrt(-2.0 * log(u1)) * sin(2.0*M_PI * u2);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
 
-    generated = 1;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
 
-    return z0 * s + m;
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
 } /*}}}2*/
 
+__attribute__((target_clones("avx2","default")))
+static void philox4x32UniformLanes(RandomStream **rs, int n_lanes, double *out, int nblocks) /*{{{2*/
+/*
+ * Generate <nblocks> consecutive Philox blocks of each of <n_lanes> streams
+ * (each with its own key and counter) and convert each block into two
+ * uniforms, value k of stream l going to out[k*n_lanes+l]. The streams are
+ * computed side by side in PHILOX_LANES lanes (unused lanes repeat stream 0)
+ * like philox4x32Uniforms(). The position of every stream is advanced
+ */
+{
+    uint64_t pos[PHILOX_LANES];
+    uint32_t s2[PHILOX_LANES], s3[PHILOX_LANES];
+    uint32_t key0[PHILOX_LANES], key1[PHILOX_LANES];
+    int b, l;
+
+    for (l = 0; l < PHILOX_LANES; l++) {
+        const RandomStream *s = rs[(l < n_lanes) ? l : 0];
+        pos[l] = ((uint64_t)s->ctr[1] << 32) | s->ctr[0];
+        s2[l] = s->ctr[2];
+        s3[l] = s->ctr[3];
+        key0[l] = s->key[0];
+        key1[l] = s->key[1];
+    }
+
+    for (b = 0; b < nblocks; b++) {
+        uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+        uint32_t k0[PHILOX_LANES], k1[PHILOX_LANES];
+        int r;
+
+        for (l = 0; l < PHILOX_LANES; l++) {
+            uint64_t p = pos[l] + (uint64_t)b;
+            c0[l] = (uint32_t)p;
+            c1[l] = (uint32_t)(p >> 32);
+            c2[l] = s2[l];
+            c3[l] = s3[l];
+            k0[l] = key0[l];
+            k1[l] = key1[l];
+        }
 
+        for (r = 0; r < PHILOX_ROUNDS; r++) {
+            for (l = 0; l < PHILOX_LANES; l++) {
+                uint64_t p0 = (uint64_t)PHILOX_M0 * c0[l];
+                uint64_t p1 = (uint64_t)PHILOX_M1 * c2[l];
+                uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[l] ^ k0[l];
+                uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[l] ^ k1[l];
+                c1[l] = (uint32_t)p1;
+                c3[l] = (uint32_t)p0;
+                c0[l] = n0;
+                c2[l] = n2;
+                k0[l] += PHILOX_W0;
+                k1[l] += PHILOX_W1;
+            }
+        }
+
+        for (l = 0; l < n_lanes; l++) {
+            uint64_t x0 = (((uint64_t)c3[l] << 32) | c2[l]) >> 11;
+            uint64_t x1 = (((uint64_t)c1[l] << 32) | c0[l]) >> 11;
+            out[(2*b)*n_lanes+l]   = ((double)x0 + 0.5) * (1.0/9007199254740992.0);
+            out[(2*b+1)*n_lanes+l] = ((double)x1 + 0.5) * (1.0/9007199254740992.0);
+        }
+    }
+
+    for (l = 0; l < n_lanes; l++) {
+        uint64_t p = pos[l] + (uint64_t)nblocks;
+        rs[l]->ctr[0] = (uint32_t)p;
+        rs[l]->ctr[1] = (uint32_t)(p >> 32);
+    }
+} /*}}}2*/
@@ -1,6 +1,7 @@
 /*****************************************************************************
 *** Name      : random.h                                                   ***
-*** Purpose   : Implements Guassian distributed random with Box-Muller     ***
+*** Purpose   : Implements counter-based random streams (Philox4x32-10)    ***
+***             with Gaussian distributed random values                    ***
 *** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
 *** Copyright : 2013-2021                                                  ***
 ***                                                                        ***
@@ -24,15 +25,38 @@
 #ifndef _RANDOM_H
 #define _RANDOM_H
 
-#ifdef WITH_GSL
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
-#endif
+/* --- Includes {{{1 */
+
+#include <stdint.h>
+
+/* --- Data types {{{1 */
+
+/*
+ * A random stream is a Philox4x32-10 counter-based generator. The random
+ * values are a pure function of (key, counter), so every stream is fully
+ * described by this small state object; no global or shared state is
+ * involved and streams with a different key or stream id are independent.
+ */
+typedef struct {
+    uint32_t key[2];            /* Key (derived from the seed)              */
+    uint32_t ctr[4];            /* ctr[0..1] = position, ctr[2..3] = stream */
+    uint32_t out[4];            /* Output of the last generated block       */
+    int      n_out;             /* Number of unused words in out            */
+    int      has_gauss;         /* Second Box-Muller value available        */
+    double   gauss;             /* The second Box-Muller value              */
+} RandomStream;
 
 /* --- Interface {{{1 */
 
-void initRandomGenerator(void);
-double getGaussianRandom(double stddev);
+long getClockSeed(void);
+void initRandomStream(RandomStream *rs, uint64_t seed, uint64_t stream_id);
+uint32_t getRandom32(RandomStream *rs);
+double getUniformRandom(RandomStream *rs);
+int getRandomInt(RandomStream *rs, int n);
+int getCoinToss(RandomStream *rs);
+double getGaussianRandom(RandomStream *rs, double stddev);
+void getUniformRandomBatch(RandomStream *rs, double *out, int n);
+void getUniformRandomLanes(RandomStream **rs, int n_lanes, double *out, int n);
+void getGaussianRandomBatch(RandomStream *rs, double *out, int n, double stddev);
 
 #endif
-
@@ -23,45 +23,54 @@
 
 /* --- Includes {{{1 */
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "random.h"
 #include "score.h"
 #include "team.h"
+#include "dump.h"
 #include "debug.h"
 
 #define REVISED_ARCHERS_SKILL_LEVEL 1
 
 /* --- External globals {{{1*/
 
-extern double arrow_diameter;
-#ifdef WITH_GSL
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
-extern gsl_rng *gslr;
-#endif
+extern int pretty_print;
+
+/* --- Global data {{{1*/
+
+ArrowSampler arrow_sampler = ARROW_SAMPLER_ALIAS;
 
 /* --- Constants {{{1 */
 
-const double SCORE_GRANULARITY = 0.1;
 const double MIN_MEASURABLE = 1.0;
 
+/* Maximum number of arrows of which the positions are drawn at once */
+#define MAX_BATCH_ARROWS 128
+
 /* --- Local prototypes {{{1 */
 
-static double getArrowValueFromPosition(double d_from_center, const Face *face);
+static Score getArrowValueFromPosition(double d_from_center, const Face *face);
+static int getRingFromPosition(double d_from_center, const Face *face);
+static Score getArrowValueFromDistance2(double d2, const Face *face);
+static double getArrowPositionWithSampler(RandomStream *rs, ArrowSampler sampler, double lvl, double dist);
+static double chiSquare(const long *observed, const double *p, int n_outcomes, long n, int *dof);
 static double getArrowValueBySkillLevel(double lvl, const Face *face, double dist);
 static double computeF(double lvl, const Face *face, double dist, int i);
 static double computeW(double lvl, double dist);
+static double shootoffIntegral(double W_me, double W_opponent, double from);
 static double round_to_n_digits(double x, int n);
 
 /* --- Implementation {{{1 */
 
-Result scoreCompare(double left_score, double right_score) /*{{{2*/
+Result scoreCompare(Score left_score, Score right_score) /*{{{2*/
 /*
- * Compares two scores, returns DRAW if score is within SCORE_GRANULARITY,
- * else returns LEFT_WINS or RIGHT_WINS
+ * Compares two scores, returns DRAW if the scores are equal, else returns
+ * LEFT_WINS or RIGHT_WINS
  */
 {
-    if (fabs(left_score-right_score) < SCORE_GRANULARITY/2.0) return DRAW;
+    if (left_score == right_score) return DRAW;
     if (left_score > right_score) return LEFT_WINS;
     return RIGHT_WINS;
 } /*}}}2*/
@@ -89,8 +98,8 @@ Result teamShootoffCompare(const Team *left, double left_d[3], const Team *right
  * Routine returns DRAW if all undecided or LEFT_WINS_SHOOTOFF or RIGHT_WINS_SHOOTOFF
  */
 {
-    double left_score = 0.0;
-    double right_score = 0.0;
+    Score left_score = 0;
+    Score right_score = 0;
 
     left_score = getArrowValueFromPosition(left_d[0], face) +
                  getArrowValueFromPosition(left_d[1], face) +
@@ -171,8 +180,8 @@ Result mixedTeamShootoffCompare(const MixedTeam *left, double left_d[2], const M
  * Routine returns DRAW if all undecided or LEFT_WINS_SHOOTOFF or RIGHT_WINS_SHOOTOFF
  */
 {
-    double left_score = 0.0;
-    double right_score = 0.0;
+    Score left_score = 0;
+    Score right_score = 0;
 
     left_score = getArrowValueFromPosition(left_d[0], face) +
                  getArrowValueFromPosition(left_d[1], face);
@@ -226,67 +235,210 @@ Result mixedTeamShootoffCompare(const MixedTeam *left, double left_d[2], const M
     return DRAW;
 } /*}}}2*/
 
-double getScore(double lvl, const Face *face, double dist, int n_arrows) /*{{{2*/
+Score getScore(RandomStream *rs, double lvl, const Face *face, double dist, int n_arrows) /*{{{2*/
 /*
  * Returns a score based on the skill level of the archer for given format
+ * rs = random stream to draw from
  * lvl = Archers Skill Level
  * face = Target face shot on
  * dist = distance shot at in [m]
  * n_arrows = number of arrows shot
+ * The random positions of a whole end (or round, up to MAX_BATCH_ARROWS) are
+ * drawn at once
  */
 {
-    double score = 0.0;
+    double g[2*MAX_BATCH_ARROWS];
+    double W = computeW(lvl, dist);
+    double W2 = W*W;
+    Score score = 0;
     int i;
-    for (i = 0; i < n_arrows; i++) {
-        score += getArrowValue(lvl, face, dist);
+
+    while (n_arrows > 0) {
+        int n = (n_arrows < MAX_BATCH_ARROWS) ? n_arrows : MAX_BATCH_ARROWS;
+
+        if (arrow_sampler != ARROW_SAMPLER_GAUSSIAN2D) {
+            getUniformRandomBatch(rs, g, n);
+            for (i = 0; i < n; i++) {
+                score += getArrowValueFromDistance2(-2.0*W2*log(g[i]), face);
+            }
+        }
+        else {
+            getGaussianRandomBatch(rs, g, 2*n, W/dist);
+            for (i = 0; i < n; i++) {
+                double x = g[2*i]*dist;
+                double y = g[2*i+1]*dist;
+                score += getArrowValueFromDistance2(x*x+y*y, face);
+            }
+        }
+        n_arrows -= n;
     }
 #if 0
-    printf ("Return score %lf\n", score);
+    printf ("Return score %lf\n", SCORE_TO_DOUBLE(score));
 #endif
     return score;
 } /*}}}2*/
 
-double getArrowValue(double lvl, const Face *face, double dist) /*{{{2*/
+Score getArcherScore(RandomStream *rs, ScoreTable *table, double lvl, const Face *face, double dist, int n_arrows) /*{{{2*/
+/*
+ * Returns a score of an archer, drawn from the archers arrow value table
+ * when the alias sampler is selected (and a table is given) or else by
+ * simulating the arrow positions, where;
+ * rs = random stream to draw from
+ * table = the archers arrow value table for this face and distance (or NULL)
+ * lvl = Archers Skill Level
+ * face = Target face shot on
+ * dist = distance shot at in [m]
+ * n_arrows = number of arrows shot
+ */
+{
+    if (arrow_sampler == ARROW_SAMPLER_ALIAS && table != NULL) {
+        return getScoreFromTable(rs, table, n_arrows);
+    }
+    return getScore(rs, lvl, face, dist, n_arrows);
+} /*}}}2*/
+
+void getArcherScores(RandomStream *rs, ScoreTable *table, double lvl, const Face *face, double dist, int n_arrows, Score *scores, int n) /*{{{2*/
+/*
+ * Fills scores[0..n-1] with n scores of an archer, the same as n calls of
+ * getArcherScore() but batched, where;
+ * scores = the scores drawn
+ * n = number of scores
+ * (other arguments as getArcherScore())
+ */
+{
+    int i;
+
+    if (arrow_sampler == ARROW_SAMPLER_ALIAS && table != NULL) {
+        getScoresFromTable(rs, table, n_arrows, scores, n);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        scores[i] = getScore(rs, lvl, face, dist, n_arrows);
+    }
+} /*}}}2*/
+
+Score getArrowValue(RandomStream *rs, double lvl, const Face *face, double dist) /*{{{2*/
 /*
  * Returns a single arrow score based on the skill level of the archer for given format
  * where;
+ * rs = random stream to draw from
  * lvl = Archers Skill Level
  * face = Target face shot on
  * dist = distance shot at in [m]
  */
 {
-    double d_from_center = getArrowPosition(lvl, dist);
+    double d_from_center = getArrowPosition(rs, lvl, dist);
     return getArrowValueFromPosition(d_from_center, face);
 } /*}}}2*/
 
-double getArrowPosition(double lvl, double dist) /*{{{2*/
+double getArrowPosition(RandomStream *rs, double lvl, double dist) /*{{{2*/
 /*
  * Returns a single arrow random position (mm from center) based on
  * the skill level of the archer for a given distance
  * where;
+ * rs = random stream to draw from
  * lvl = Archers Skill Level
  * dist = distance shot at in [m]
  */
 {
-    double stddev, x, y, d_from_center;
-    double r1, r2;
+    return getArrowPositionWithSampler(rs, arrow_sampler, lvl, dist);
+} /*}}}2*/
 
-    D("\ngetRandomSingleArrowPosition()\n");
-    D("  distance -> %lf\n", dist);
-    stddev = computeW(lvl, dist)/dist;
-    D("  stddev -> %lf\n", stddev);
-    r1 = getGaussianRandom(stddev);
-    r2 = getGaussianRandom(stddev);
-    D("  r1 -> %lf , r2 -> %lf\n", r1, r2);
+int setArrowSampler(const char *name) /*{{{2*/
+/*
+ * Selects the arrow sampler by name ("alias", "rayleigh" or "gaussian2d")
+ * Returns 0 on success or -1 if the name is unknown
+ */
+{
+    if (strcmp(name, "rayleigh") == 0) {
+        arrow_sampler = ARROW_SAMPLER_RAYLEIGH;
+        return 0;
+    }
+    if (strcmp(name, "gaussian2d") == 0) {
+        arrow_sampler = ARROW_SAMPLER_GAUSSIAN2D;
+        return 0;
+    }
+    if (strcmp(name, "alias") == 0) {
+        arrow_sampler = ARROW_SAMPLER_ALIAS;
+        return 0;
+    }
+    return -1;
+} /*}}}2*/
 
-    x = r1*dist;
-    D("  x -> %lf\n", x);
-    y = r2*dist;
-    D("  y -> %lf\n", y);
-    d_from_center = sqrt(x*x+y*y);
-    D("  d_from_center -> %lf\n", d_from_center);
+const char *getArrowSamplerName(ArrowSampler sampler) /*{{{2*/
+{
+    switch (sampler) {
+        case ARROW_SAMPLER_GAUSSIAN2D: return "gaussian2d";
+        case ARROW_SAMPLER_RAYLEIGH:   return "rayleigh";
+        case ARROW_SAMPLER_ALIAS:      return "alias";
+    }
+    return "unknown";
+} /*}}}2*/
 
-    return d_from_center;
+void checkArrowSamplers(RandomStream *rs, double lvl, const Face *face, double dist, long n_arrows) /*{{{2*/
+/*
+ * Statistical equivalence check of the arrow samplers. Each sampler shoots
+ * n_arrows arrows and the ring counts are compared with the ring
+ * probabilities of the model (Pearson chi-square), where;
+ * rs = random stream to draw from
+ * lvl = Archers Skill Level
+ * face = face shot at
+ * dist = distance shot at in [m]
+ * n_arrows = number of arrows shot per sampler
+ * A sampler fails when the chi-square exceeds its 99.9% quantile
+ */
+{
+    /* Outcome index n_rings is a miss */
+    int n_outcomes = face->n_rings+1;
+    double *p = calloc(n_outcomes, sizeof(double));
+    long *observed = calloc(n_outcomes, sizeof(long));
+    int sampler;
+    long j;
+
+    if (p == NULL || observed == NULL) {
+        fatal("checkArrowSamplers() out of memory");
+    }
+
+    getRingProbabilities(lvl, face, dist, p);
+
+    for (sampler = ARROW_SAMPLER_GAUSSIAN2D; sampler <= ARROW_SAMPLER_ALIAS; sampler++) {
+        double chi2, k, z;
+        int dof;
+
+        memset(observed, 0, n_outcomes*sizeof(long));
+        if (sampler == ARROW_SAMPLER_ALIAS) {
+            ScoreTable *table = getScoreTable(lvl, face, dist);
+            for (j = 0; j < n_arrows; j++) {
+                observed[sampleAliasTable(table->alias, getUniformRandom(rs))]++;
+            }
+        }
+        else {
+            for (j = 0; j < n_arrows; j++) {
+                int ring = getRingFromPosition(getArrowPositionWithSampler(rs, sampler, lvl, dist), face);
+                observed[(ring < 0) ? face->n_rings : ring]++;
+            }
+        }
+        chi2 = chiSquare(observed, p, n_outcomes, n_arrows, &dof);
+
+        /* Wilson-Hilferty transform of the chi-square to a standard normal */
+        z = 0.0;
+        if (dof > 0) {
+            k = dof;
+            z = (pow(chi2/k, 1.0/3.0) - (1.0 - 2.0/(9.0*k))) / sqrt(2.0/(9.0*k));
+        }
+
+        if (pretty_print) {
+            outp("| %6.2lf | %-10s | %10ld | %10.3lf | %3d | %s |\n",
+                 lvl, getArrowSamplerName(sampler), n_arrows, chi2, dof, (z > 3.09) ? "FAIL" : " ok ");
+        }
+        else {
+            outp("%lf;\"%s\";%ld;%lf;%d;\"%s\"\n",
+                 lvl, getArrowSamplerName(sampler), n_arrows, chi2, dof, (z > 3.09) ? "FAIL" : "ok");
+        }
+    }
+
+    free(p);
+    free(observed);
 } /*}}}2*/
 
 double getScoreBySkillLevel(double lvl, const Face *face, double dist, int n_arrows) /*{{{2*/
@@ -304,9 +456,106 @@ double getScoreBySkillLevel(double lvl, const Face *face, double dist, int n_arr
     return round_to_n_digits(score, face->significant_decimals);
 } /*}}}2*/
 
+void getRingProbabilities(double lvl, const Face *face, double dist, double *p) /*{{{2*/
+/*
+ * Fills p[0..n_rings] with the probability to hit ring i (i = 0 is the outer
+ * ring) and, in p[n_rings], the probability to miss the face, where;
+ * lvl = Archers Skill Level
+ * face = face shot at
+ * dist = distance shot at in [m]
+ */
+{
+    int i;
+
+    for (i = 0; i < face->n_rings; i++) {
+        p[i] = computeF(lvl, face, dist, i);
+        if (i < face->n_rings-1) {
+            p[i] -= computeF(lvl, face, dist, i+1);
+        }
+    }
+    p[face->n_rings] = 1.0 - computeF(lvl, face, dist, 0);
+} /*}}}2*/
+
+double getShootoffProbability(double left_lvl, double right_lvl, const Face *face, double dist, double *p_second_so) /*{{{2*/
+/*
+ * Returns the probability that the left archer wins a single arrow shoot-off
+ * as decided by shootoffCompare() (repeated while undecided), where;
+ * left_lvl = Archers Skill Level of the left archer
+ * right_lvl = Archers Skill Level of the right archer
+ * face = face shot at, if it has a ring_for_2nd_so the first attempt is also
+ *        repeated when both arrows are within that ring
+ * dist = distance shot at in [m]
+ * p_second_so = if not NULL, set to the probability that the first attempt
+ *               is repeated because of the second shoot-off rule
+ * The distances from center are Rayleigh distributed, so left wins an attempt
+ * with probability a = P(d_left < d_right - MIN_MEASURABLE), right with b
+ * (and vice versa). Once only undecided attempts are repeated, left wins with
+ * a/(a+b). On the first attempt the wins with both arrows inside the 2nd
+ * shoot-off ring are excluded (a1, b1)
+ */
+{
+    double W_left = computeW(left_lvl, dist);
+    double W_right = computeW(right_lvl, dist);
+    double a = shootoffIntegral(W_left, W_right, MIN_MEASURABLE);
+    double b = shootoffIntegral(W_right, W_left, MIN_MEASURABLE);
+    double a1 = a;
+    double b1 = b;
+
+    if (p_second_so != NULL) *p_second_so = 0.0;
+
+    if (face->ring_for_2nd_so >= 0) {
+        double r = face->radius[face->ring_for_2nd_so];
+        double f_left = r/W_left;
+        double f_right = r/W_right;
+
+        /* A win needs the winner closer, so both inside iff the loser is inside */
+        if (r > MIN_MEASURABLE) {
+            a1 = shootoffIntegral(W_left, W_right, r);
+            b1 = shootoffIntegral(W_right, W_left, r);
+        }
+        if (p_second_so != NULL) {
+            *p_second_so = (1.0 - exp(-0.5*f_left*f_left)) * (1.0 - exp(-0.5*f_right*f_right));
+        }
+    }
+
+    return a1 + (1.0 - a1 - b1) * a/(a+b);
+} /*}}}2*/
+
 /* --- Internals {{{1 */
 
-static double getArrowValueFromPosition(double d_from_center, const Face *face) /*{{{2*/
+static double getArrowPositionWithSampler(RandomStream *rs, ArrowSampler sampler, double lvl, double dist) /*{{{2*/
+/*
+ * Returns a single arrow random position (mm from center) drawn with the
+ * given sampler
+ */
+{
+    double stddev, x, y, d_from_center;
+    double r1, r2;
+
+    if (sampler != ARROW_SAMPLER_GAUSSIAN2D) {
+        /* Inverse CDF of the Rayleigh distribution with scale W */
+        return computeW(lvl, dist) * sqrt(-2.0*log(getUniformRandom(rs)));
+    }
+
+    D("\ngetRandomSingleArrowPosition()\n");
+    D("  distance -> %lf\n", dist);
+    stddev = computeW(lvl, dist)/dist;
+    D("  stddev -> %lf\n", stddev);
+    r1 = getGaussianRandom(rs, stddev);
+    r2 = getGaussianRandom(rs, stddev);
+    D("  r1 -> %lf , r2 -> %lf\n", r1, r2);
+
+    x = r1*dist;
+    D("  x -> %lf\n", x);
+    y = r2*dist;
+    D("  y -> %lf\n", y);
+    d_from_center = sqrt(x*x+y*y);
+    D("  d_from_center -> %lf\n", d_from_center);
+
+    return d_from_center;
+} /*}}}2*/
+
+static Score getArrowValueFromPosition(double d_from_center, const Face *face) /*{{{2*/
 /*
  * Returns a single arrow score based on distance from center of face (in mm)
  * and a given target face
@@ -315,15 +564,64 @@ static double getArrowValueFromPosition(double d_from_center, const Face *face)
  * face = Target face shot on
  */
 {
-    double touching_radius = d_from_center - arrow_diameter/2.0;
-    int i = face->n_rings;
-    while (i > 0) {
-        i--;
-        if ( touching_radius <= face->radius[i]) {
-            return face->value[i];
+    int i = getRingFromPosition(d_from_center, face);
+    return (i < 0) ? 0 : face->points[i];
+} /*}}}2*/
+
+static int getRingFromPosition(double d_from_center, const Face *face) /*{{{2*/
+/*
+ * Returns the index of the ring hit based on distance from center of face
+ * (in mm), or -1 if the arrow misses the face
+ */
+{
+    return getRingFromDistance2(face, d_from_center*d_from_center);
+} /*}}}2*/
+
+static Score getArrowValueFromDistance2(double d2, const Face *face) /*{{{2*/
+/*
+ * Returns a single arrow score based on the squared distance from center of
+ * face (in mm^2), so the caller can skip the sqrt
+ */
+{
+    int i;
+
+    if (face->kernel != NULL) {
+        return face->kernel(face, d2);
+    }
+    i = getRingFromDistance2(face, d2);
+    return (i < 0) ? 0 : face->points[i];
+} /*}}}2*/
+
+static double chiSquare(const long *observed, const double *p, int n_outcomes, long n, int *dof) /*{{{2*/
+/*
+ * Returns Pearson's chi-square of observed counts against probabilities p
+ * for n samples, and the degrees of freedom in dof. Outcomes with an expected
+ * count below 5 are pooled into a single bin
+ */
+{
+    double chi2 = 0.0;
+    double pooled_e = 0.0;
+    long pooled_o = 0;
+    int n_bins = 0;
+    int i;
+
+    for (i = 0; i < n_outcomes; i++) {
+        double e = p[i]*n;
+        if (e < 5.0) {
+            pooled_e += e;
+            pooled_o += observed[i];
+            continue;
         }
+        chi2 += (observed[i]-e)*(observed[i]-e)/e;
+        n_bins++;
     }
-    return 0.0;
+    if (pooled_e > 0.0) {
+        chi2 += (pooled_o-pooled_e)*(pooled_o-pooled_e)/pooled_e;
+        n_bins++;
+    }
+
+    *dof = n_bins-1;
+    return chi2;
 } /*}}}2*/
 
 static double getArrowValueBySkillLevel(double lvl, const Face *face, double dist) /*{{{2*/
@@ -362,7 +660,7 @@ static double computeF(double lvl, const Face *face, double dist, int i) /*{{{2*
  */
 {
     double W = computeW(lvl, dist);
-    double f = (face->radius[i] + arrow_diameter/2.0)/W;
+    double f = face->threshold[i]/W;
 
     return 1.0 - exp( -0.5*f*f );
 } /*}}}2*/
@@ -394,6 +692,34 @@ static double computeW(double lvl, double dist) /*{{{2*/
 #endif
 } /*}}}2*/
 
+static double shootoffIntegral(double W_me, double W_opponent, double from) /*{{{2*/
+/*
+ * Returns the probability that my arrow is at least MIN_MEASURABLE closer to
+ * center than my opponents arrow and my opponents arrow is beyond from (mm),
+ * where W_me and W_opponent are the Rayleigh parameters of both archers. This
+ * is the integral of f_opponent(r) * F_me(r - MIN_MEASURABLE) for r > from,
+ * evaluated with Simpson's rule (the integrand is smooth and vanishes beyond
+ * a dozen W_opponent)
+ */
+{
+    const int n = 256; /* Even number of intervals */
+    double to = from + 12.0*W_opponent;
+    double h = (to-from)/n;
+    double sum = 0.0;
+    int i;
+
+    for (i = 0; i <= n; i++) {
+        double r = from + i*h;
+        double x = r/W_opponent;
+        double y = (r-MIN_MEASURABLE)/W_me;
+        double f = (r/(W_opponent*W_opponent)) * exp(-0.5*x*x) * (1.0 - exp(-0.5*y*y));
+        double w = (i == 0 || i == n) ? 1.0 : ((i % 2) ? 4.0 : 2.0);
+        sum += w*f;
+    }
+
+    return sum*h/3.0;
+} /*}}}2*/
+
 static double round_to_n_digits(double x, int n) /*{{{2*/
 {
     double scale = pow(10.0, n);
@@ -26,10 +26,12 @@
 
 /* --- Includes {{{1 */
 
+#include "random.h"
 #include "archer.h"
 #include "team.h"
 #include "mixedteam.h"
 #include "format.h"
+#include "scoretable.h"
 
 /* --- Constants {{{1 */
 
@@ -41,14 +43,41 @@ typedef enum {
     RIGHT_WINS          =-2
 } Result;
 
+/*
+ * How the random position of an arrow is drawn;
+ * GAUSSIAN2D = independent Gaussian x and y offsets, position is sqrt(x*x+y*y)
+ * RAYLEIGH   = the distance from center is drawn directly. For a circular
+ *              bivariate normal this is Rayleigh distributed and needs only
+ *              one uniform, one log and one sqrt per arrow
+ * ALIAS      = the arrow value is drawn from the archers precomputed ring
+ *              distribution (alias table); one uniform and one lookup per
+ *              arrow. Positions (shoot-offs) are drawn as with RAYLEIGH
+ */
+typedef enum {
+    ARROW_SAMPLER_GAUSSIAN2D = 0,
+    ARROW_SAMPLER_RAYLEIGH   = 1,
+    ARROW_SAMPLER_ALIAS      = 2
+} ArrowSampler;
+
+/* --- Interface {{{1 */
+
+extern ArrowSampler arrow_sampler;
+
 /* --- Prototypes {{{1 */
-Result scoreCompare(double left_score, double right_score);
+Result scoreCompare(Score left_score, Score right_score);
 Result shootoffCompare(double left_distance_from_center, double right_distance_from_center);
 Result teamShootoffCompare(const Team *left, double left_d[3], const Team *right, double right_d[3], const Face *face);
 Result mixedTeamShootoffCompare(const MixedTeam *left, double left_d[2], const MixedTeam *right, double right_d[2], const Face *face);
-double getScore(double lvl, const Face *face, double dist, int n_arrows);
-double getArrowValue(double lvl, const Face *face, double dist);
-double getArrowPosition(double lvl, double dist);
+Score getScore(RandomStream *rs, double lvl, const Face *face, double dist, int n_arrows);
+Score getArcherScore(RandomStream *rs, ScoreTable *table, double lvl, const Face *face, double dist, int n_arrows);
+void getArcherScores(RandomStream *rs, ScoreTable *table, double lvl, const Face *face, double dist, int n_arrows, Score *scores, int n);
+Score getArrowValue(RandomStream *rs, double lvl, const Face *face, double dist);
+double getArrowPosition(RandomStream *rs, double lvl, double dist);
 double getScoreBySkillLevel(double lvl, const Face *face, double dist, int n_arrows);
+void getRingProbabilities(double lvl, const Face *face, double dist, double *p);
+double getShootoffProbability(double left_lvl, double right_lvl, const Face *face, double dist, double *p_second_so);
+int setArrowSampler(const char *name);
+const char *getArrowSamplerName(ArrowSampler sampler);
+void checkArrowSamplers(RandomStream *rs, double lvl, const Face *face, double dist, long n_arrows);
 
 #endif
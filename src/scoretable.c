@@ -0,0 +1,310 @@
+/*****************************************************************************
+*** Name      : scoretable.c                                               ***
+*** Purpose   : Cache of precomputed arrow value tables per skill level,   ***
+***             target face and distance                                   ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+/* --- Includes {{{1 */
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "scoretable.h"
+#include "score.h"
+#include "dump.h"
+
+/* --- Local data {{{1 */
+
+/*
+ * All tables built so far. Tables are built without holding the lock (so
+ * threads build different tables at the same time) and added under lock
+ */
+static ScoreTable *tables = NULL;
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* --- Local prototypes {{{1 */
+
+static ScoreTable *createScoreTable(double lvl, const Face *face, double dist);
+static ScoreTable *findScoreTable(double lvl, const Face *face, double dist);
+static void freeScoreTable(ScoreTable *table);
+static EndDistribution *createEndDistribution(const ScoreTable *table, int n_arrows);
+static void freeEndDistribution(EndDistribution *end);
+
+/* --- Implementation {{{1 */
+
+ScoreTable *getScoreTable(double lvl, const Face *face, double dist) /*{{{2*/
+/*
+ * Returns the (cached) arrow value table for an archer, where;
+ * lvl = Archers Skill Level
+ * face = face shot at
+ * dist = distance shot at in [m]
+ * The table is built on first use and kept for the rest of the run, tables
+ * may be requested from several threads
+ */
+{
+    ScoreTable *table;
+    ScoreTable *found;
+
+    pthread_mutex_lock(&tables_lock);
+    table = findScoreTable(lvl, face, dist);
+    pthread_mutex_unlock(&tables_lock);
+    if (table != NULL) {
+        return table;
+    }
+
+    table = createScoreTable(lvl, face, dist);
+
+    /* Another thread may have built the same table meanwhile */
+    pthread_mutex_lock(&tables_lock);
+    found = findScoreTable(lvl, face, dist);
+    if (found == NULL) {
+        table->next = tables;
+        tables = table;
+    }
+    pthread_mutex_unlock(&tables_lock);
+
+    if (found != NULL) {
+        freeScoreTable(table);
+        return found;
+    }
+    return table;
+} /*}}}2*/
+
+Score getScoreFromTable(RandomStream *rs, ScoreTable *table, int n_arrows) /*{{{2*/
+/*
+ * Returns a score of n_arrows arrows drawn from the end total distributions
+ * of an arrow value table, a single uniform per end of (at most)
+ * MAX_END_ARROWS arrows, where;
+ * rs = random stream to draw from
+ * table = arrow value table of the archer
+ * n_arrows = number of arrows shot
+ */
+{
+    Score score = 0;
+
+    while (n_arrows > 0) {
+        int n = (n_arrows < MAX_END_ARROWS) ? n_arrows : MAX_END_ARROWS;
+        EndDistribution *end = getEndDistribution(table, n);
+
+        score += end->unit * sampleAliasTable(end->alias, getUniformRandom(rs));
+        n_arrows -= n;
+    }
+
+    return score;
+} /*}}}2*/
+
+void getScoresFromTable(RandomStream *rs, ScoreTable *table, int n_arrows, Score *scores, int n) /*{{{2*/
+/*
+ * Fills scores[0..n-1] with n scores of n_arrows arrows, drawn as n calls of
+ * getScoreFromTable() would (same draws in the same order), where;
+ * rs = random stream to draw from
+ * table = arrow value table of the archer
+ * n_arrows = number of arrows shot per score
+ * scores = the scores drawn
+ * n = number of scores
+ * The end distributions are looked up once for the batch
+ */
+{
+    const int n_full = n_arrows / MAX_END_ARROWS;
+    const int rest = n_arrows % MAX_END_ARROWS;
+    const EndDistribution *full = (n_full > 0) ? getEndDistribution(table, MAX_END_ARROWS) : NULL;
+    const EndDistribution *last = (rest > 0) ? getEndDistribution(table, rest) : NULL;
+    int i, k;
+
+    for (i = 0; i < n; i++) {
+        Score score = 0;
+
+        for (k = 0; k < n_full; k++) {
+            score += full->unit * sampleAliasTable(full->alias, getUniformRandom(rs));
+        }
+        if (last != NULL) {
+            score += last->unit * sampleAliasTable(last->alias, getUniformRandom(rs));
+        }
+        scores[i] = score;
+    }
+} /*}}}2*/
+
+EndDistribution *getEndDistribution(ScoreTable *table, int n_arrows) /*{{{2*/
+/*
+ * Returns the (cached) end total distribution of n_arrows arrows
+ * (1..MAX_END_ARROWS) for an arrow value table. Distributions are
+ * published with an atomic exchange, so they are read without locking
+ */
+{
+    EndDistribution *end = __atomic_load_n(&table->end[n_arrows], __ATOMIC_ACQUIRE);
+    EndDistribution *expected = NULL;
+
+    if (end == NULL) {
+        end = createEndDistribution(table, n_arrows);
+        if (!__atomic_compare_exchange_n(&table->end[n_arrows], &expected, end, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            /* Another thread built it first */
+            freeEndDistribution(end);
+            end = expected;
+        }
+    }
+    return end;
+} /*}}}2*/
+
+/* --- Internals {{{1 */
+
+static ScoreTable *findScoreTable(double lvl, const Face *face, double dist) /*{{{2*/
+/*
+ * Returns the table of the cache with the given key (or NULL), call with
+ * tables_lock held
+ */
+{
+    ScoreTable *table;
+
+    for (table = tables; table != NULL; table = table->next) {
+        if (table->lvl == lvl &&
+            table->face == face &&
+            table->dist == dist &&
+            table->arrow_diameter == face->arrow_diameter) {
+            return table;
+        }
+    }
+    return NULL;
+} /*}}}2*/
+
+static void freeScoreTable(ScoreTable *table) /*{{{2*/
+/*
+ * Releases a table that was not added to the cache
+ */
+{
+    int i;
+
+    for (i = 0; i <= MAX_END_ARROWS; i++) {
+        if (table->end[i] != NULL) {
+            freeEndDistribution(table->end[i]);
+        }
+    }
+    freeAliasTable(table->alias);
+    free(table->points);
+    free(table);
+} /*}}}2*/
+
+static ScoreTable *createScoreTable(double lvl, const Face *face, double dist) /*{{{2*/
+{
+    ScoreTable *table = malloc(sizeof(ScoreTable));
+    double *p;
+    int i;
+
+    if (table == NULL) {
+        fatal("createScoreTable() out of memory");
+    }
+    table->lvl = lvl;
+    table->face = face;
+    table->dist = dist;
+    table->arrow_diameter = face->arrow_diameter;
+    table->n = face->n_rings+1;
+    table->points = malloc(table->n*sizeof(Score));
+    p = malloc(table->n*sizeof(double));
+    if (table->points == NULL || p == NULL) {
+        fatal("createScoreTable() out of memory");
+    }
+
+    getRingProbabilities(lvl, face, dist, p);
+    for (i = 0; i < face->n_rings; i++) {
+        table->points[i] = face->points[i];
+    }
+    table->points[face->n_rings] = 0;
+
+    table->alias = createAliasTable(p, table->n);
+    for (i = 0; i <= MAX_END_ARROWS; i++) {
+        table->end[i] = NULL;
+    }
+    table->next = NULL;
+
+    free(p);
+
+    return table;
+} /*}}}2*/
+
+static EndDistribution *createEndDistribution(const ScoreTable *table, int n_arrows) /*{{{2*/
+/*
+ * Builds the end total distribution by convolving the single arrow
+ * distribution n_arrows times with itself
+ */
+{
+    EndDistribution *end = malloc(sizeof(EndDistribution));
+    const Score unit = (table->face->significant_decimals > 0) ? 1 : SCORE_SCALE;
+    int *units = malloc(table->n*sizeof(int));
+    double *p = malloc(table->n*sizeof(double));
+    double *cur, *next;
+    int max_units = 0;
+    int len, i, j, k;
+
+    if (end == NULL || units == NULL || p == NULL) {
+        fatal("createEndDistribution() out of memory");
+    }
+
+    getRingProbabilities(table->lvl, table->face, table->dist, p);
+    for (i = 0; i < table->n; i++) {
+        units[i] = table->points[i]/unit;
+        if (units[i] > max_units) max_units = units[i];
+    }
+
+    len = n_arrows*max_units+1;
+    cur = calloc(len, sizeof(double));
+    next = calloc(len, sizeof(double));
+    if (cur == NULL || next == NULL) {
+        fatal("createEndDistribution() out of memory");
+    }
+
+    /* Zero arrows shot is a total of 0 with certainty */
+    cur[0] = 1.0;
+    for (k = 1; k <= n_arrows; k++) {
+        int top = (k-1)*max_units; /* Highest reachable total so far */
+        double *tmp;
+
+        for (j = 0; j <= k*max_units; j++) {
+            next[j] = 0.0;
+        }
+        for (j = 0; j <= top; j++) {
+            if (cur[j] == 0.0) continue;
+            for (i = 0; i < table->n; i++) {
+                next[j+units[i]] += cur[j]*p[i];
+            }
+        }
+        tmp = cur;
+        cur = next;
+        next = tmp;
+    }
+
+    end->n_arrows = n_arrows;
+    end->unit = unit;
+    end->n = len;
+    end->p = cur;
+    end->alias = createAliasTable(cur, len);
+
+    free(next);
+    free(units);
+    free(p);
+
+    return end;
+} /*}}}2*/
+
+static void freeEndDistribution(EndDistribution *end) /*{{{2*/
+{
+    freeAliasTable(end->alias);
+    free(end->p);
+    free(end);
+} /*}}}2*/
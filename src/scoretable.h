@@ -0,0 +1,113 @@
+/*****************************************************************************
+*** Name      : scoretable.h                                               ***
+*** Purpose   : Cache of precomputed arrow value tables per skill level,   ***
+***             target face and distance                                   ***
+*** Author    : Marcel van Apeldoorn <mvapldrn@gmail.com>                  ***
+*** Copyright : 2013-2021                                                  ***
+***                                                                        ***
+*** This file is part of ArcheryCompetitionSimulation.                     ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is free software: you can redistribute it ***
+*** and/or modify it under the terms of the GNU General Public License as  ***
+*** published by the Free Software Foundation, either version 3 of the     ***
+*** License, or (at your option) any later version.                        ***
+***                                                                        ***
+*** ArcheryCompetitionSimulation is distributed in the hope that it will   ***
+*** be useful, but WITHOUT ANY WARRANTY; without even the implied warranty ***
+*** of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the       ***
+*** GNU General Public License for more details.                           ***
+***                                                                        ***
+*** You should have received a copy of the GNU General Public License      ***
+*** along with ArcheryCompetitionSimulation.  If not,                      ***
+*** see <https://www.gnu.org/licenses/>.                                   ***
+*****************************************************************************/
+
+#ifndef _SCORETABLE_H
+#define _SCORETABLE_H
+
+/* --- Includes {{{1 */
+
+#include "face.h"
+#include "alias.h"
+#include "random.h"
+
+/* --- Constants {{{1 */
+
+/*
+ * Longest end of which the total score distribution is tabulated. Longer
+ * rounds are drawn as a sum of ends of this length (plus a remainder)
+ */
+#define MAX_END_ARROWS 12
+
+/* --- Data types {{{1 */
+
+/*
+ * The distribution of the total score of an end of n_arrows arrows. Totals
+ * are counted in units of the smallest score step of the face, outcome k of
+ * the alias table is a total of k units
+ */
+typedef struct {
+    /*
+     * Number of arrows in the end
+     */
+    int         n_arrows;
+    /*
+     * Points (Score) of a single unit (SCORE_SCALE, or 1 for decimal
+     * scoring faces)
+     */
+    Score       unit;
+    /*
+     * Number of totals (0..n-1 units) and the probability of each total
+     */
+    int         n;
+    double     *p;
+    /*
+     * Alias table over the totals 0..alias->n-1 (in units)
+     */
+    AliasTable *alias;
+} EndDistribution;
+
+/*
+ * The single arrow value distribution of an archer of a given skill level
+ * shooting at a given face and distance. Outcome i < n_rings is a hit in
+ * ring i, outcome n_rings is a miss
+ */
+typedef struct ScoreTable {
+    /*
+     * Key of the table; skill level, face, distance and arrow diameter
+     */
+    double             lvl;
+    const Face        *face;
+    double             dist;
+    double             arrow_diameter;
+    /*
+     * Number of outcomes (n_rings + 1)
+     */
+    int                n;
+    /*
+     * Points (Score) of each outcome
+     */
+    Score             *points;
+    /*
+     * Alias table over the outcomes
+     */
+    AliasTable        *alias;
+    /*
+     * End total distributions, indexed by the number of arrows in the end
+     * (built on first use)
+     */
+    EndDistribution   *end[MAX_END_ARROWS+1];
+    /*
+     * Next table in the cache
+     */
+    struct ScoreTable *next;
+} ScoreTable;
+
+/* --- Interface {{{1 */
+
+ScoreTable *getScoreTable(double lvl, const Face *face, double dist);
+Score getScoreFromTable(RandomStream *rs, ScoreTable *table, int n_arrows);
+void getScoresFromTable(RandomStream *rs, ScoreTable *table, int n_arrows, Score *scores, int n);
+EndDistribution *getEndDistribution(ScoreTable *table, int n_arrows);
+
+#endif
@@ -23,12 +23,17 @@
 
 /* --- Includes {{{1 */
 #include <math.h>
+#include <stdlib.h>
 
 #include "dump.h"
 #include "archer.h"
 #include "score.h"
 #include "format.h"
 #include "qualification.h"
+#include "random.h"
+#include "context.h"
+#include "pool.h"
+#include "progress.h"
 
 /* --- Global data {{{1*/
 
@@ -37,70 +42,174 @@ extern double start_asl;
 extern double end_asl;
 extern double step_asl;
 
+/* --- Local data types {{{1*/
+
+/* Scores of a skill level are drawn in batches of ASL_BATCH */
+#define ASL_BATCH 1024
+
+/*
+ * The skill levels of the sweep and per level the mean and standard
+ * deviation of the simulated score
+ */
+typedef struct {
+    SimulationContext **worker;
+    double             *asl;
+    double             *mean;
+    double             *stddev;
+} ASLSweep;
+
 /* --- Local prototypes {{{1*/
 
+static void doASLLevel(void *arg, int worker, int task);
+
 /* --- Implementation {{{1*/
 
-void ASLSimulation(void) /*{{{2*/
+void ASLSimulation(SimulationContext *ctx) /*{{{2*/
 /*
  * Computes the score and some statistics on the score, that an archer would shoot based on its skill level
  * and loops over skill levels
  * start_asl : starting skill level
  * end_asl   : ending skill level (incl. if possible with step)
  * step_asl  : with this step (in skill level)
- * format    : format of the round
+ * ctx       : simulation context (format of the round)
  * nsims     : number of simulations (to base stats on)
+ * The levels are independent and simulated on the thread pool, each from its
+ * own stream of the seed
  */
 {
+    ASLSweep sweep;
     double asl;
-    int n, j;
-    double mean;
-    double m2;
-    double delta;
-    double x;
+    int n = 0;
+    int n_workers;
+    int i, w;
 
-    const Face *face = getFace(q_format.facetype);
-    const double dist = q_format.distance;
-    const int narrows = q_format.narrows;
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    const double dist = ctx->q_format.distance;
+    const int narrows = ctx->q_format.narrows;
 
     if (pretty_print) {
-        outp("Format               : %s\n", getFormatName(&q_format));
+        outp("Format               : %s\n", getFormatName(&ctx->q_format));
         outp("Number of simulations: %d\n", q_nruns);
         outp("| Archers Skill Level |  Score   | Stddev |\n");
         outp("+---------------------+----------+--------|\n");
         /*    |     XXX.XX          |  XXXX.X  | XX.XXX | */
     }
+    else if (output_format == OUTPUT_BINARY) {
+        static const TableColumn column[4] = {
+            { "asl",          COLUMN_DOUBLE },
+            { "asl_score",    COLUMN_DOUBLE },
+            { "score_mean",   COLUMN_DOUBLE },
+            { "score_stddev", COLUMN_DOUBLE },
+        };
+        beginTable("asl_scores", 4, column);
+    }
     else {
-        outp("\"%s\";%d\n", getFormatName(&q_format), q_nruns);
+        outp("\"%s\";%d\n", getFormatName(&ctx->q_format), q_nruns);
         outp("\"asl\";\"asl-score\";\"mean-score\";\"stddev-score\"\n");
     }
+
     for (asl = start_asl; asl <= end_asl; asl += step_asl) {
-        n = 0;
-        mean = 0.0;
-        m2 = 0.0;
-        for (j = 0; j < q_nruns; j++) {
-            x = getScore(asl, face, dist, narrows);
-            /* Compute mean and variance */
-            n++;
-            delta = x - mean;
-            mean += delta/n;
-            m2 += delta*(x-mean);
+        n++;
+    }
+    sweep.asl = malloc(n*sizeof(double));
+    sweep.mean = malloc(n*sizeof(double));
+    sweep.stddev = malloc(n*sizeof(double));
+    if (sweep.asl == NULL || sweep.mean == NULL || sweep.stddev == NULL) {
+        fatal("ASLSimulation() out of memory");
+    }
+    for (i = 0, asl = start_asl; i < n; i++, asl += step_asl) {
+        sweep.asl[i] = asl;
+    }
+
+    n_workers = getPoolWorkers(n);
+    sweep.worker = malloc(n_workers*sizeof(SimulationContext*));
+    if (sweep.worker == NULL) {
+        fatal("ASLSimulation() out of memory");
+    }
+    for (w = 0; w < n_workers; w++) {
+        sweep.worker[w] = malloc(sizeof(SimulationContext));
+        if (sweep.worker[w] == NULL) {
+            fatal("ASLSimulation() out of memory");
         }
+        forkSimulationContext(sweep.worker[w], ctx, 0);
+    }
+
+    startProgress("scores", (long)n*q_nruns, NULL, NULL);
+    runPoolTasks(n_workers, n, doASLLevel, &sweep);
+    stopProgress();
+
+    for (i = 0; i < n; i++) {
         /* Dump mean and variance */
-        double stddev = sqrt(m2/(n-1.0));
         if (pretty_print) {
-            outp("|     %6.2lf          |  %6.1lf  | %6.3lf |\n", asl, mean, stddev);
+            outp("|     %6.2lf          |  %6.1lf  | %6.3lf |\n", sweep.asl[i], sweep.mean[i], sweep.stddev[i]);
+        }
+        else if (output_format == OUTPUT_BINARY) {
+            tableDouble(sweep.asl[i]);
+            tableDouble(getScoreBySkillLevel(sweep.asl[i], face, dist, narrows));
+            tableDouble(sweep.mean[i]);
+            tableDouble(sweep.stddev[i]);
         }
         else {
-            outp("%lf;%lf;%lf;%lf;%lf\n",
-                    asl,
-                    getScoreBySkillLevel(asl, face, dist, narrows),
-                    mean,
-                    stddev);
+            outp("%lf;%lf;%lf;%lf\n",
+                    sweep.asl[i],
+                    getScoreBySkillLevel(sweep.asl[i], face, dist, narrows),
+                    sweep.mean[i],
+                    sweep.stddev[i]);
         }
     }
 
+    for (w = 0; w < n_workers; w++) {
+        free(sweep.worker[w]);
+    }
+    free(sweep.worker);
+    free(sweep.asl);
+    free(sweep.mean);
+    free(sweep.stddev);
+
     outp_close();
 } /*}}}2*/
 
+/* --- Internals {{{1*/
+
+static void doASLLevel(void *arg, int worker, int task) /*{{{2*/
+/*
+ * Pool task simulating q_nruns scores of skill level task of the sweep
+ */
+{
+    ASLSweep *sweep = arg;
+    SimulationContext *ctx = sweep->worker[worker];
+    const Face *face = getContextFace(ctx, ctx->q_format.facetype);
+    const double dist = ctx->q_format.distance;
+    const int narrows = ctx->q_format.narrows;
+    const double asl = sweep->asl[task];
+    ScoreTable *table = getScoreTable(asl, face, dist);
+    Score scores[ASL_BATCH];
+    int n, j, k;
+    double mean;
+    double m2;
+    double delta;
+    double x;
 
+    setContextRun(ctx, (uint64_t)task);
+
+    n = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    for (j = 0; j < q_nruns; j += ASL_BATCH) {
+        int batch = (q_nruns-j < ASL_BATCH) ? q_nruns-j : ASL_BATCH;
+
+        getArcherScores(&ctx->rs, table, asl, face, dist, narrows, scores, batch);
+        for (k = 0; k < batch; k++) {
+            x = SCORE_TO_DOUBLE(scores[k]);
+            /* Compute mean and variance */
+            n++;
+            delta = x - mean;
+            mean += delta/n;
+            m2 += delta*(x-mean);
+        }
+    }
+    sweep->mean[task] = mean;
+    sweep->stddev[task] = sqrt(m2/(n-1.0));
+
+    addProgress(q_nruns, (long)q_nruns*narrows);
+} /*}}}2*/
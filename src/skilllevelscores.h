@@ -30,6 +30,8 @@
 
 /* --- Interface {{{1 */
 
-void ASLSimulation(void);
+struct SimulationContext;
+
+void ASLSimulation(struct SimulationContext *ctx);
 
 #endif
@@ -33,32 +33,96 @@
 
 /* --- Local prototypes {{{1*/
 
+static void addCompensated(double *sum, double *c, double value);
+
 /* --- Implementation {{{1*/
 
 void resetStat(Stat *stat) /*{{{2*/
 {
     stat->n     = 0;
+    stat->val   = 0.0;
     stat->avg   = 0.0;
+    stat->avg_c = 0.0;
     stat->var   = 0.0;
-    stat->stdev = 0.0;
-}
+    stat->var_c = 0.0;
+} /*}}}2*/
 
 void addStat(Stat *stat, double value) /*{{{2*/
 {
+    double delta;
+
     stat->n = stat->n + 1;
+    stat->val = value;
 
     if (stat->n == 1) {
         /* First entry */
-        stat->avg = value;
-        stat->var = 0.0;
+        stat->avg   = value;
+        stat->avg_c = 0.0;
+        stat->var   = 0.0;
+        stat->var_c = 0.0;
     }
     else {
         /* Subsequent entries */
-        stat->avg   = stat->avg + (value - stat->avg) / stat->n;
-        stat->var   = stat->var + (value - stat->avg) * (value - stat->avg);
+        delta = value - getMean(stat);
+        addCompensated(&stat->avg, &stat->avg_c, delta / stat->n);
+        addCompensated(&stat->var, &stat->var_c, delta * (value - getMean(stat)));
     }
-    stat->stdev = sqrt(stat->var/stat->n);
 } /*}}}2*/
 
+void combineStat(Stat *dst, const Stat *src) /*{{{2*/
+/*
+ * Adds the values of src to dst, as if every value added to src had been
+ * added to dst (pairwise update of Chan et al.), where;
+ * dst = statistic to update
+ * src = statistic of the values to add
+ */
+{
+    long n = dst->n + src->n;
+    double delta;
+
+    if (src->n == 0) return;
+    if (dst->n == 0) {
+        *dst = *src;
+        return;
+    }
+
+    delta = getMean(src) - getMean(dst);
+    addCompensated(&dst->avg, &dst->avg_c, delta * src->n / n);
+    addCompensated(&dst->var, &dst->var_c, src->var - src->var_c);
+    addCompensated(&dst->var, &dst->var_c, delta * delta * ((double)dst->n * src->n / n));
+    dst->n   = n;
+    dst->val = src->val;
+} /*}}}2*/
+
+double getMean(const Stat *stat) /*{{{2*/
+/*
+ * Returns the mean of the values added (with the compensation of the sum)
+ */
+{
+    return stat->avg - stat->avg_c;
+} /*}}}2*/
 
+double getStdev(const Stat *stat) /*{{{2*/
+/*
+ * Returns the (population) standard deviation of the values added
+ */
+{
+    double m2 = stat->var - stat->var_c;
+
+    if (stat->n == 0 || m2 <= 0.0) return 0.0;
+    return sqrt(m2 / stat->n);
+} /*}}}2*/
 
+/* --- Internals {{{1*/
+
+static void addCompensated(double *sum, double *c, double value) /*{{{2*/
+/*
+ * Adds value to sum (Kahan summation), c keeps the low order part lost so far
+ */
+{
+    double y = value - *c;
+    double t = *sum + y;
+
+    *c   = (t - *sum) - y;
+    *sum = t;
+} /*}}}2*/
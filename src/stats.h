@@ -30,20 +30,26 @@
 
 /*
  * Keep a mean and variance of a statistical value in an updateable fashion
- * I.e. every timestep, K, Ex and Ex2 get updated and at the end,
- * mean and variance can be computed
+ * I.e. every value updates the mean and the sum of squared deviations from
+ * the mean (Welford), the standard deviation is computed when read. Both
+ * sums carry a compensation term (Kahan) so they keep their precision over
+ * very many values. Statistics of separate runs can be combined
  */
 typedef struct {
     long   n;                   /* Number of values                         */
     double val;                 /* Most recent value                        */
     double avg;                 /* Running mean/average of all values       */
-    double var;                 /* Running variance of all values           */
-    double stdev;               /* Running standard deviation of all values */
+    double avg_c;               /* Compensation (lost low order part) of avg*/
+    double var;                 /* Running sum of squared deviations        */
+    double var_c;               /* Compensation of var                      */
 } Stat;
 
 /* --- Interface {{{1 */
 
 void resetStat(Stat *stat);
 void addStat(Stat *stat, double value);
+void combineStat(Stat *dst, const Stat *src);
+double getMean(const Stat *stat);
+double getStdev(const Stat *stat);
 
 #endif
@@ -28,30 +28,28 @@
 #include "dump.h"
 #include "team.h"
 #include "archer.h"
+#include "context.h"
 
 /* --- Global data {{{1 */
 
-Team  team[16];
-Team *teamrank[16];
-
 extern int pretty_print;
 
 /* --- Local prototypes {{{1*/
 
 /* --- Implementation {{{1*/
 
-void setTeam(Team *team, double lvl[3]) /*{{{2*/
+void setTeam(const SimulationContext *ctx, Team *team, double lvl[3]) /*{{{2*/
 {
     int i;
 
-    setArcher(&(team->archer[0]), 1, lvl[0]);
-    setArcher(&(team->archer[1]), 2, lvl[1]);
-    setArcher(&(team->archer[2]), 3, lvl[2]);
+    setArcher(ctx, &(team->archer[0]), 1, lvl[0]);
+    setArcher(ctx, &(team->archer[1]), 2, lvl[1]);
+    setArcher(ctx, &(team->archer[2]), 3, lvl[2]);
     team->q_rank = 0;
     team->e_rank = 0;
 } /*}}}2*/
 
-void setTeams(double lvl_1[3], double lvl_8[3], double lvl_16[3]) /*{{{2*/
+void setTeams(SimulationContext *ctx, double lvl_1[3], double lvl_8[3], double lvl_16[3]) /*{{{2*/
 /*
  * Setup an array of teams with different skill levels
  * where;
@@ -59,7 +57,7 @@ void setTeams(double lvl_1[3], double lvl_8[3], double lvl_16[3]) /*{{{2*/
  * lvl_8    = array of level of archers of 8th ranked team
  * lvl_16   = array of level of archers of 16th ranked team
  *
- * Returns nothing, but fills the archers array
+ * Returns nothing, but fills the teams array of the context
  */
 {
     double lvl[3];
@@ -74,7 +72,7 @@ void setTeams(double lvl_1[3], double lvl_8[3], double lvl_16[3]) /*{{{2*/
         lvl[0] = lvl_1[0] - i*dlvl[0];
         lvl[1] = lvl_1[1] - i*dlvl[1];
         lvl[2] = lvl_1[2] - i*dlvl[2];
-        setTeam(&team[i], lvl);
+        setTeam(ctx, &ctx->team[i], lvl);
     }
 
     /* 9..16 */
@@ -85,11 +83,11 @@ void setTeams(double lvl_1[3], double lvl_8[3], double lvl_16[3]) /*{{{2*/
         lvl[0] = lvl_8[0] - (i-7)*dlvl[0];
         lvl[1] = lvl_8[1] - (i-7)*dlvl[1];
         lvl[2] = lvl_8[2] - (i-7)*dlvl[2];
-        setTeam(&team[i], lvl);
+        setTeam(ctx, &ctx->team[i], lvl);
     }
 } /*}}}2*/
 
-double getTeamScore(const Team *team) /*{{{2*/
+Score getTeamScore(const Team *team) /*{{{2*/
 {
     return team->archer[0].q_score + team->archer[1].q_score + team->archer[2].q_score;
 } /*}}}2*/
@@ -114,17 +112,17 @@ void dumpTeam(const Team *team) /*{{{2*/
 
     if (pretty_print) {
         outp("|   %3d  | %s |   %3d  |  %8.2lf (%6.1lf, %6.1lf, %6.1lf) |\n",
-                team->q_rank, ' ', team->e_rank, getTeamScore(team),
-                team->archer[0].q_score, team->archer[1].q_score, team->archer[2].q_score);
+                team->q_rank, ' ', team->e_rank, SCORE_TO_DOUBLE(getTeamScore(team)),
+                SCORE_TO_DOUBLE(team->archer[0].q_score), SCORE_TO_DOUBLE(team->archer[1].q_score), SCORE_TO_DOUBLE(team->archer[2].q_score));
     }
     else {
         outp("%d;\"%s\";%d;%lf;%lf;%lf;%lf\n",
-               team->q_rank, ' ', team->e_rank, getTeamScore(team),
-               team->archer[0].q_score, team->archer[1].q_score, team->archer[2].q_score);
+               team->q_rank, ' ', team->e_rank, SCORE_TO_DOUBLE(getTeamScore(team)),
+               SCORE_TO_DOUBLE(team->archer[0].q_score), SCORE_TO_DOUBLE(team->archer[1].q_score), SCORE_TO_DOUBLE(team->archer[2].q_score));
     }
 } /*}}}2*/
 
-void rankTeams(int from_rank, int to_rank) /*{{{2*/
+void rankTeams(SimulationContext *ctx, int from_rank, int to_rank) /*{{{2*/
 {
     int i, j;
     int start_idx = from_rank-1;
@@ -136,16 +134,16 @@ void rankTeams(int from_rank, int to_rank) /*{{{2*/
         max = NULL;
         for (j = i; j <= end_idx; j++) {
             if ( (max == NULL) ||
-                 (getTeamScore(teamrank[j]) > getTeamScore(max)) )
+                 (getTeamScore(ctx->teamrank[j]) > getTeamScore(max)) )
             {
-                max = teamrank[j];
+                max = ctx->teamrank[j];
                 j_found = j;
             }
         }
         /* swap */
-        tmp = teamrank[i];
-        teamrank[i] = max;
-        teamrank[j_found] = tmp;
+        tmp = ctx->teamrank[i];
+        ctx->teamrank[i] = max;
+        ctx->teamrank[j_found] = tmp;
     }
 } /*}}}2*/
 
@@ -38,13 +38,15 @@ typedef struct {
 
 /* --- Interface {{{1 */
 
-extern Team  team[];
-extern Team* teamrank[];
-
-void setTeam(Team *team, double *lvls);
-void setTeams(double lvl_1[3], double lvl_8[3], double lvl_16[3]);
-double getTeamScore(const Team *team);
-void rankTeams(int from_rank, int to_rank);
+/*
+ * The teams and their ranking are part of the simulation (context.h)
+ */
+struct SimulationContext;
+
+void setTeam(const struct SimulationContext *ctx, Team *team, double *lvls);
+void setTeams(struct SimulationContext *ctx, double lvl_1[3], double lvl_8[3], double lvl_16[3]);
+Score getTeamScore(const Team *team);
+void rankTeams(struct SimulationContext *ctx, int from_rank, int to_rank);
 
 #endif
 